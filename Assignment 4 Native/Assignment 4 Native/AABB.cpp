@@ -0,0 +1,63 @@
+#include "AABB.h"
+
+
+AABB::AABB()
+	: lower( glm::vec2() )
+	, upper( glm::vec2() )
+{
+}
+
+
+AABB::AABB( glm::vec2 lower, glm::vec2 upper )
+	: lower( lower )
+	, upper( upper )
+{
+}
+
+
+glm::vec2 AABB::GetCenter()
+{
+	return 0.5f * ( lower + upper );
+}
+
+
+// Half the size of the box along each axis.
+glm::vec2 AABB::GetExtents()
+{
+	return 0.5f * ( upper - lower );
+}
+
+
+// The perimeter stands in for surface area when the DynamicTree decides where a new leaf should go.
+float AABB::GetPerimeter()
+{
+	return 2.0f * ( upper.x - lower.x + upper.y - lower.y );
+}
+
+
+// Returns a copy of this box grown by margin on every side.
+AABB AABB::Extend( float margin )
+{
+	return AABB( lower - glm::vec2( margin, margin ), upper + glm::vec2( margin, margin ) );
+}
+
+
+// Does this box fully enclose other?
+bool AABB::Contains( AABB other )
+{
+	return lower.x <= other.lower.x && lower.y <= other.lower.y && other.upper.x <= upper.x && other.upper.y <= upper.y;
+}
+
+
+// Do the two boxes overlap? Touching counts, because SAT counts touching Polygons as colliding.
+bool AABB::Overlaps( AABB other )
+{
+	return lower.x <= other.upper.x && lower.y <= other.upper.y && other.lower.x <= upper.x && other.lower.y <= upper.y;
+}
+
+
+// Returns the smallest box enclosing both a and b.
+AABB AABB::Combine( AABB a, AABB b )
+{
+	return AABB( glm::min( a.lower, b.lower ), glm::max( a.upper, b.upper ) );
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <glm.hpp>
+
+// Axis-aligned bounding box, used by the broadphase to cheaply rule out pairs of Polygons (and later
+// rays and queries) before any of the real SAT math runs.
+struct AABB
+{
+	glm::vec2 lower;
+	glm::vec2 upper;
+
+	AABB();
+	AABB( glm::vec2 lower, glm::vec2 upper );
+
+	glm::vec2 GetCenter();
+	glm::vec2 GetExtents();
+	float GetPerimeter();
+	AABB Extend( float margin );
+
+	bool Contains( AABB other );
+	bool Overlaps( AABB other );
+
+	static AABB Combine( AABB a, AABB b );
+};
@@ -0,0 +1,143 @@
+#include "AllocationCounter.h"
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+// With PHYSICS_ALLOCATION_CHECK defined the replacements below route every operator new in the DLL 
+// through here. Besides counting they behave exactly like the standard ones. Without it the standard 
+// operators are left alone and the count stays at zero.
+static thread_local unsigned long long allocationCount = 0;
+
+
+// AllocationCounter
+
+bool AllocationCounter::GetIsCompiledIn()
+{
+#ifdef PHYSICS_ALLOCATION_CHECK
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+unsigned long long AllocationCounter::GetCount()
+{
+	return allocationCount;
+}
+
+
+
+#ifdef PHYSICS_ALLOCATION_CHECK
+
+// Global operator new / delete
+
+void* operator new( size_t bytes )
+{
+	allocationCount++;
+	void* memory = std::malloc( bytes == 0 ? 1 : bytes );
+	if( memory == NULL )
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+
+void* operator new[]( size_t bytes )
+{
+	return operator new( bytes );
+}
+
+
+void operator delete( void* memory ) noexcept
+{
+	std::free( memory );
+}
+
+
+void operator delete[]( void* memory ) noexcept
+{
+	std::free( memory );
+}
+
+
+void operator delete( void* memory, size_t ) noexcept
+{
+	std::free( memory );
+}
+
+
+void operator delete[]( void* memory, size_t ) noexcept
+{
+	std::free( memory );
+}
+
+
+
+#ifdef __cpp_aligned_new
+
+// Global aligned operator new / delete (C++17, used for over-aligned types)
+
+void* operator new( size_t bytes, std::align_val_t alignment )
+{
+	allocationCount++;
+	if( bytes == 0 )
+	{
+		bytes = 1;
+	}
+#ifdef _WIN32
+	void* memory = _aligned_malloc( bytes, static_cast<size_t>( alignment ) );
+#else
+	void* memory = NULL;
+	if( posix_memalign( &memory, static_cast<size_t>( alignment ), bytes ) != 0 )
+	{
+		memory = NULL;
+	}
+#endif
+	if( memory == NULL )
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+
+void* operator new[]( size_t bytes, std::align_val_t alignment )
+{
+	return operator new( bytes, alignment );
+}
+
+
+void operator delete( void* memory, std::align_val_t ) noexcept
+{
+#ifdef _WIN32
+	_aligned_free( memory );
+#else
+	std::free( memory );
+#endif
+}
+
+
+void operator delete[]( void* memory, std::align_val_t alignment ) noexcept
+{
+	operator delete( memory, alignment );
+}
+
+
+void operator delete( void* memory, size_t, std::align_val_t alignment ) noexcept
+{
+	operator delete( memory, alignment );
+}
+
+
+void operator delete[]( void* memory, size_t, std::align_val_t alignment ) noexcept
+{
+	operator delete( memory, alignment );
+}
+
+#endif
+
+#endif
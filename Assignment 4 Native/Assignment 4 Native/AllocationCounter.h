@@ -0,0 +1,12 @@
+#pragma once
+// Counts the heap allocations (operator new) made on the calling thread, so the World can check that
+// a step didn't allocate. The count is per thread so other threads using the DLL (a host's loading
+// thread, RaycastBatch()'s workers) don't show up in a step running on this one.
+// Counting means replacing the global operator new / delete, so it's only compiled in when
+// PHYSICS_ALLOCATION_CHECK is defined (the Debug configurations define it).
+class AllocationCounter
+{
+	public:
+	static bool GetIsCompiledIn();
+	static unsigned long long GetCount();
+};
@@ -1,5 +1,6 @@
 #include "Collision.h"
 #include "Polygon.h"
+#include "Fixed.h"
 
 
 Collision::Collision()
@@ -8,26 +9,31 @@ Collision::Collision()
 	, faceNormal( glm::vec2() )
 	, contactVertex( glm::vec2() )
 	, depth( -FLT_MAX )
+	, impulse( 0.0f )
 {
 }
 
 
+// The signed impulse along faceNormal that reverses how fast the contact points are closing (spin 
+// included), scaled by the restitution. Negative while they are closing. Static and kinematic 
+// Polygons have cached inverses of 0, so they count as infinitely heavy and are never divided by.
 float Collision::GetAngularMomentum()
 {
 	float restitution = 1.0f;
 
-	glm::vec2 relativeVelocity = facePolygon->GetVelocity() - contactPolygon->GetVelocity();
-	float relativeVelocityAlongNormal = glm::dot( faceNormal, relativeVelocity );
+	float aInverseMass = facePolygon->GetInverseMass();
+	float bInverseMass = contactPolygon->GetInverseMass();
 
-	float aInverseMass = 1.0f / facePolygon->GetMass();
-	float bInverseMass = 1.0f / contactPolygon->GetMass();
-
-	float aInverseRotationalInertia = 1.0f / facePolygon->GetRotationalInertia();
-	float bInverseRotationalInertia = 1.0f / contactPolygon->GetRotationalInertia();
+	float aInverseRotationalInertia = facePolygon->GetInverseRotationalInertia();
+	float bInverseRotationalInertia = contactPolygon->GetInverseRotationalInertia();
 
 	glm::vec3 aCenterOfMassToContact = glm::vec3( contactVertex - facePolygon->GetPosition(), 0.0f );
 	glm::vec3 bCenterOfMassToContact = glm::vec3( contactVertex - contactPolygon->GetPosition(), 0.0f );
 
+	glm::vec2 aVelocity = facePolygon->GetVelocity() + glm::vec2( glm::cross( glm::vec3( 0.0f, 0.0f, facePolygon->GetRotationalVelocity() ), aCenterOfMassToContact ) );
+	glm::vec2 bVelocity = contactPolygon->GetVelocity() + glm::vec2( glm::cross( glm::vec3( 0.0f, 0.0f, contactPolygon->GetRotationalVelocity() ), bCenterOfMassToContact ) );
+	float relativeVelocityAlongNormal = glm::dot( faceNormal, aVelocity - bVelocity );
+
 	glm::vec3 normal = glm::vec3( faceNormal, 0.0f );
 	glm::vec3 aRxN = glm::cross( aCenterOfMassToContact, normal );
 	glm::vec3 bRxN = glm::cross( bCenterOfMassToContact, normal );
@@ -41,7 +47,51 @@ float Collision::GetAngularMomentum()
 	float numerator = -( relativeVelocityAlongNormal * ( restitution + 1.0f ) );
 	float denominator = ( aInverseMass + bInverseMass + aRotationalInertiaTerm + bRotationalInertiaTerm );
 
-	float angularMomentum = numerator / denominator;
+	float angularMomentum = denominator > 0.0f ? numerator / denominator : 0.0f;
 
 	return angularMomentum;
 }
+
+
+// GetAngularMomentum() done in Fixed math for deterministic mode. The 3D cross products collapse to
+// their 2D equivalents because every vector involved lies in the xy-plane.
+Fixed Collision::GetAngularMomentumFixed()
+{
+	Fixed restitution = Fixed( 1 );
+	FixedVector2 normal = FixedVector2( faceNormal );
+	FixedVector2 contact = FixedVector2( contactVertex );
+
+	// The cached inverses are plain IEEE divisions, so they come out the same everywhere as well.
+	Fixed aInverseMass = Fixed::FromFloat( facePolygon->GetInverseMass() );
+	Fixed bInverseMass = Fixed::FromFloat( contactPolygon->GetInverseMass() );
+
+	Fixed aInverseRotationalInertia = Fixed::FromFloat( facePolygon->GetInverseRotationalInertia() );
+	Fixed bInverseRotationalInertia = Fixed::FromFloat( contactPolygon->GetInverseRotationalInertia() );
+
+	FixedVector2 aCenterOfMassToContact = contact - FixedVector2( facePolygon->GetPosition() );
+	FixedVector2 bCenterOfMassToContact = contact - FixedVector2( contactPolygon->GetPosition() );
+
+	Fixed aSpin = Fixed::FromFloat( facePolygon->GetRotationalVelocity() );
+	Fixed bSpin = Fixed::FromFloat( contactPolygon->GetRotationalVelocity() );
+	FixedVector2 aVelocity = FixedVector2( facePolygon->GetVelocity() ) + FixedVector2( -aSpin * aCenterOfMassToContact.y, aSpin * aCenterOfMassToContact.x );
+	FixedVector2 bVelocity = FixedVector2( contactPolygon->GetVelocity() ) + FixedVector2( -bSpin * bCenterOfMassToContact.y, bSpin * bCenterOfMassToContact.x );
+	Fixed relativeVelocityAlongNormal = FixedVector2::Dot( normal, aVelocity - bVelocity );
+
+	Fixed aRxN = FixedVector2::Cross( aCenterOfMassToContact, normal );
+	Fixed bRxN = FixedVector2::Cross( bCenterOfMassToContact, normal );
+
+	FixedVector2 aRxNxR = FixedVector2( -aRxN * aCenterOfMassToContact.y, aRxN * aCenterOfMassToContact.x );
+	FixedVector2 bRxNxR = FixedVector2( -bRxN * bCenterOfMassToContact.y, bRxN * bCenterOfMassToContact.x );
+
+	Fixed aRotationalInertiaTerm = FixedVector2::Dot( normal, aRxNxR * aInverseRotationalInertia );
+	Fixed bRotationalInertiaTerm = FixedVector2::Dot( normal, bRxNxR * bInverseRotationalInertia );
+
+	Fixed numerator = -( relativeVelocityAlongNormal * ( restitution + Fixed( 1 ) ) );
+	Fixed denominator = aInverseMass + bInverseMass + aRotationalInertiaTerm + bRotationalInertiaTerm;
+	if( denominator <= Fixed() )
+	{
+		return Fixed();
+	}
+
+	return numerator / denominator;
+}
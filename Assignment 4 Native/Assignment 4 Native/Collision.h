@@ -2,6 +2,7 @@
 #include <glm.hpp>
 
 class Face;
+class Fixed;
 class Polygon;
 
 struct Collision
@@ -11,8 +12,10 @@ struct Collision
 	glm::vec2 faceNormal;
 	glm::vec2 contactVertex;
 	float depth;
+	float impulse;
 
 	Collision();
 
 	float GetAngularMomentum();
+	Fixed GetAngularMomentumFixed();
 };
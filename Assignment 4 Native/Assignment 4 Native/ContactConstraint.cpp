@@ -0,0 +1,143 @@
+#include "ContactConstraint.h"
+#include "Collision.h"
+#include "Polygon.h"
+#include <algorithm>
+
+
+// The z-component of the 3D cross product of ( a, 0 ) and ( b, 0 ).
+static float Cross( glm::vec2 a, glm::vec2 b )
+{
+	return a.x * b.y - a.y * b.x;
+}
+
+// The cross product of ( 0, 0, w ) and ( r, 0 ): the velocity of point r on a body spinning at w.
+static glm::vec2 Cross( float w, glm::vec2 r )
+{
+	return glm::vec2( -w * r.y, w * r.x );
+}
+
+ContactConstraint::ContactConstraint( Collision collision )
+	: aPolygon( collision.facePolygon )
+	, bPolygon( collision.contactPolygon )
+	, normal( collision.faceNormal )
+	, aAnchor( collision.contactVertex - collision.facePolygon->GetPosition() )
+	, bAnchor( collision.contactVertex - collision.contactPolygon->GetPosition() )
+	, aInverseMass( aPolygon->GetInverseMass() )
+	, bInverseMass( bPolygon->GetInverseMass() )
+	, aInverseRotationalInertia( aPolygon->GetInverseRotationalInertia() )
+	, bInverseRotationalInertia( bPolygon->GetInverseRotationalInertia() )
+	, separation( collision.depth )
+	, normalMass( 0.0f )
+	, relativeVelocity( 0.0f )
+	, normalImpulse( 0.0f )
+	, maxNormalImpulse( 0.0f )
+{
+	float aRxN = Cross( aAnchor, normal );
+	float bRxN = Cross( bAnchor, normal );
+	float effectiveInverseMass = aInverseMass + bInverseMass + aInverseRotationalInertia * aRxN * aRxN + bInverseRotationalInertia * bRxN * bRxN;
+	normalMass = effectiveInverseMass > 0.0f ? 1.0f / effectiveInverseMass : 0.0f;
+	relativeVelocity = GetNormalVelocity();
+}
+
+
+// The separation at the start of the step, plus how far the anchors have since moved apart along 
+// the normal. Negative means the Polygons overlap.
+float ContactConstraint::GetSeparation()
+{
+	glm::vec2 aDelta = aPolygon->__position - aPolygon->__previousPosition + Cross( aPolygon->__rotation - aPolygon->__previousRotation, aAnchor );
+	glm::vec2 bDelta = bPolygon->__position - bPolygon->__previousPosition + Cross( bPolygon->__rotation - bPolygon->__previousRotation, bAnchor );
+	return separation + glm::dot( bDelta - aDelta, normal );
+}
+
+// The speed the contact points are moving apart along the normal.
+float ContactConstraint::GetNormalVelocity()
+{
+	glm::vec2 aVelocity = aPolygon->__velocity + Cross( aPolygon->__rotationalVelocity, aAnchor );
+	glm::vec2 bVelocity = bPolygon->__velocity + Cross( bPolygon->__rotationalVelocity, bAnchor );
+	return glm::dot( bVelocity - aVelocity, normal );
+}
+
+// Push the Polygons apart along the normal (a gets -impulse, b gets +impulse).
+void ContactConstraint::ApplyImpulse( float impulse )
+{
+	glm::vec2 linearImpulse = impulse * normal;
+	aPolygon->__velocity -= aInverseMass * linearImpulse;
+	aPolygon->__rotationalVelocity -= aInverseRotationalInertia * Cross( aAnchor, linearImpulse );
+	bPolygon->__velocity += bInverseMass * linearImpulse;
+	bPolygon->__rotationalVelocity += bInverseRotationalInertia * Cross( bAnchor, linearImpulse );
+}
+
+
+// Re-apply the impulse accumulated so far this step at the start of each sub-step, so the solver 
+// only has to correct it rather than rebuild it from nothing.
+void ContactConstraint::WarmStart()
+{
+	ApplyImpulse( normalImpulse );
+}
+
+// One velocity iteration. With useBias the contact is a soft spring (biasRate, massScale and 
+// impulseScale come from its stiffness) pushing overlapping Polygons apart no faster than 
+// maxBiasVelocity; without it (the relax pass) only the velocity error is removed, so the push-out
+// doesn't linger as extra energy. Contacts that haven't closed yet are speculative: they only stop
+// the Polygons from closing the gap within this sub-step.
+void ContactConstraint::Solve( float inverseSubstepSeconds, float biasRate, float massScale, float impulseScale, float maxBiasVelocity, bool useBias )
+{
+	float currentSeparation = GetSeparation();
+	float bias = 0.0f;
+	if( currentSeparation > 0.0f )
+	{
+		bias = currentSeparation * inverseSubstepSeconds;
+		massScale = 1.0f;
+		impulseScale = 0.0f;
+	}
+	else if( useBias )
+	{
+		bias = std::max( biasRate * currentSeparation, -maxBiasVelocity );
+	}
+	else
+	{
+		massScale = 1.0f;
+		impulseScale = 0.0f;
+	}
+
+	// Contacts can push but never pull, so clamp the total impulse rather than this iteration's.
+	float impulse = -normalMass * massScale * ( GetNormalVelocity() + bias ) - impulseScale * normalImpulse;
+	float newImpulse = std::max( normalImpulse + impulse, 0.0f );
+	impulse = newImpulse - normalImpulse;
+	normalImpulse = newImpulse;
+	maxNormalImpulse = std::max( maxNormalImpulse, impulse );
+	ApplyImpulse( impulse );
+}
+
+// Bounce contacts that closed faster than threshold, using the approach speed from before the step.
+// Slower (resting) contacts don't bounce, which is what lets stacks settle.
+void ContactConstraint::ApplyRestitution( float restitution, float threshold )
+{
+	if( relativeVelocity > -threshold || maxNormalImpulse == 0.0f )
+	{
+		return;
+	}
+
+	float impulse = -normalMass * ( GetNormalVelocity() + restitution * relativeVelocity );
+	float newImpulse = std::max( normalImpulse + impulse, 0.0f );
+	impulse = newImpulse - normalImpulse;
+	normalImpulse = newImpulse;
+	ApplyImpulse( impulse );
+}
+
+// One non-linear Gauss-Seidel iteration: move the Polygons themselves (not their velocities) to 
+// remove baumgarte of the overlap deeper than slop, at most maxCorrection at a time. Since velocity 
+// is untouched, the correction can't add energy. Returns the separation before the correction.
+float ContactConstraint::SolvePosition( float baumgarte, float slop, float maxCorrection )
+{
+	float currentSeparation = GetSeparation();
+	float correction = std::min( std::max( baumgarte * ( currentSeparation + slop ), -maxCorrection ), 0.0f );
+	glm::vec2 linearImpulse = -normalMass * correction * normal;
+
+	aPolygon->__position -= aInverseMass * linearImpulse;
+	aPolygon->__rotation -= aInverseRotationalInertia * Cross( aAnchor, linearImpulse );
+	bPolygon->__position += bInverseMass * linearImpulse;
+	bPolygon->__rotation += bInverseRotationalInertia * Cross( bAnchor, linearImpulse );
+
+	return currentSeparation;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <glm.hpp>
+
+struct Collision;
+class Polygon;
+
+// The float solvers' view of one Collision, built once per step and reused by every sub-step of the
+// soft contact solver and every iteration of the original solver's position correction.
+// Anchors are the contact point relative to each Polygon's center of mass at the start of the step,
+// and the current separation is estimated from how far the Polygons have moved since then, so the 
+// sub-steps never need to re-run the broadphase or SAT.
+struct ContactConstraint
+{
+	Polygon* aPolygon;
+	Polygon* bPolygon;
+	glm::vec2 normal;
+	glm::vec2 aAnchor;
+	glm::vec2 bAnchor;
+	float aInverseMass;
+	float bInverseMass;
+	float aInverseRotationalInertia;
+	float bInverseRotationalInertia;
+	float separation;
+	float normalMass;
+	float relativeVelocity;
+	float normalImpulse;
+	float maxNormalImpulse;
+
+	ContactConstraint( Collision collision );
+
+	float GetSeparation();
+	float GetNormalVelocity();
+	void ApplyImpulse( float impulse );
+
+	void WarmStart();
+	void Solve( float inverseSubstepSeconds, float biasRate, float massScale, float impulseScale, float maxBiasVelocity, bool useBias );
+	void ApplyRestitution( float restitution, float threshold );
+	float SolvePosition( float baumgarte, float slop, float maxCorrection );
+};
@@ -0,0 +1,26 @@
+#pragma once
+#include "POLYGON_HANDLE.c"
+#include "TransportVector2.c"
+
+// How a ContactEvent's pair of Polygons changed since the step before.
+enum ContactEventState
+{
+	CONTACT_BEGIN = 0,
+	CONTACT_PERSIST = 1,
+	CONTACT_END = 2
+};
+
+// C-style is important! No methods allowed because of __declspec( dllexport )!
+// One contact written out by WorldGetContacts(). normal points from aHandle toward bHandle, depth is
+// 0 or negative while they overlap and impulse is how hard the solver pushed them apart. Sensor
+// overlaps and CONTACT_END events only fill in the handles and state.
+struct ContactEvent
+{
+	POLYGON_HANDLE aHandle;
+	POLYGON_HANDLE bHandle;
+	struct TransportVector2 normal;
+	struct TransportVector2 point;
+	float depth;
+	float impulse;
+	int state;
+};
\ No newline at end of file
@@ -0,0 +1,501 @@
+#include "DynamicTree.h"
+#include <algorithm>
+
+// How far each proxy's fat box reaches past its Polygon. Bigger margins mean fewer tree updates for
+// moving Polygons but more pairs that make it through to SAT only to be rejected there.
+const float DynamicTree::AABB_MARGIN = 0.1f;
+
+
+// TreeNode
+
+bool TreeNode::IsLeaf()
+{
+	return child1 == DynamicTree::NULL_NODE;
+}
+
+
+
+// DynamicTree
+
+// A leaf waiting for BuildSubtree(), with the center of its box worked out once up front.
+struct BuildLeaf
+{
+	glm::vec2 center;
+	int nodeId;
+};
+
+
+// PRIVATE
+
+// Pops a node off the free list, doubling the node pool first if it is empty.
+int DynamicTree::AllocateNode()
+{
+	if( __freeList == NULL_NODE )
+	{
+		int capacity = (int)__nodes.size();
+		Reserve( capacity == 0 ? 16 : capacity * 2 );
+	}
+
+	int nodeId = __freeList;
+	TreeNode& node = __nodes[ nodeId ];
+	__freeList = node.parent;
+	node.aabb = AABB();
+	node.polygon = NULL;
+	node.category = 0;
+	node.mask = 0;
+	node.parent = NULL_NODE;
+	node.child1 = NULL_NODE;
+	node.child2 = NULL_NODE;
+	node.height = 0;
+	return nodeId;
+}
+
+// Pushes a node back onto the free list.
+void DynamicTree::FreeNode( int nodeId )
+{
+	__nodes[ nodeId ].parent = __freeList;
+	__nodes[ nodeId ].height = -1;
+	__freeList = nodeId;
+}
+
+// Walks down from the root picking whichever child grows the tree's total perimeter the least, pairs
+// the leaf up with the node it stops at under a new parent and then refits everything above it.
+void DynamicTree::InsertLeaf( int leafId )
+{
+	if( __root == NULL_NODE )
+	{
+		__root = leafId;
+		__nodes[ __root ].parent = NULL_NODE;
+		return;
+	}
+
+	AABB leafAABB = __nodes[ leafId ].aabb;
+	int index = __root;
+	while( !__nodes[ index ].IsLeaf() )
+	{
+		int child1 = __nodes[ index ].child1;
+		int child2 = __nodes[ index ].child2;
+
+		float area = __nodes[ index ].aabb.GetPerimeter();
+		float combinedArea = AABB::Combine( __nodes[ index ].aabb, leafAABB ).GetPerimeter();
+
+		// Cost of creating a new parent for this node and the new leaf.
+		float cost = 2.0f * combinedArea;
+
+		// Minimum cost of pushing the leaf further down the tree.
+		float inheritanceCost = 2.0f * ( combinedArea - area );
+
+		float cost1 = AABB::Combine( leafAABB, __nodes[ child1 ].aabb ).GetPerimeter() + inheritanceCost;
+		if( !__nodes[ child1 ].IsLeaf() )
+		{
+			cost1 -= __nodes[ child1 ].aabb.GetPerimeter();
+		}
+		float cost2 = AABB::Combine( leafAABB, __nodes[ child2 ].aabb ).GetPerimeter() + inheritanceCost;
+		if( !__nodes[ child2 ].IsLeaf() )
+		{
+			cost2 -= __nodes[ child2 ].aabb.GetPerimeter();
+		}
+
+		if( cost < cost1 && cost < cost2 )
+		{
+			break;
+		}
+		index = cost1 < cost2 ? child1 : child2;
+	}
+
+	// Give the sibling and the leaf a new parent. AllocateNode() can grow __nodes, so only indices are
+	// held across it.
+	int siblingId = index;
+	int oldParentId = __nodes[ siblingId ].parent;
+	int newParentId = AllocateNode();
+	__nodes[ newParentId ].parent = oldParentId;
+	__nodes[ newParentId ].aabb = AABB::Combine( leafAABB, __nodes[ siblingId ].aabb );
+	__nodes[ newParentId ].height = __nodes[ siblingId ].height + 1;
+	__nodes[ newParentId ].child1 = siblingId;
+	__nodes[ newParentId ].child2 = leafId;
+	__nodes[ siblingId ].parent = newParentId;
+	__nodes[ leafId ].parent = newParentId;
+
+	if( oldParentId == NULL_NODE )
+	{
+		__root = newParentId;
+	}
+	else if( __nodes[ oldParentId ].child1 == siblingId )
+	{
+		__nodes[ oldParentId ].child1 = newParentId;
+	}
+	else
+	{
+		__nodes[ oldParentId ].child2 = newParentId;
+	}
+
+	// Walk back up, rebalancing and refitting boxes and heights.
+	index = __nodes[ leafId ].parent;
+	while( index != NULL_NODE )
+	{
+		index = Balance( index );
+		TreeNode& node = __nodes[ index ];
+		node.height = 1 + std::max( __nodes[ node.child1 ].height, __nodes[ node.child2 ].height );
+		node.aabb = AABB::Combine( __nodes[ node.child1 ].aabb, __nodes[ node.child2 ].aabb );
+		index = node.parent;
+	}
+}
+
+// Builds a subtree over count leaves that aren't in the tree yet and returns its root. The leaves are
+// split in half at the median of their centers along whichever axis the centers spread out the most,
+// and each half is built the same way, so the subtree comes out balanced without any rotations.
+// Reorders leaves.
+int DynamicTree::BuildSubtree( BuildLeaf* leaves, int count )
+{
+	if( count == 1 )
+	{
+		return leaves[ 0 ].nodeId;
+	}
+
+	glm::vec2 lower = leaves[ 0 ].center;
+	glm::vec2 upper = lower;
+	for( int i = 1; i < count; i++ )
+	{
+		lower = glm::min( lower, leaves[ i ].center );
+		upper = glm::max( upper, leaves[ i ].center );
+	}
+	int axis = upper.x - lower.x >= upper.y - lower.y ? 0 : 1;
+
+	int half = count / 2;
+	auto isLower = [axis]( const BuildLeaf& a, const BuildLeaf& b )
+	{
+		return a.center[ axis ] < b.center[ axis ];
+	};
+	std::nth_element( leaves, leaves + half, leaves + count, isLower );
+
+	int child1 = BuildSubtree( leaves, half );
+	int child2 = BuildSubtree( leaves + half, count - half );
+
+	int parentId = AllocateNode();
+	TreeNode& parent = __nodes[ parentId ];
+	parent.aabb = AABB::Combine( __nodes[ child1 ].aabb, __nodes[ child2 ].aabb );
+	parent.height = 1 + std::max( __nodes[ child1 ].height, __nodes[ child2 ].height );
+	parent.child1 = child1;
+	parent.child2 = child2;
+	__nodes[ child1 ].parent = parentId;
+	__nodes[ child2 ].parent = parentId;
+	return parentId;
+}
+
+// Unhooks a leaf by replacing its parent with its sibling and then refits everything above it.
+void DynamicTree::RemoveLeaf( int leafId )
+{
+	if( leafId == __root )
+	{
+		__root = NULL_NODE;
+		return;
+	}
+
+	int parentId = __nodes[ leafId ].parent;
+	int grandParentId = __nodes[ parentId ].parent;
+	int siblingId = __nodes[ parentId ].child1 == leafId ? __nodes[ parentId ].child2 : __nodes[ parentId ].child1;
+
+	if( grandParentId == NULL_NODE )
+	{
+		__root = siblingId;
+		__nodes[ siblingId ].parent = NULL_NODE;
+		FreeNode( parentId );
+		return;
+	}
+
+	if( __nodes[ grandParentId ].child1 == parentId )
+	{
+		__nodes[ grandParentId ].child1 = siblingId;
+	}
+	else
+	{
+		__nodes[ grandParentId ].child2 = siblingId;
+	}
+	__nodes[ siblingId ].parent = grandParentId;
+	FreeNode( parentId );
+
+	int index = grandParentId;
+	while( index != NULL_NODE )
+	{
+		index = Balance( index );
+		TreeNode& node = __nodes[ index ];
+		node.height = 1 + std::max( __nodes[ node.child1 ].height, __nodes[ node.child2 ].height );
+		node.aabb = AABB::Combine( __nodes[ node.child1 ].aabb, __nodes[ node.child2 ].aabb );
+		index = node.parent;
+	}
+}
+
+// If the subtrees under node A differ in height by more than one, rotate its taller child up into A's
+// place. That child keeps its own taller child and hands the shorter one down to A. Returns the index
+// of the subtree's new root.
+int DynamicTree::Balance( int aId )
+{
+	TreeNode& a = __nodes[ aId ];
+	if( a.IsLeaf() || a.height < 2 )
+	{
+		return aId;
+	}
+
+	int bId = a.child1;
+	int cId = a.child2;
+	TreeNode& b = __nodes[ bId ];
+	TreeNode& c = __nodes[ cId ];
+	int balance = c.height - b.height;
+
+	// Rotate C up.
+	if( balance > 1 )
+	{
+		int fId = c.child1;
+		int gId = c.child2;
+		TreeNode& f = __nodes[ fId ];
+		TreeNode& g = __nodes[ gId ];
+
+		c.child1 = aId;
+		c.parent = a.parent;
+		a.parent = cId;
+
+		if( c.parent == NULL_NODE )
+		{
+			__root = cId;
+		}
+		else if( __nodes[ c.parent ].child1 == aId )
+		{
+			__nodes[ c.parent ].child1 = cId;
+		}
+		else
+		{
+			__nodes[ c.parent ].child2 = cId;
+		}
+
+		if( f.height > g.height )
+		{
+			c.child2 = fId;
+			a.child2 = gId;
+			g.parent = aId;
+			a.aabb = AABB::Combine( b.aabb, g.aabb );
+			c.aabb = AABB::Combine( a.aabb, f.aabb );
+			a.height = 1 + std::max( b.height, g.height );
+			c.height = 1 + std::max( a.height, f.height );
+		}
+		else
+		{
+			c.child2 = gId;
+			a.child2 = fId;
+			f.parent = aId;
+			a.aabb = AABB::Combine( b.aabb, f.aabb );
+			c.aabb = AABB::Combine( a.aabb, g.aabb );
+			a.height = 1 + std::max( b.height, f.height );
+			c.height = 1 + std::max( a.height, g.height );
+		}
+		return cId;
+	}
+
+	// Rotate B up.
+	if( balance < -1 )
+	{
+		int dId = b.child1;
+		int eId = b.child2;
+		TreeNode& d = __nodes[ dId ];
+		TreeNode& e = __nodes[ eId ];
+
+		b.child1 = aId;
+		b.parent = a.parent;
+		a.parent = bId;
+
+		if( b.parent == NULL_NODE )
+		{
+			__root = bId;
+		}
+		else if( __nodes[ b.parent ].child1 == aId )
+		{
+			__nodes[ b.parent ].child1 = bId;
+		}
+		else
+		{
+			__nodes[ b.parent ].child2 = bId;
+		}
+
+		if( d.height > e.height )
+		{
+			b.child2 = dId;
+			a.child1 = eId;
+			e.parent = aId;
+			a.aabb = AABB::Combine( c.aabb, e.aabb );
+			b.aabb = AABB::Combine( a.aabb, d.aabb );
+			a.height = 1 + std::max( c.height, e.height );
+			b.height = 1 + std::max( a.height, d.height );
+		}
+		else
+		{
+			b.child2 = eId;
+			a.child1 = dId;
+			d.parent = aId;
+			a.aabb = AABB::Combine( c.aabb, d.aabb );
+			b.aabb = AABB::Combine( a.aabb, e.aabb );
+			a.height = 1 + std::max( c.height, d.height );
+			b.height = 1 + std::max( a.height, e.height );
+		}
+		return bId;
+	}
+
+	return aId;
+}
+
+
+
+// PUBLIC
+
+DynamicTree::DynamicTree()
+	: __nodes( std::vector<TreeNode>() )
+	, __root( NULL_NODE )
+	, __freeList( NULL_NODE )
+{
+}
+
+
+DynamicTree::~DynamicTree()
+{
+}
+
+
+// Grows the node pool to nodeCount nodes (if it is smaller) and puts the new ones on the free list, 
+// so that many nodes can be allocated without the pool having to grow. A tree with n proxies uses
+// 2n - 1 nodes.
+void DynamicTree::Reserve( int nodeCount )
+{
+	int oldCapacity = (int)__nodes.size();
+	if( nodeCount <= oldCapacity )
+	{
+		return;
+	}
+
+	__nodes.resize( nodeCount );
+	for( int i = oldCapacity; i < nodeCount; i++ )
+	{
+		__nodes[ i ].parent = i + 1 < nodeCount ? i + 1 : __freeList;
+		__nodes[ i ].height = -1;
+	}
+	__freeList = oldCapacity;
+}
+
+
+// Adds a leaf for polygon with a fat copy of aabb and returns its proxy id.
+int DynamicTree::CreateProxy( AABB aabb, Polygon* polygon, unsigned int category, unsigned int mask )
+{
+	int proxyId = AllocateNode();
+	TreeNode& node = __nodes[ proxyId ];
+	node.aabb = aabb.Extend( AABB_MARGIN );
+	node.polygon = polygon;
+	node.category = category;
+	node.mask = mask;
+	InsertLeaf( proxyId );
+	return proxyId;
+}
+
+
+// CreateProxy() for count proxies at once, writing their ids to proxyIds. Rather than walking the
+// tree once per leaf, the new leaves are built into a subtree of their own (see BuildSubtree()) that
+// is then inserted like a single leaf, which is much faster for a whole level at a time and gives a 
+// better tree than inserting the leaves in whatever order they came in. proxyIds can't be NULL.
+void DynamicTree::CreateProxies( const ProxyInput* inputs, int count, int* proxyIds )
+{
+	if( count <= 0 )
+	{
+		return;
+	}
+
+	// Grow the pool once instead of doubling it along the way (count leaves and count - 1 parents).
+	int usedCount = 0;
+	for( TreeNode& node : __nodes )
+	{
+		usedCount += node.height >= 0 ? 1 : 0;
+	}
+	Reserve( usedCount + 2 * count );
+
+	for( int i = 0; i < count; i++ )
+	{
+		AABB aabb = inputs[ i ].aabb;
+		int proxyId = AllocateNode();
+		TreeNode& node = __nodes[ proxyId ];
+		node.aabb = aabb.Extend( AABB_MARGIN );
+		node.polygon = inputs[ i ].polygon;
+		node.category = inputs[ i ].category;
+		node.mask = inputs[ i ].mask;
+		proxyIds[ i ] = proxyId;
+	}
+
+	std::vector<BuildLeaf> leaves( count );
+	for( int i = 0; i < count; i++ )
+	{
+		leaves[ i ].center = __nodes[ proxyIds[ i ] ].aabb.GetCenter();
+		leaves[ i ].nodeId = proxyIds[ i ];
+	}
+	InsertLeaf( BuildSubtree( leaves.data(), count ) );
+}
+
+
+void DynamicTree::DestroyProxy( int proxyId )
+{
+	RemoveLeaf( proxyId );
+	FreeNode( proxyId );
+}
+
+
+// Re-inserts the proxy with a new fat box if aabb has escaped its current one. Returns whether the
+// tree had to change.
+bool DynamicTree::MoveProxy( int proxyId, AABB aabb )
+{
+	if( __nodes[ proxyId ].aabb.Contains( aabb ) )
+	{
+		return false;
+	}
+
+	RemoveLeaf( proxyId );
+	__nodes[ proxyId ].aabb = aabb.Extend( AABB_MARGIN );
+	InsertLeaf( proxyId );
+	return true;
+}
+
+
+void DynamicTree::SetProxyFilter( int proxyId, unsigned int category, unsigned int mask )
+{
+	__nodes[ proxyId ].category = category;
+	__nodes[ proxyId ].mask = mask;
+}
+
+
+Polygon* DynamicTree::GetPolygon( int proxyId )
+{
+	return __nodes[ proxyId ].polygon;
+}
+
+
+AABB DynamicTree::GetFatAABB( int proxyId )
+{
+	return __nodes[ proxyId ].aabb;
+}
+
+
+unsigned int DynamicTree::GetCategory( int proxyId )
+{
+	return __nodes[ proxyId ].category;
+}
+
+
+unsigned int DynamicTree::GetMask( int proxyId )
+{
+	return __nodes[ proxyId ].mask;
+}
+
+
+int DynamicTree::GetHeight()
+{
+	return __root == NULL_NODE ? 0 : __nodes[ __root ].height;
+}
+
+
+// Two proxies may collide only if each one's category is in the other's mask.
+bool DynamicTree::ShouldCollide( unsigned int aCategory, unsigned int aMask, unsigned int bCategory, unsigned int bMask )
+{
+	return ( aCategory & bMask ) != 0 && ( bCategory & aMask ) != 0;
+}
@@ -0,0 +1,233 @@
+#pragma once
+#include <exception>
+#include <vector>
+#include "AABB.h"
+#include "RayPacket.h"
+
+class Polygon;
+struct BuildLeaf;
+
+// A single node of a DynamicTree. Leaves hold one Polygon each, along with its collision filter 
+// bits so pairs can be filtered without touching the Polygon. Internal nodes hold the union of 
+// their children's boxes.
+struct TreeNode
+{
+	AABB aabb;
+	Polygon* polygon;
+	unsigned int category;
+	unsigned int mask;
+	int parent; // Doubles as the next free node while the node is on the free list.
+	int child1;
+	int child2;
+	int height; // 0 for leaves, -1 for free nodes.
+
+	bool IsLeaf();
+};
+
+// One new proxy for DynamicTree::CreateProxies(), with the same meaning as the arguments of 
+// CreateProxy().
+struct ProxyInput
+{
+	AABB aabb;
+	Polygon* polygon;
+	unsigned int category;
+	unsigned int mask;
+};
+
+// Dynamic AABB tree broadphase (the same structure Box2D uses). Each Polygon gets a leaf (a proxy)
+// holding a "fat" box, grown by AABB_MARGIN, so small movements don't need the tree to be touched at 
+// all. Nodes live in one vector and refer to each other by index, and the tree is kept balanced with
+// rotations as leaves come and go, so queries cost O(log n) instead of visiting every Polygon.
+class DynamicTree
+{
+	private:
+
+	std::vector<TreeNode> __nodes;
+	int __root;
+	int __freeList;
+
+	int AllocateNode();
+	void FreeNode( int nodeId );
+
+	void InsertLeaf( int leafId );
+	void RemoveLeaf( int leafId );
+	int Balance( int nodeId );
+	int BuildSubtree( BuildLeaf* leaves, int count );
+
+	public:
+
+	static const int NULL_NODE = -1;
+	static const int QUERY_STACK_CAPACITY = 256;
+	static const float AABB_MARGIN;
+
+	DynamicTree();
+	~DynamicTree();
+
+	void Reserve( int nodeCount );
+
+	int CreateProxy( AABB aabb, Polygon* polygon, unsigned int category, unsigned int mask );
+	void CreateProxies( const ProxyInput* inputs, int count, int* proxyIds );
+	void DestroyProxy( int proxyId );
+	bool MoveProxy( int proxyId, AABB aabb );
+	void SetProxyFilter( int proxyId, unsigned int category, unsigned int mask );
+
+	Polygon* GetPolygon( int proxyId );
+	AABB GetFatAABB( int proxyId );
+	unsigned int GetCategory( int proxyId );
+	unsigned int GetMask( int proxyId );
+	int GetHeight();
+
+	static bool ShouldCollide( unsigned int aCategory, unsigned int aMask, unsigned int bCategory, unsigned int bMask );
+
+	// Calls callback( proxyId ) for every proxy whose fat box overlaps aabb, until callback returns 
+	// false. Walks the tree with a fixed-size stack so queries never allocate.
+	template<typename T>
+	void Query( AABB aabb, T& callback )
+	{
+		int stack[ QUERY_STACK_CAPACITY ];
+		int stackCount = 0;
+		stack[ stackCount++ ] = __root;
+
+		while( stackCount > 0 )
+		{
+			int nodeId = stack[ --stackCount ];
+			if( nodeId == NULL_NODE )
+			{
+				continue;
+			}
+
+			TreeNode& node = __nodes[ nodeId ];
+			if( !node.aabb.Overlaps( aabb ) )
+			{
+				continue;
+			}
+
+			if( node.IsLeaf() )
+			{
+				if( !callback( nodeId ) )
+				{
+					return;
+				}
+			}
+			else
+			{
+				if( stackCount + 2 > QUERY_STACK_CAPACITY )
+				{
+					throw std::exception( "DynamicTree is too deep to query!" );
+				}
+				stack[ stackCount++ ] = node.child1;
+				stack[ stackCount++ ] = node.child2;
+			}
+		}
+	}
+
+	// Calls callback( proxyId, maxFraction ) for every proxy whose fat box the segment from origin to
+	// origin + maxFraction * ( end - origin ) passes through. callback returns the new maxFraction: 
+	// return it unchanged to keep going, return a smaller one to clip the segment (the closest hit 
+	// so far) or return 0 to stop. Never allocates.
+	template<typename T>
+	void RayCast( glm::vec2 origin, glm::vec2 end, float maxFraction, T& callback )
+	{
+		glm::vec2 direction = end - origin;
+		if( direction.x == 0.0f && direction.y == 0.0f )
+		{
+			return;
+		}
+
+		// The segment's perpendicular, used as a separating axis against each box.
+		glm::vec2 perpendicular = glm::normalize( glm::vec2( -direction.y, direction.x ) );
+		glm::vec2 absPerpendicular = glm::abs( perpendicular );
+
+		glm::vec2 clippedEnd = origin + maxFraction * direction;
+		AABB segmentAABB = AABB( glm::min( origin, clippedEnd ), glm::max( origin, clippedEnd ) );
+
+		int stack[ QUERY_STACK_CAPACITY ];
+		int stackCount = 0;
+		stack[ stackCount++ ] = __root;
+
+		while( stackCount > 0 )
+		{
+			int nodeId = stack[ --stackCount ];
+			if( nodeId == NULL_NODE )
+			{
+				continue;
+			}
+
+			TreeNode& node = __nodes[ nodeId ];
+			if( !node.aabb.Overlaps( segmentAABB ) )
+			{
+				continue;
+			}
+
+			// The box's overlap test above only rules out boxes off the ends of the segment. This one
+			// rules out boxes off to its sides.
+			float separation = glm::abs( glm::dot( perpendicular, origin - node.aabb.GetCenter() ) ) - glm::dot( absPerpendicular, node.aabb.GetExtents() );
+			if( separation > 0.0f )
+			{
+				continue;
+			}
+
+			if( node.IsLeaf() )
+			{
+				maxFraction = callback( nodeId, maxFraction );
+				if( maxFraction == 0.0f )
+				{
+					return;
+				}
+				clippedEnd = origin + maxFraction * direction;
+				segmentAABB = AABB( glm::min( origin, clippedEnd ), glm::max( origin, clippedEnd ) );
+			}
+			else
+			{
+				if( stackCount + 2 > QUERY_STACK_CAPACITY )
+				{
+					throw std::exception( "DynamicTree is too deep to query!" );
+				}
+				stack[ stackCount++ ] = node.child1;
+				stack[ stackCount++ ] = node.child2;
+			}
+		}
+	}
+
+	// RayCast() for a whole RayPacket. Each box is tested against every ray in the packet at once and
+	// the walk only goes down into it if at least one of them passes through. Calls 
+	// callback( proxyId, laneHits ) at each leaf hit by any ray, with laneHits saying which ones; the
+	// callback clips rays by lowering their maxFraction in the packet. Never allocates.
+	template<typename T>
+	void RayCastPacket( RayPacket& packet, T& callback )
+	{
+		int laneHits[ RayPacket::SIZE ];
+		int stack[ QUERY_STACK_CAPACITY ];
+		int stackCount = 0;
+		stack[ stackCount++ ] = __root;
+
+		while( stackCount > 0 )
+		{
+			int nodeId = stack[ --stackCount ];
+			if( nodeId == NULL_NODE )
+			{
+				continue;
+			}
+
+			TreeNode& node = __nodes[ nodeId ];
+			if( !packet.TestAABB( node.aabb, laneHits ) )
+			{
+				continue;
+			}
+
+			if( node.IsLeaf() )
+			{
+				callback( nodeId, laneHits );
+			}
+			else
+			{
+				if( stackCount + 2 > QUERY_STACK_CAPACITY )
+				{
+					throw std::exception( "DynamicTree is too deep to query!" );
+				}
+				stack[ stackCount++ ] = node.child1;
+				stack[ stackCount++ ] = node.child2;
+			}
+		}
+	}
+};
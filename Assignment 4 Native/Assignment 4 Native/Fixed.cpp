@@ -0,0 +1,334 @@
+#include <cmath>
+#include "Fixed.h"
+
+// Sin() evaluates its series with 30 fractional bits so rounding in the intermediate terms doesn't
+// show up in the 16 fractional bits we actually return.
+static const int SERIES_FRACTION_BITS = 30;
+static const long long SERIES_ONE = 1LL << SERIES_FRACTION_BITS;
+
+// PI, PI / 2 and 2 * PI with 16 fractional bits.
+static const long long RAW_PI = 205887LL;
+static const long long RAW_HALF_PI = 102944LL;
+static const long long RAW_TWO_PI = 411775LL;
+
+
+// The full 128-bit product of a and b as high and low 64-bit halves, put together from four 32 x 32-bit
+// products so it comes out the same on every compiler (MSVC has no __int128).
+static void MultiplyWide( unsigned long long a, unsigned long long b, unsigned long long* high, unsigned long long* low )
+{
+	unsigned long long aLow = a & 0xFFFFFFFFULL;
+	unsigned long long aHigh = a >> 32;
+	unsigned long long bLow = b & 0xFFFFFFFFULL;
+	unsigned long long bHigh = b >> 32;
+
+	unsigned long long lowLow = aLow * bLow;
+	unsigned long long lowHigh = aLow * bHigh;
+	unsigned long long highLow = aHigh * bLow;
+	unsigned long long middle = ( lowLow >> 32 ) + ( lowHigh & 0xFFFFFFFFULL ) + ( highLow & 0xFFFFFFFFULL );
+
+	*low = ( middle << 32 ) | ( lowLow & 0xFFFFFFFFULL );
+	*high = aHigh * bHigh + ( lowHigh >> 32 ) + ( highLow >> 32 ) + ( middle >> 32 );
+}
+
+
+// Fixed
+
+Fixed::Fixed()
+	: __raw( 0 )
+{
+}
+
+
+Fixed::Fixed( int value )
+	: __raw( (long long)value * ONE )
+{
+}
+
+
+Fixed Fixed::FromRaw( long long raw )
+{
+	Fixed fixed;
+	fixed.__raw = raw;
+	return fixed;
+}
+
+
+// Scaling by a power of two is exact in double precision and floor() is exact too, so every build
+// quantizes the same float to the same Fixed.
+Fixed Fixed::FromFloat( float value )
+{
+	return FromRaw( (long long)std::floor( (double)value * ONE + 0.5 ) );
+}
+
+
+Fixed Fixed::Max()
+{
+	return FromRaw( 0x7FFFFFFFFFFFFFFFLL );
+}
+
+
+long long Fixed::GetRaw()
+{
+	return __raw;
+}
+
+
+float Fixed::ToFloat()
+{
+	return (float)( (double)__raw / ONE );
+}
+
+
+Fixed Fixed::operator-()
+{
+	return FromRaw( -__raw );
+}
+
+
+Fixed Fixed::operator+( Fixed other )
+{
+	return FromRaw( __raw + other.__raw );
+}
+
+
+Fixed Fixed::operator-( Fixed other )
+{
+	return FromRaw( __raw - other.__raw );
+}
+
+
+// The product is worked out in 128 bits, since two raw values multiplied together overflow 64 bits as
+// soon as it passes about 2^31. It rounds down like an arithmetic shift would, and products 
+// too big for a Fixed saturate the same way operator/() does.
+Fixed Fixed::operator*( Fixed other )
+{
+	bool isNegative = ( __raw < 0 ) != ( other.__raw < 0 );
+	unsigned long long a = __raw < 0 ? 0ULL - (unsigned long long)__raw : (unsigned long long)__raw;
+	unsigned long long b = other.__raw < 0 ? 0ULL - (unsigned long long)other.__raw : (unsigned long long)other.__raw;
+
+	unsigned long long high;
+	unsigned long long low;
+	MultiplyWide( a, b, &high, &low );
+	if( ( high >> ( 63 - ( 64 - FRACTION_BITS ) ) ) != 0 )
+	{
+		return isNegative ? -Max() : Max();
+	}
+
+	unsigned long long magnitude = ( high << ( 64 - FRACTION_BITS ) ) | ( low >> FRACTION_BITS );
+	if( isNegative && ( low & ( ONE - 1 ) ) != 0 )
+	{
+		magnitude++;
+	}
+	return FromRaw( isNegative ? -(long long)magnitude : (long long)magnitude );
+}
+
+
+// Division by zero saturates instead of trapping, the same way a float would head off to infinity.
+Fixed Fixed::operator/( Fixed other )
+{
+	if( other.__raw == 0 )
+	{
+		return __raw < 0 ? -Max() : Max();
+	}
+	return FromRaw( ( __raw * ONE ) / other.__raw );
+}
+
+
+Fixed& Fixed::operator+=( Fixed other )
+{
+	__raw += other.__raw;
+	return *this;
+}
+
+
+Fixed& Fixed::operator-=( Fixed other )
+{
+	__raw -= other.__raw;
+	return *this;
+}
+
+
+bool Fixed::operator<( Fixed other )
+{
+	return __raw < other.__raw;
+}
+
+
+bool Fixed::operator>( Fixed other )
+{
+	return __raw > other.__raw;
+}
+
+
+bool Fixed::operator<=( Fixed other )
+{
+	return __raw <= other.__raw;
+}
+
+
+bool Fixed::operator>=( Fixed other )
+{
+	return __raw >= other.__raw;
+}
+
+
+bool Fixed::operator==( Fixed other )
+{
+	return __raw == other.__raw;
+}
+
+
+// Bit-by-bit integer square root of the raw value shifted up by FRACTION_BITS (so the result keeps
+// its 16 fractional bits). Values too large to shift lose the bottom 8 bits of precision instead.
+Fixed Fixed::Sqrt( Fixed value )
+{
+	if( value.__raw <= 0 )
+	{
+		return Fixed();
+	}
+
+	bool isLarge = value.__raw >= ( 1LL << ( 63 - FRACTION_BITS ) );
+	unsigned long long remainder = isLarge ? (unsigned long long)value.__raw : (unsigned long long)value.__raw << FRACTION_BITS;
+	unsigned long long root = 0;
+	unsigned long long bit = 1ULL << 62;
+	while( bit > remainder )
+	{
+		bit >>= 2;
+	}
+	while( bit != 0 )
+	{
+		if( remainder >= root + bit )
+		{
+			remainder -= root + bit;
+			root = ( root >> 1 ) + bit;
+		}
+		else
+		{
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+
+	return FromRaw( isLarge ? (long long)( root << ( FRACTION_BITS / 2 ) ) : (long long)root );
+}
+
+
+// Reduces the angle to [-PI/2, PI/2] and evaluates the Taylor series up to x^11 in nested form:
+// x * ( 1 - x^2/6 * ( 1 - x^2/20 * ( 1 - x^2/42 * ( 1 - x^2/72 * ( 1 - x^2/110 ) ) ) ) ).
+Fixed Fixed::Sin( Fixed radians )
+{
+	long long x = radians.__raw % RAW_TWO_PI;
+	if( x > RAW_PI )
+	{
+		x -= RAW_TWO_PI;
+	}
+	else if( x < -RAW_PI )
+	{
+		x += RAW_TWO_PI;
+	}
+	if( x > RAW_HALF_PI )
+	{
+		x = RAW_PI - x;
+	}
+	else if( x < -RAW_HALF_PI )
+	{
+		x = -RAW_PI - x;
+	}
+
+	long long x30 = x * ( 1LL << ( SERIES_FRACTION_BITS - FRACTION_BITS ) );
+	long long x2 = ( x30 * x30 ) >> SERIES_FRACTION_BITS;
+	long long series = SERIES_ONE - x2 / 110;
+	series = SERIES_ONE - ( ( x2 * series ) >> SERIES_FRACTION_BITS ) / 72;
+	series = SERIES_ONE - ( ( x2 * series ) >> SERIES_FRACTION_BITS ) / 42;
+	series = SERIES_ONE - ( ( x2 * series ) >> SERIES_FRACTION_BITS ) / 20;
+	series = SERIES_ONE - ( ( x2 * series ) >> SERIES_FRACTION_BITS ) / 6;
+	long long result30 = ( x30 * series ) >> SERIES_FRACTION_BITS;
+
+	long long half = 1LL << ( SERIES_FRACTION_BITS - FRACTION_BITS - 1 );
+	return FromRaw( ( result30 + half ) >> ( SERIES_FRACTION_BITS - FRACTION_BITS ) );
+}
+
+
+Fixed Fixed::Cos( Fixed radians )
+{
+	return Sin( FromRaw( radians.__raw + RAW_HALF_PI ) );
+}
+
+
+
+// FixedVector2
+
+FixedVector2::FixedVector2()
+	: x( Fixed() )
+	, y( Fixed() )
+{
+}
+
+
+FixedVector2::FixedVector2( Fixed x, Fixed y )
+	: x( x )
+	, y( y )
+{
+}
+
+
+FixedVector2::FixedVector2( glm::vec2 vector )
+	: x( Fixed::FromFloat( vector.x ) )
+	, y( Fixed::FromFloat( vector.y ) )
+{
+}
+
+
+glm::vec2 FixedVector2::ToGLM()
+{
+	return glm::vec2( x.ToFloat(), y.ToFloat() );
+}
+
+
+FixedVector2 FixedVector2::operator+( FixedVector2 other )
+{
+	return FixedVector2( x + other.x, y + other.y );
+}
+
+
+FixedVector2 FixedVector2::operator-( FixedVector2 other )
+{
+	return FixedVector2( x - other.x, y - other.y );
+}
+
+
+FixedVector2 FixedVector2::operator*( Fixed scalar )
+{
+	return FixedVector2( x * scalar, y * scalar );
+}
+
+
+Fixed FixedVector2::Dot( FixedVector2 a, FixedVector2 b )
+{
+	return a.x * b.x + a.y * b.y;
+}
+
+
+// The z-component of the 3D cross product of ( a, 0 ) and ( b, 0 ).
+Fixed FixedVector2::Cross( FixedVector2 a, FixedVector2 b )
+{
+	return a.x * b.y - a.y * b.x;
+}
+
+
+FixedVector2 FixedVector2::Normalize( FixedVector2 vector )
+{
+	Fixed length = Fixed::Sqrt( Dot( vector, vector ) );
+	if( length == Fixed() )
+	{
+		return FixedVector2();
+	}
+	return FixedVector2( vector.x / length, vector.y / length );
+}
+
+
+// Rotates counter-clockwise, matching glm::rotate().
+FixedVector2 FixedVector2::Rotate( FixedVector2 vector, Fixed sin, Fixed cos )
+{
+	return FixedVector2( vector.x * cos - vector.y * sin, vector.x * sin + vector.y * cos );
+}
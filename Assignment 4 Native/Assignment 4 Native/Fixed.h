@@ -0,0 +1,66 @@
+#pragma once
+#include <glm.hpp>
+
+// Signed fixed-point number with 16 fractional bits stored in 64 bits (48.16). Every operation is
+// plain integer math, so results are bit-identical across compilers, builds and CPUs. This is what
+// the World uses for its per-step math when it is running in deterministic mode.
+class Fixed
+{
+	private:
+
+	long long __raw;
+
+	public:
+
+	static const int FRACTION_BITS = 16;
+	static const long long ONE = 1LL << FRACTION_BITS;
+
+	Fixed();
+	Fixed( int value );
+
+	static Fixed FromRaw( long long raw );
+	static Fixed FromFloat( float value );
+	static Fixed Max();
+
+	long long GetRaw();
+	float ToFloat();
+
+	Fixed operator-();
+	Fixed operator+( Fixed other );
+	Fixed operator-( Fixed other );
+	Fixed operator*( Fixed other );
+	Fixed operator/( Fixed other );
+	Fixed& operator+=( Fixed other );
+	Fixed& operator-=( Fixed other );
+	bool operator<( Fixed other );
+	bool operator>( Fixed other );
+	bool operator<=( Fixed other );
+	bool operator>=( Fixed other );
+	bool operator==( Fixed other );
+
+	static Fixed Sqrt( Fixed value );
+	static Fixed Sin( Fixed radians );
+	static Fixed Cos( Fixed radians );
+};
+
+// Two-component vector of Fixed values, the deterministic counterpart of glm::vec2.
+struct FixedVector2
+{
+	Fixed x;
+	Fixed y;
+
+	FixedVector2();
+	FixedVector2( Fixed x, Fixed y );
+	FixedVector2( glm::vec2 vector );
+
+	glm::vec2 ToGLM();
+
+	FixedVector2 operator+( FixedVector2 other );
+	FixedVector2 operator-( FixedVector2 other );
+	FixedVector2 operator*( Fixed scalar );
+
+	static Fixed Dot( FixedVector2 a, FixedVector2 b );
+	static Fixed Cross( FixedVector2 a, FixedVector2 b );
+	static FixedVector2 Normalize( FixedVector2 vector );
+	static FixedVector2 Rotate( FixedVector2 vector, Fixed sin, Fixed cos );
+};
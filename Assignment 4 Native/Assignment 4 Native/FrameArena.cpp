@@ -0,0 +1,99 @@
+#include "FrameArena.h"
+#include <algorithm>
+
+// The smallest block the arena keeps once it has had to grow. Tiny scenes still fit in one go.
+const size_t FrameArena::INITIAL_CAPACITY = 16 * 1024;
+
+// FrameArena
+
+// PRIVATE
+
+void FrameArena::FreeOverflowBlocks()
+{
+	while( __overflowBlocks != NULL )
+	{
+		char* previous = *(char**)__overflowBlocks;
+		delete[] __overflowBlocks;
+		__overflowBlocks = previous;
+	}
+	__overflowBytes = 0;
+}
+
+
+// PUBLIC
+
+FrameArena::FrameArena()
+	: __block( NULL )
+	, __capacity( 0 )
+	, __used( 0 )
+	, __overflowBlocks( NULL )
+	, __overflowBytes( 0 )
+	, __reservedCapacity( 0 )
+{
+}
+
+
+FrameArena::~FrameArena()
+{
+	FreeOverflowBlocks();
+	delete[] __block;
+}
+
+
+// alignment has to be a power of two no bigger than what new[] already guarantees (alignof( T ) for
+// anything the World keeps in here).
+void* FrameArena::Allocate( size_t bytes, size_t alignment )
+{
+	size_t offset = ( __used + alignment - 1 ) & ~( alignment - 1 );
+	if( offset + bytes <= __capacity )
+	{
+		__used = offset + bytes;
+		return __block + offset;
+	}
+
+	// Out of room: this allocation gets its own overflow block, and the next Reset() makes room for it.
+	size_t headerBytes = std::max( sizeof( char* ), alignment );
+	char* overflowBlock = new char[ headerBytes + bytes ];
+	*(char**)overflowBlock = __overflowBlocks;
+	__overflowBlocks = overflowBlock;
+	__overflowBytes += bytes + alignment;
+	return overflowBlock + headerBytes;
+}
+
+
+// Makes all of the arena's memory available again. This is just moving the bump pointer back unless 
+// the last step overflowed (or Reserve() asked for more), in which case the block is replaced with 
+// one that would have held it all.
+void FrameArena::Reset()
+{
+	if( __overflowBlocks != NULL || __capacity < __reservedCapacity )
+	{
+		size_t newCapacity = std::max( std::max( __capacity + __overflowBytes, INITIAL_CAPACITY ), __reservedCapacity );
+		FreeOverflowBlocks();
+		delete[] __block;
+		__block = new char[ newCapacity ];
+		__capacity = newCapacity;
+	}
+	__used = 0;
+}
+
+
+// Make the block at least bytes big from the next Reset() on, so a step that needs that much doesn't
+// have to overflow first. The block may still hold the current step's data, so it isn't swapped now.
+void FrameArena::Reserve( size_t bytes )
+{
+	__reservedCapacity = std::max( __reservedCapacity, bytes );
+}
+
+
+size_t FrameArena::GetCapacity()
+{
+	return __capacity;
+}
+
+
+// How many bytes of the block are handed out (overflow blocks not included).
+size_t FrameArena::GetUsed()
+{
+	return __used;
+}
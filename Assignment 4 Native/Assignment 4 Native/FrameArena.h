@@ -0,0 +1,126 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+// Bump-pointer allocator for data that only lives for one World step (collisions, pair candidates,
+// contact constraints, ...). Allocate() just moves a pointer along one block, and Reset() hands all
+// of it back at once by moving the pointer back to the start. Nothing is ever freed on its own.
+// When a step needs more than the block holds, the rest comes from overflow blocks, and the next 
+// Reset() swaps them all for a single block big enough for the whole step. After a few steps the 
+// block fits the busiest step seen so far and stepping stops touching the heap altogether.
+class FrameArena
+{
+	private:
+
+	char* __block;
+	size_t __capacity;
+	size_t __used;
+	char* __overflowBlocks; // Each overflow block starts with a pointer to the one before it.
+	size_t __overflowBytes;
+	size_t __reservedCapacity;
+
+	void FreeOverflowBlocks();
+
+	public:
+
+	static const size_t INITIAL_CAPACITY;
+
+	FrameArena();
+	~FrameArena();
+
+	void* Allocate( size_t bytes, size_t alignment );
+	void Reset();
+	void Reserve( size_t bytes );
+
+	size_t GetCapacity();
+	size_t GetUsed();
+};
+
+// A growable array whose storage comes from a FrameArena, standing in for std::vector for per-step
+// data. Growing copies the items into a block twice the size and simply abandons the old one to the
+// arena. Only meant for types that are fine being copied around and never destroyed.
+// The storage is only good until the arena's next Reset(), so Release() the list along with it.
+template<typename T>
+class FrameList
+{
+	private:
+
+	FrameArena* __arena;
+	T* __items;
+	int __count;
+	int __capacity;
+
+	public:
+
+	FrameList( FrameArena* arena )
+		: __arena( arena )
+		, __items( NULL )
+		, __count( 0 )
+		, __capacity( 0 )
+	{
+	}
+
+	void Add( const T& item )
+	{
+		if( __count == __capacity )
+		{
+			int newCapacity = __capacity == 0 ? 16 : __capacity * 2;
+			T* newItems = (T*)__arena->Allocate( newCapacity * sizeof( T ), alignof( T ) );
+			if( __count > 0 )
+			{
+				memcpy( newItems, __items, __count * sizeof( T ) );
+			}
+			__items = newItems;
+			__capacity = newCapacity;
+		}
+		new( __items + __count ) T( item );
+		__count++;
+	}
+
+	// Shifts the items after index down so the order is kept.
+	void RemoveAt( int index )
+	{
+		memmove( __items + index, __items + index + 1, ( __count - index - 1 ) * sizeof( T ) );
+		__count--;
+	}
+
+	// Empties the list but keeps its storage for the rest of the step.
+	void Clear()
+	{
+		__count = 0;
+	}
+
+	// Empties the list and forgets its storage, which the arena is about to reuse.
+	void Release()
+	{
+		__items = NULL;
+		__count = 0;
+		__capacity = 0;
+	}
+
+	int GetCount()
+	{
+		return __count;
+	}
+
+	bool IsEmpty()
+	{
+		return __count == 0;
+	}
+
+	T& operator[]( int index )
+	{
+		return __items[ index ];
+	}
+
+	T* begin()
+	{
+		return __items;
+	}
+
+	T* end()
+	{
+		return __items + __count;
+	}
+};
@@ -0,0 +1,90 @@
+#include "PieceTree.h"
+#include "Polygon.h"
+#include <algorithm>
+
+// PRIVATE
+
+// Builds the node over the pieces in __pieceOrder[ begin ] up to __pieceOrder[ end - 1 ] and returns
+// its index. Pieces are split in half by the position of their centers along the longer side of the 
+// box around those centers, so the tree comes out balanced: log2 of the piece count deep.
+int PieceTree::BuildNode( int begin, int end )
+{
+	int nodeId = (int)__nodes.size();
+	__nodes.emplace_back();
+
+	AABB aabb = __pieceAABBs[ __pieceOrder[ begin ] ];
+	AABB centers = AABB( aabb.GetCenter(), aabb.GetCenter() );
+	for( int i = begin + 1; i < end; i++ )
+	{
+		AABB pieceAABB = __pieceAABBs[ __pieceOrder[ i ] ];
+		aabb = AABB::Combine( aabb, pieceAABB );
+		centers = AABB::Combine( centers, AABB( pieceAABB.GetCenter(), pieceAABB.GetCenter() ) );
+	}
+
+	int piece = -1;
+	int child1 = -1;
+	int child2 = -1;
+	if( end - begin == 1 )
+	{
+		piece = __pieceOrder[ begin ];
+	}
+	else
+	{
+		int axis = centers.upper.x - centers.lower.x >= centers.upper.y - centers.lower.y ? 0 : 1;
+		int middle = ( begin + end ) / 2;
+		std::nth_element( __pieceOrder.begin() + begin, __pieceOrder.begin() + middle, __pieceOrder.begin() + end, [&]( int a, int b )
+		{
+			float aCenter = __pieceAABBs[ a ].GetCenter()[ axis ];
+			float bCenter = __pieceAABBs[ b ].GetCenter()[ axis ];
+			return aCenter < bCenter || ( aCenter == bCenter && a < b );
+		} );
+		child1 = BuildNode( begin, middle );
+		child2 = BuildNode( middle, end );
+	}
+
+	// Children were added after this node, so look it up again rather than holding on to a reference.
+	PieceNode& node = __nodes[ nodeId ];
+	node.aabb = aabb;
+	node.piece = piece;
+	node.child1 = child1;
+	node.child2 = child2;
+	return nodeId;
+}
+
+
+
+// PUBLIC
+
+PieceTree::PieceTree()
+	: __nodes( std::vector<PieceNode>() )
+	, __pieceAABBs( std::vector<AABB>() )
+	, __pieceOrder( std::vector<int>() )
+{
+}
+
+
+// Rebuild the tree over the local boxes of pieces (which can be empty, leaving an empty tree).
+void PieceTree::Build( const std::vector<Polygon*>& pieces )
+{
+	__nodes.clear();
+	__pieceAABBs.clear();
+	__pieceOrder.clear();
+	for( int i = 0; i < (int)pieces.size(); i++ )
+	{
+		std::vector<glm::vec2>& vertices = pieces[ i ]->GetVertices();
+		AABB aabb = AABB( vertices[ 0 ], vertices[ 0 ] );
+		for( glm::vec2 vertex : vertices )
+		{
+			aabb.lower = glm::min( aabb.lower, vertex );
+			aabb.upper = glm::max( aabb.upper, vertex );
+		}
+		__pieceAABBs.push_back( aabb );
+		__pieceOrder.push_back( i );
+	}
+
+	if( !pieces.empty() )
+	{
+		__nodes.reserve( 2 * pieces.size() - 1 );
+		BuildNode( 0, (int)pieces.size() );
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <exception>
+#include <vector>
+#include "AABB.h"
+
+class Polygon;
+
+// A single node of a PieceTree. Leaves hold the index of one piece, internal nodes hold the union of
+// their children's boxes.
+struct PieceNode
+{
+	AABB aabb;
+	int piece; // -1 for internal nodes.
+	int child1;
+	int child2;
+};
+
+// Bounding volume hierarchy over the pieces of a compound Polygon, in the Polygon's local space. The
+// pieces never move relative to each other, so unlike the broadphase's DynamicTree this one is built 
+// once, top down, whenever the compound gets its pieces and is only ever queried after that. 
+// Narrowphase asks it for the pieces near the other Polygon instead of testing every one of them.
+class PieceTree
+{
+	private:
+
+	std::vector<PieceNode> __nodes;
+	std::vector<AABB> __pieceAABBs;
+	std::vector<int> __pieceOrder;
+
+	int BuildNode( int begin, int end );
+
+	public:
+
+	static const int QUERY_STACK_CAPACITY = 64;
+
+	PieceTree();
+
+	void Build( const std::vector<Polygon*>& pieces );
+
+	// Calls callback( pieceIndex ) for every piece whose local box overlaps aabb (also in local space),
+	// until callback returns false. Walks the tree with a fixed-size stack so queries never allocate.
+	template<typename T>
+	void Query( AABB aabb, T& callback )
+	{
+		if( __nodes.empty() )
+		{
+			return;
+		}
+
+		int stack[ QUERY_STACK_CAPACITY ];
+		int stackCount = 0;
+		stack[ stackCount++ ] = 0;
+
+		while( stackCount > 0 )
+		{
+			PieceNode& node = __nodes[ stack[ --stackCount ] ];
+			if( !node.aabb.Overlaps( aabb ) )
+			{
+				continue;
+			}
+
+			if( node.piece >= 0 )
+			{
+				if( !callback( node.piece ) )
+				{
+					return;
+				}
+			}
+			else
+			{
+				if( stackCount + 2 > QUERY_STACK_CAPACITY )
+				{
+					throw std::exception( "PieceTree is too deep to query!" );
+				}
+				stack[ stackCount++ ] = node.child1;
+				stack[ stackCount++ ] = node.child2;
+			}
+		}
+	}
+};
@@ -1,19 +1,202 @@
 #include "Polygon.h"
 #include "gtx\matrix_transform_2d.hpp"
 #include "Face.h"
+#include "Fixed.h"
+#include "RayPacket.h"
+#include <algorithm>
+#include <cstring>
+
+// Hull and outline vertices closer together than this are welded into one.
+static const float VERTEX_WELD_DISTANCE = 0.005f;
+// Hull and outline vertices closer than this to the line through their neighbours are dropped as 
+// collinear. An outline vertex has to bend inwards by more than this to make the outline concave.
+static const float COLLINEAR_DISTANCE = 0.005f;
+// How far GetLocalAABB() grows the boxes it hands to the PieceTree, so float error in bringing them 
+// into local space can't make a query miss a piece whose own box overlaps.
+static const float PIECE_QUERY_MARGIN = 0.01f;
+static const float PI = 3.14159265f;
+// How far from square (as the cosine of the angle) a corner may be for four vertices to make a box.
+static const float BOX_CORNER_TOLERANCE = 0.0001f;
+
+// The z-component of ( b - a ) x ( c - a ): positive when a -> b -> c turns counter-clockwise.
+static float Turn( glm::vec2 a, glm::vec2 b, glm::vec2 c )
+{
+	glm::vec2 ab = b - a;
+	glm::vec2 ac = c - a;
+	return ab.x * ac.y - ab.y * ac.x;
+}
+
+// Welds neighbouring vertices within tolerance and drops (nearly) collinear ones until nothing 
+// changes or only a triangle is left. Vertices bending either way count, so this works on concave 
+// outlines as well as hulls.
+static void Simplify( std::vector<glm::vec2>& vertices )
+{
+	bool isSimplified = false;
+	while ( !isSimplified && vertices.size() > 3 )
+	{
+		isSimplified = true;
+		for ( int i = 0; i < (int)vertices.size() && vertices.size() > 3; i++ )
+		{
+			glm::vec2 previous = vertices[ ( i + vertices.size() - 1 ) % vertices.size() ];
+			glm::vec2 next = vertices[ ( i + 1 ) % vertices.size() ];
+			float span = glm::length( next - previous );
+			bool isWelded = glm::length( vertices[ i ] - previous ) < VERTEX_WELD_DISTANCE;
+			bool isCollinear = span > 0.0f && glm::abs( Turn( previous, vertices[ i ], next ) ) / span < COLLINEAR_DISTANCE;
+			if ( isWelded || isCollinear )
+			{
+				vertices.erase( vertices.begin() + i );
+				isSimplified = false;
+				i--;
+			}
+		}
+	}
+}
+
+// Whether the outline, taken in the order given (either winding), bends inwards anywhere by more than
+// COLLINEAR_DISTANCE. Neighbours within welding distance are skipped so duplicates can't hide a bend.
+// This is all a convex outline (the usual case) goes through, and it doesn't allocate.
+static bool HasReflexVertex( const TransportVector2* vertices, int verticesLength )
+{
+	// The sign of the shoelace area says which way the outline winds.
+	float area = 0.0f;
+	for ( int i = 0; i < verticesLength; i++ )
+	{
+		TransportVector2 a = vertices[ i ];
+		TransportVector2 b = vertices[ ( i + 1 ) % verticesLength ];
+		area += a.x * b.y - a.y * b.x;
+	}
+
+	for ( int i = 0; i < verticesLength; i++ )
+	{
+		glm::vec2 vertex = glm::vec2( vertices[ i ].x, vertices[ i ].y );
+		int previous = ( i + verticesLength - 1 ) % verticesLength;
+		while ( previous != i && glm::length( glm::vec2( vertices[ previous ].x, vertices[ previous ].y ) - vertex ) < VERTEX_WELD_DISTANCE )
+		{
+			previous = ( previous + verticesLength - 1 ) % verticesLength;
+		}
+		int next = ( i + 1 ) % verticesLength;
+		while ( next != i && glm::length( glm::vec2( vertices[ next ].x, vertices[ next ].y ) - vertex ) < VERTEX_WELD_DISTANCE )
+		{
+			next = ( next + 1 ) % verticesLength;
+		}
+
+		glm::vec2 previousVertex = glm::vec2( vertices[ previous ].x, vertices[ previous ].y );
+		glm::vec2 nextVertex = glm::vec2( vertices[ next ].x, vertices[ next ].y );
+		float span = glm::length( nextVertex - previousVertex );
+		float turn = Turn( previousVertex, vertex, nextVertex );
+		if ( span > 0.0f && turn * area < 0.0f && glm::abs( turn ) / span > COLLINEAR_DISTANCE )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// Whether any two edges of the (closed) outline that don't share a vertex cross each other.
+static bool IsSelfIntersecting( const std::vector<glm::vec2>& outline )
+{
+	int count = (int)outline.size();
+	for ( int i = 0; i < count; i++ )
+	{
+		glm::vec2 a = outline[ i ];
+		glm::vec2 b = outline[ ( i + 1 ) % count ];
+		for ( int j = i + 2; j < count; j++ )
+		{
+			if ( i == 0 && j == count - 1 )
+			{
+				continue;
+			}
+			glm::vec2 c = outline[ j ];
+			glm::vec2 d = outline[ ( j + 1 ) % count ];
+			if ( Turn( c, d, a ) * Turn( c, d, b ) < 0.0f && Turn( a, b, c ) * Turn( a, b, d ) < 0.0f )
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+// Whether outline[ current ] is an ear of the CCW polygon made of the outline vertices in remaining:
+// it turns left, and no other remaining vertex lies in the triangle it makes with its neighbours.
+static bool IsEar( const std::vector<glm::vec2>& outline, const std::vector<int>& remaining, int previous, int current, int next )
+{
+	glm::vec2 a = outline[ previous ];
+	glm::vec2 b = outline[ current ];
+	glm::vec2 c = outline[ next ];
+	if ( Turn( a, b, c ) <= 0.0f )
+	{
+		return false;
+	}
+	for ( int index : remaining )
+	{
+		glm::vec2 point = outline[ index ];
+		bool isCorner = index == previous || index == current || index == next;
+		if ( !isCorner && Turn( a, b, point ) >= 0.0f && Turn( b, c, point ) >= 0.0f && Turn( c, a, point ) >= 0.0f )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Hertel-Mehlhorn's merge step: if the CCW pieces a and b (indices into outline) share an edge and 
+// removing it leaves a convex piece (give or take COLLINEAR_DISTANCE), writes that piece to merged.
+static bool MergeAcrossDiagonal( const std::vector<glm::vec2>& outline, const std::vector<int>& a, const std::vector<int>& b, std::vector<int>& merged )
+{
+	int aCount = (int)a.size();
+	int bCount = (int)b.size();
+	for ( int i = 0; i < aCount; i++ )
+	{
+		// a runs u -> v along the diagonal, so b has to run v -> u.
+		int u = a[ i ];
+		int v = a[ ( i + 1 ) % aCount ];
+		for ( int j = 0; j < bCount; j++ )
+		{
+			if ( b[ j ] != v || b[ ( j + 1 ) % bCount ] != u )
+			{
+				continue;
+			}
+
+			// All of a from v round to u, then the rest of b from just after u to just before v.
+			merged.clear();
+			for ( int k = 0; k < aCount; k++ )
+			{
+				merged.push_back( a[ ( i + 1 + k ) % aCount ] );
+			}
+			for ( int k = 2; k < bCount; k++ )
+			{
+				merged.push_back( b[ ( j + k ) % bCount ] );
+			}
+
+			int mergedCount = (int)merged.size();
+			for ( int k = 0; k < mergedCount; k++ )
+			{
+				glm::vec2 previous = outline[ merged[ ( k + mergedCount - 1 ) % mergedCount ] ];
+				glm::vec2 next = outline[ merged[ ( k + 1 ) % mergedCount ] ];
+				if ( Turn( previous, outline[ merged[ k ] ], next ) / glm::length( next - previous ) < -COLLINEAR_DISTANCE )
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+	}
+	return false;
+}
 
 // PRIVATE
-Polygon::Polygon( std::vector<glm::vec2>* vertices, glm::vec2 position, float rotation, float mass, bool useGravity, bool isStatic )
-	: __vertices( NULL )
-	, __position( position )
-	, __rotation( rotation )
-	, __mass( mass )
-	, __useGravity( useGravity )
+
+// Polygons are only built by a PolygonPool (and as the World's query shape), empty, and get their
+// state from Reset() and their shape from SetVertices() each time they are handed out.
+Polygon::Polygon()
+	: __vertices( new std::vector<glm::vec2>() )
 	, __globalVertices( std::vector<glm::vec2>() )
+	, __normals( std::vector<glm::vec2>() )
 	, __faces( std::vector<Face>() )
-	, __isStatic( isStatic )
+	, __pieces( std::vector<Polygon*>() )
 {
-	SetVertices( vertices );
+	Reset( glm::vec2(), 0.0f, 1.0f, false, false );
 }
 
 
@@ -23,6 +206,56 @@ Polygon::~Polygon()
 }
 
 
+// Puts every property back to how a brand new Polygon starts out. The geometry is left alone (apart 
+// from going back to a plain ShapeType::Polygon), since SetVertices() or a snapshot overwrites it 
+// anyway and keeping the vectors keeps their capacity.
+void Polygon::Reset( glm::vec2 position, float rotation, float mass, bool useGravity, bool isStatic )
+{
+	__position = position;
+	__velocity = glm::vec2();
+	__rotation = rotation;
+	__rotationalVelocity = 0.0f;
+	__mass = mass;
+	__useGravity = useGravity;
+	__isStatic = isStatic;
+	__isDeterministic = false;
+	__isBullet = false;
+	__isKinematic = false;
+	__isSensor = false;
+	__rotationalInertia = 0.0f;
+	__inverseMass = 0.0f;
+	__inverseRotationalInertia = 0.0f;
+	__previousPosition = position;
+	__previousRotation = rotation;
+	__aabb = AABB();
+	__handle = 0;
+	__proxyId = -1;
+	__collisionCategory = 0x00000001;
+	__collisionMask = 0xFFFFFFFF;
+	__contactCount = 0;
+	__body = NULL;
+	__shape = ShapeType::Polygon;
+	__radius = 0.0f;
+	__isBox = false;
+	__isAwake = true;
+	__sleepTime = 0.0f;
+	__restPosition = position;
+	__restRotation = rotation;
+	__island = this;
+	__isIslandResting = false;
+}
+
+
+// Makes room for vertexCount vertices in every per-vertex vector up front.
+void Polygon::Reserve( int vertexCount )
+{
+	__vertices->reserve( vertexCount );
+	__globalVertices.reserve( vertexCount );
+	__normals.reserve( vertexCount );
+	__faces.reserve( vertexCount );
+}
+
+
 void Polygon::UpdateCenterOfMass()
 {
 	// Find centroid of vertices.
@@ -59,9 +292,240 @@ void Polygon::UpdateCenterOfMass()
 }
 
 
+// Replaces __vertices with the convex hull of vertices (Andrew's monotone chain) in the CW order
+// Face::GetNormal() expects, with near-duplicate vertices welded and (nearly) collinear ones dropped,
+// so SAT only ever sees a convex shape with as few faces as possible. If the first vertex passed in
+// makes it into the hull, the hull starts there, which leaves already-clean input exactly as it was.
+// __globalVertices and __normals are used as scratch space, since they get rebuilt right after.
+void Polygon::BuildConvexHull( const TransportVector2* vertices, int verticesLength )
+{
+	std::vector<glm::vec2>& points = __globalVertices;
+	points.resize( verticesLength );
+	for ( int i = 0; i < verticesLength; i++ )
+	{
+		points[ i ] = glm::vec2( vertices[ i ].x, vertices[ i ].y );
+	}
+	BuildConvexHullOfPoints( points[ 0 ] );
+}
+
+
+// BuildConvexHull() for points already copied into __globalVertices, starting the hull at firstVertex
+// if it makes it in.
+void Polygon::BuildConvexHullOfPoints( glm::vec2 firstVertex )
+{
+	std::vector<glm::vec2>& points = __globalVertices;
+	std::vector<glm::vec2>& hull = __normals;
+	int verticesLength = (int)points.size();
+
+	std::sort( points.begin(), points.end(), []( glm::vec2 a, glm::vec2 b ) { return a.x < b.x || ( a.x == b.x && a.y < b.y ); } );
+
+	// Lower hull left to right, then upper hull right to left, keeping only strict left turns so exact
+	// duplicates and collinear points fall out along the way. This builds the hull CCW.
+	hull.clear();
+	for ( int i = 0; i < verticesLength; i++ )
+	{
+		while ( hull.size() >= 2 && Turn( hull[ hull.size() - 2 ], hull.back(), points[ i ] ) <= 0.0f )
+		{
+			hull.pop_back();
+		}
+		hull.push_back( points[ i ] );
+	}
+	size_t lowerCount = hull.size() + 1;
+	for ( int i = verticesLength - 2; i >= 0; i-- )
+	{
+		while ( hull.size() >= lowerCount && Turn( hull[ hull.size() - 2 ], hull.back(), points[ i ] ) <= 0.0f )
+		{
+			hull.pop_back();
+		}
+		hull.push_back( points[ i ] );
+	}
+	if ( !hull.empty() )
+	{
+		hull.pop_back(); // The upper hull ends back at the first point.
+	}
+
+	// Weld and drop vertices within tolerance.
+	Simplify( hull );
+
+	bool isDegenerate = hull.size() < 3 || Turn( hull[ 0 ], hull[ 1 ], hull[ 2 ] ) / glm::length( hull[ 2 ] - hull[ 0 ] ) < COLLINEAR_DISTANCE;
+	if ( isDegenerate )
+	{
+		// Put the scratch vectors back before bailing out so this Polygon is left as it was.
+		UpdateGlobalVertices();
+		UpdateNormals();
+		throw std::exception( "A Polygon needs at least 3 vertices that aren't all in a line!" );
+	}
+
+	__vertices->assign( hull.rbegin(), hull.rend() );
+	auto first = std::find( __vertices->begin(), __vertices->end(), firstVertex );
+	if ( first != __vertices->end() )
+	{
+		std::rotate( __vertices->begin(), first, __vertices->end() );
+	}
+}
+
+
+// Makes this Polygon the compound of the convex Polygons in __pieces, whose local vertices are in 
+// this Polygon's frame. Everything is moved onto the pieces' combined center of mass (each piece 
+// weighted by its area), this Polygon's own vertices become the convex hull of the pieces (which is 
+// all its box, bullet sweeps and snapshots need) and the pieces are set up to follow it around.
+void Polygon::BuildCompound()
+{
+	__shape = ShapeType::Polygon;
+	__radius = 0.0f;
+
+	float totalArea = 0.0f;
+	glm::vec2 centerOfMass;
+	for ( Polygon* piece : __pieces )
+	{
+		// Shoelace area and centroid, both signed the same way so the winding cancels out.
+		std::vector<glm::vec2>& vertices = *piece->__vertices;
+		for ( int i = 0; i < (int)vertices.size(); i++ )
+		{
+			glm::vec2 a = vertices[ i ];
+			glm::vec2 b = vertices[ ( i + 1 ) % vertices.size() ];
+			float cross = a.x * b.y - a.y * b.x;
+			totalArea += 0.5f * cross;
+			centerOfMass += ( a + b ) * ( cross / 6.0f );
+		}
+	}
+	centerOfMass /= totalArea;
+
+	std::vector<glm::vec2>& points = __globalVertices;
+	points.clear();
+	for ( Polygon* piece : __pieces )
+	{
+		piece->__body = this;
+		for ( glm::vec2& vertex : *piece->__vertices )
+		{
+			vertex -= centerOfMass;
+			points.push_back( vertex );
+		}
+	}
+	BuildConvexHullOfPoints( __pieces[ 0 ]->__vertices->at( 0 ) );
+	__pieceTree.Build( __pieces );
+
+	UpdateGlobalVertices(); // Moves the pieces along too.
+	UpdateFaces();
+	UpdateNormals();
+	for ( Polygon* piece : __pieces )
+	{
+		piece->UpdateFaces();
+		piece->UpdateNormals();
+		piece->UpdateIsBox();
+	}
+	__isBox = false;
+	UpdateRotationalInertia();
+}
+
+
+// Splits a concave outline into convex pieces: the outline (in the order given, either winding) is 
+// cleaned up the way BuildConvexHull() cleans up a hull, ear clipped into triangles and then the 
+// triangles are merged back together across every diagonal whose removal keeps them convex 
+// (Hertel-Mehlhorn), which leaves at most four times as many pieces as the fewest possible. Writes 
+// the pieces (CW, like every Polygon) to pieces and returns true. Returns false, leaving pieces 
+// alone, if the outline is convex or isn't a simple polygon (a point cloud, say): those are better 
+// off as their convex hull. Convex outlines are spotted without allocating anything.
+bool Polygon::DecomposeOutline( const TransportVector2* vertices, int verticesLength, std::vector<std::vector<glm::vec2>>& pieces )
+{
+	if ( vertices == NULL || verticesLength < 4 || !HasReflexVertex( vertices, verticesLength ) )
+	{
+		return false;
+	}
+
+	std::vector<glm::vec2> outline;
+	for ( int i = 0; i < verticesLength; i++ )
+	{
+		outline.push_back( glm::vec2( vertices[ i ].x, vertices[ i ].y ) );
+	}
+	Simplify( outline );
+
+	// Ear clipping wants the outline CCW.
+	float area = 0.0f;
+	for ( int i = 0; i < (int)outline.size(); i++ )
+	{
+		area += Turn( glm::vec2(), outline[ i ], outline[ ( i + 1 ) % outline.size() ] );
+	}
+	if ( area < 0.0f )
+	{
+		std::reverse( outline.begin(), outline.end() );
+	}
+	if ( outline.size() < 4 || area == 0.0f || IsSelfIntersecting( outline ) )
+	{
+		return false;
+	}
+
+	// Clip ears until a single triangle is left. No ear means the outline is too far gone to split.
+	std::vector<std::vector<int>> parts;
+	std::vector<int> remaining;
+	for ( int i = 0; i < (int)outline.size(); i++ )
+	{
+		remaining.push_back( i );
+	}
+	while ( remaining.size() > 3 )
+	{
+		int count = (int)remaining.size();
+		int ear = -1;
+		for ( int i = 0; i < count && ear < 0; i++ )
+		{
+			if ( IsEar( outline, remaining, remaining[ ( i + count - 1 ) % count ], remaining[ i ], remaining[ ( i + 1 ) % count ] ) )
+			{
+				ear = i;
+			}
+		}
+		if ( ear < 0 )
+		{
+			return false;
+		}
+		parts.push_back( { remaining[ ( ear + count - 1 ) % count ], remaining[ ear ], remaining[ ( ear + 1 ) % count ] } );
+		remaining.erase( remaining.begin() + ear );
+	}
+	parts.push_back( remaining );
+
+	// Merge across diagonals until no two pieces can be merged any more.
+	std::vector<int> merged;
+	bool isMerged = true;
+	while ( isMerged )
+	{
+		isMerged = false;
+		for ( int i = 0; i < (int)parts.size() && !isMerged; i++ )
+		{
+			for ( int j = i + 1; j < (int)parts.size() && !isMerged; j++ )
+			{
+				if ( MergeAcrossDiagonal( outline, parts[ i ], parts[ j ], merged ) )
+				{
+					parts[ i ] = merged;
+					parts.erase( parts.begin() + j );
+					isMerged = true;
+				}
+			}
+		}
+	}
+
+	// Back to CW, dropping vertices left collinear where a diagonal was merged away.
+	pieces.clear();
+	for ( std::vector<int>& part : parts )
+	{
+		std::vector<glm::vec2> piece;
+		for ( auto index = part.rbegin(); index != part.rend(); ++index )
+		{
+			piece.push_back( outline[ *index ] );
+		}
+		Simplify( piece );
+		pieces.push_back( piece );
+	}
+	return true;
+}
+
+
+// Circles and capsules are tested without faces (see World::CollideRound()), so they have none.
 void Polygon::UpdateFaces()
 {
 	__faces.clear();
+	if ( __shape != ShapeType::Polygon )
+	{
+		return;
+	}
 	for ( auto i = 0; i < __globalVertices.size(); i++ )
 	{
 		int vertexIndex1 = i;
@@ -71,8 +535,59 @@ void Polygon::UpdateFaces()
 }
 
 
+// Cache each face's outward normal in local space so ray casts don't need to normalize anything.
+// Recentering on the center of mass doesn't change them, so they only go stale when the vertices do.
+void Polygon::UpdateNormals()
+{
+	__normals.clear();
+	if ( __shape != ShapeType::Polygon )
+	{
+		return;
+	}
+	for ( int i = 0; i < (int)__vertices->size(); i++ )
+	{
+		// CW ordering so we compute a left-normal.
+		glm::vec2 vector = glm::normalize( __vertices->at( ( i + 1 ) % __vertices->size() ) - __vertices->at( i ) );
+		__normals.push_back( glm::vec2( -vector.y, vector.x ) );
+	}
+}
+
+
+// Most Polygons are rectangles, and a pair of them only has four axes between them whose extents 
+// come straight from their half extents (see World::TestBoxAxes()). Only plain Polygons with four 
+// vertices and square corners count; compounds never do, though their pieces can.
+void Polygon::UpdateIsBox()
+{
+	__isBox = false;
+	std::vector<glm::vec2>& vertices = *__vertices;
+	if ( __shape != ShapeType::Polygon || !__pieces.empty() || vertices.size() != 4 )
+	{
+		return;
+	}
+
+	for ( int i = 0; i < 4; i++ )
+	{
+		glm::vec2 edge = vertices[ ( i + 1 ) % 4 ] - vertices[ i ];
+		glm::vec2 nextEdge = vertices[ ( i + 2 ) % 4 ] - vertices[ ( i + 1 ) % 4 ];
+		if ( glm::abs( glm::dot( edge, nextEdge ) ) > BOX_CORNER_TOLERANCE * glm::length( edge ) * glm::length( nextEdge ) )
+		{
+			return;
+		}
+	}
+	__halfExtents = 0.5f * glm::vec2( glm::length( vertices[ 1 ] - vertices[ 0 ] ), glm::length( vertices[ 2 ] - vertices[ 1 ] ) );
+	__isBox = true;
+}
+
+
 void Polygon::UpdateGlobalVertices()
 {
+	if( __isDeterministic )
+	{
+		UpdateGlobalVerticesFixed();
+		UpdatePieces();
+		return;
+	}
+
 	glm::mat3 transform = glm::mat3();
 	transform = glm::translate( transform, __position );
 	transform = glm::rotate( transform, __rotation );
@@ -85,28 +600,243 @@ void Polygon::UpdateGlobalVertices()
 		glm::vec3 globalVertex = transform * vertex3;
 		__globalVertices.push_back( glm::vec2( globalVertex ) );
 	}
+	UpdateAABB();
+	UpdatePieces();
+}
+
+
+// Same transform as UpdateGlobalVertices() but done in Fixed math (including sin and cos) so the 
+// global vertices come out bit-identical on every machine.
+void Polygon::UpdateGlobalVerticesFixed()
+{
+	FixedVector2 position = FixedVector2( __position );
+	Fixed rotation = Fixed::FromFloat( __rotation );
+	Fixed sin = Fixed::Sin( rotation );
+	Fixed cos = Fixed::Cos( rotation );
+
+	__globalVertices.clear();
+	for ( int i = 0; i < (int)__vertices->size(); i++ )
+	{
+		FixedVector2 vertex = FixedVector2( __vertices->at( i ) );
+		FixedVector2 globalVertex = position + FixedVector2::Rotate( vertex, sin, cos );
+		__globalVertices.push_back( globalVertex.ToGLM() );
+	}
+	UpdateAABB();
+}
+
+
+// Give a compound Polygon's pieces its pose and bring their global vertices (and boxes) along.
+void Polygon::UpdatePieces()
+{
+	for ( Polygon* piece : __pieces )
+	{
+		piece->__position = __position;
+		piece->__rotation = __rotation;
+		piece->__isDeterministic = __isDeterministic;
+		piece->UpdateGlobalVertices();
+	}
+}
+
+
+// The box in this Polygon's local space around aabb (a box in world space), plus PIECE_QUERY_MARGIN.
+AABB Polygon::GetLocalAABB( AABB aabb )
+{
+	float cos = glm::cos( __rotation );
+	float sin = glm::sin( __rotation );
+	glm::vec2 offset = aabb.GetCenter() - __position;
+	glm::vec2 center = glm::vec2( cos * offset.x + sin * offset.y, -sin * offset.x + cos * offset.y );
+	glm::vec2 extents = aabb.GetExtents();
+	extents = glm::vec2( glm::abs( cos ) * extents.x + glm::abs( sin ) * extents.y, glm::abs( sin ) * extents.x + glm::abs( cos ) * extents.y );
+	return AABB( center - extents, center + extents ).Extend( PIECE_QUERY_MARGIN );
+}
+
+
+// Fit __aabb tightly around the global vertices, plus the radius of a circle or capsule.
+void Polygon::UpdateAABB()
+{
+	if( __globalVertices.empty() )
+	{
+		__aabb = AABB( __position, __position );
+		return;
+	}
+
+	__aabb = AABB( __globalVertices[ 0 ], __globalVertices[ 0 ] );
+	for ( glm::vec2 vertex : __globalVertices )
+	{
+		__aabb.lower = glm::min( __aabb.lower, vertex );
+		__aabb.upper = glm::max( __aabb.upper, vertex );
+	}
+	__aabb = __aabb.Extend( __radius );
 }
 
 
 void Polygon::UpdateRotationalInertia()
 {
-	// Find the average radius of vertices from center of mass (origin).
+	// Circles and capsules have exact inertias: a disc is mr^2 / 2, and a capsule is a box plus two 
+	// half discs (each offset along the segment) with the mass shared out by area.
+	if ( __shape == ShapeType::Circle )
+	{
+		__rotationalInertia = 0.5f * __mass * __radius * __radius;
+		UpdateInverseMass();
+		return;
+	}
+	if ( __shape == ShapeType::Capsule )
+	{
+		float length = glm::length( __vertices->at( 1 ) - __vertices->at( 0 ) );
+		float boxArea = 2.0f * __radius * length;
+		float discArea = PI * __radius * __radius;
+		float boxMass = __mass * boxArea / ( boxArea + discArea );
+		float discMass = __mass - boxMass;
+		float halfLength = 0.5f * length;
+		float discCentroid = 4.0f * __radius / ( 3.0f * PI );
+		float boxInertia = boxMass * ( 4.0f * __radius * __radius + length * length ) / 12.0f;
+		float discInertia = discMass * ( 0.5f * __radius * __radius + halfLength * halfLength + 2.0f * halfLength * discCentroid );
+		__rotationalInertia = boxInertia + discInertia;
+		UpdateInverseMass();
+		return;
+	}
+
+	// Find the average radius of vertices from center of mass (origin). A compound's hull would skip 
+	// the vertices in its notches, so those go by the vertices of every piece instead.
 	float averageRadius = 0.0f;
-	for ( glm::vec2 vertex : *__vertices )
+	int vertexCount = 0;
+	for ( int i = 0; i < GetPieceCount(); i++ )
 	{
-		averageRadius += glm::length( vertex );
+		for ( glm::vec2 vertex : *GetPiece( i )->__vertices )
+		{
+			averageRadius += glm::length( vertex );
+			vertexCount++;
+		}
 	}
-	averageRadius /= __vertices->size();
+	averageRadius /= vertexCount;
 
 	// Using mr^2 since arbitrary polygons can be oddly shaped. This isn't perfect but we could do 
 	// better if we made subclasses for ideal shapes that we could define more accurately.
 	__rotationalInertia = __mass * averageRadius * averageRadius;
+	UpdateInverseMass();
+}
+
+
+// Cache the inverses the solvers work with. Static and kinematic Polygons can't be pushed around, 
+// which is the same as having infinite mass, so theirs are 0 and impulses leave them alone.
+void Polygon::UpdateInverseMass()
+{
+	bool isImmovable = __isStatic || __isKinematic;
+	__inverseMass = isImmovable ? 0.0f : 1.0f / __mass;
+	__inverseRotationalInertia = isImmovable ? 0.0f : 1.0f / __rotationalInertia;
+}
+
+
+
+// Move and rotate in one go, updating the global vertices once instead of twice.
+void Polygon::SetTransform( glm::vec2 position, float rotation )
+{
+	__position = position;
+	__rotation = rotation;
+	UpdateGlobalVertices();
+}
+
+
+// RayCast() for a circle or capsule, in world space. The segment is tested against the disc at each
+// end of the capsule's segment and against its two flat sides, and the nearest entry wins.
+bool Polygon::RayCastRound( glm::vec2 origin, glm::vec2 end, float maxFraction, float* fraction, glm::vec2* normal )
+{
+	glm::vec2 a = __globalVertices.front();
+	glm::vec2 b = __globalVertices.back();
+	glm::vec2 segment = b - a;
+	glm::vec2 direction = end - origin;
+	float radiusSquared = __radius * __radius;
+
+	// Segments starting inside don't hit.
+	float segmentLengthSquared = glm::dot( segment, segment );
+	float along = segmentLengthSquared > 0.0f ? glm::clamp( glm::dot( origin - a, segment ) / segmentLengthSquared, 0.0f, 1.0f ) : 0.0f;
+	glm::vec2 offset = origin - ( a + along * segment );
+	if ( glm::dot( offset, offset ) < radiusSquared )
+	{
+		return false;
+	}
+
+	bool isHit = false;
+	float directionLengthSquared = glm::dot( direction, direction );
+	for ( int i = 0; i < (int)__globalVertices.size() && directionLengthSquared > 0.0f; i++ )
+	{
+		// Solve |origin + t * direction - center| = radius for the smaller t.
+		glm::vec2 center = __globalVertices[ i ];
+		glm::vec2 toOrigin = origin - center;
+		float halfB = glm::dot( toOrigin, direction );
+		float discriminant = halfB * halfB - directionLengthSquared * ( glm::dot( toOrigin, toOrigin ) - radiusSquared );
+		if ( discriminant < 0.0f )
+		{
+			continue;
+		}
+		float t = ( -halfB - glm::sqrt( discriminant ) ) / directionLengthSquared;
+		if ( t >= 0.0f && t <= maxFraction )
+		{
+			maxFraction = t;
+			*fraction = t;
+			*normal = glm::normalize( toOrigin + t * direction );
+			isHit = true;
+		}
+	}
+
+	if ( __shape == ShapeType::Capsule )
+	{
+		glm::vec2 axis = glm::normalize( segment );
+		for ( float side = -1.0f; side <= 1.0f; side += 2.0f )
+		{
+			// Only entering a side counts, and only between the two discs.
+			glm::vec2 sideNormal = side * glm::vec2( -axis.y, axis.x );
+			float denominator = glm::dot( sideNormal, direction );
+			if ( denominator >= 0.0f )
+			{
+				continue;
+			}
+			float t = ( __radius - glm::dot( sideNormal, origin - a ) ) / denominator;
+			float projection = glm::dot( origin + t * direction - a, segment );
+			if ( t >= 0.0f && t <= maxFraction && projection >= 0.0f && projection <= segmentLengthSquared )
+			{
+				maxFraction = t;
+				*fraction = t;
+				*normal = sideNormal;
+				isHit = true;
+			}
+		}
+	}
+	return isHit;
 }
 
 
 
 // PUBLIC
 
+POLYGON_HANDLE Polygon::GetHandle()
+{
+	return __handle;
+}
+
+
+// The tight box around the global vertices, kept up to date whenever the Polygon moves.
+AABB Polygon::GetAABB()
+{
+	return __aabb;
+}
+
+
+// Which collision layers this Polygon belongs to (one bit per layer). Set through the World so the
+// broadphase hears about it.
+unsigned int Polygon::GetCollisionCategory()
+{
+	return __collisionCategory;
+}
+
+
+// Which collision layers this Polygon collides with (one bit per layer).
+unsigned int Polygon::GetCollisionMask()
+{
+	return __collisionMask;
+}
+
+
 bool Polygon::GetUseGravity()
 {
 	return __useGravity;
@@ -126,6 +856,67 @@ bool Polygon::GetIsStatic()
 void Polygon::SetIsStatic( bool isStatic )
 {
 	__isStatic = isStatic;
+	UpdateInverseMass();
+}
+
+
+bool Polygon::GetIsDeterministic()
+{
+	return __isDeterministic;
+}
+
+void Polygon::SetIsDeterministic( bool isDeterministic )
+{
+	__isDeterministic = isDeterministic;
+	UpdateGlobalVertices();
+}
+
+
+// Bullets are swept from where they started each step to where they ended up, so they can't tunnel
+// through other Polygons no matter how fast they go.
+bool Polygon::GetIsBullet()
+{
+	return __isBullet;
+}
+
+void Polygon::SetIsBullet( bool isBullet )
+{
+	__isBullet = isBullet;
+}
+
+
+// Kinematic Polygons move by their velocity (without gravity) but never receive impulses, which is 
+// what moving platforms and doors want. They only collide with dynamic Polygons.
+bool Polygon::GetIsKinematic()
+{
+	return __isKinematic;
+}
+
+void Polygon::SetIsKinematic( bool isKinematic )
+{
+	__isKinematic = isKinematic;
+	UpdateInverseMass();
+}
+
+
+// Sensors only report overlaps (see IsPolygonColliding()) and never push or get pushed. They ignore
+// other sensors and static Polygons.
+bool Polygon::GetIsSensor()
+{
+	return __isSensor;
+}
+
+void Polygon::SetIsSensor( bool isSensor )
+{
+	__isSensor = isSensor;
+}
+
+
+// Sleeping Polygons have come to rest and are skipped by the World until something wakes them (see 
+// World::WakePolygon()). Static Polygons are always awake.
+bool Polygon::GetIsAwake()
+{
+	return __isAwake;
 }
 
 
@@ -142,12 +933,26 @@ void Polygon::SetMass( float mass )
 }
 
 
+// 0 for static and kinematic Polygons.
+float Polygon::GetInverseMass()
+{
+	return __inverseMass;
+}
+
+
 glm::vec2 Polygon::GetPosition()
 {
 	return __position;
 }
 
 
+// Where the Polygon was at the start of the last step, for rendering in between steps.
+glm::vec2 Polygon::GetPreviousPosition()
+{
+	return __previousPosition;
+}
+
+
 void Polygon::SetPosition( glm::vec2 position )
 {
 	__position = position;
@@ -185,12 +990,25 @@ float Polygon::GetRotationalInertia()
 }
 
 
+// 0 for static and kinematic Polygons.
+float Polygon::GetInverseRotationalInertia()
+{
+	return __inverseRotationalInertia;
+}
+
+
 float Polygon::GetRotation()
 {
 	return __rotation;
 }
 
 
+float Polygon::GetPreviousRotation()
+{
+	return __previousRotation;
+}
+
+
 void Polygon::SetRotation( float rotation )
 {
 	__rotation = rotation;
@@ -258,23 +1076,298 @@ std::vector<glm::vec2>& Polygon::GetGlobalVertices()
 }
 
 
-void Polygon::SetVertices( std::vector<glm::vec2>* vertices )
+// The vertices can come in any order and include duplicate, collinear or concave points: the Polygon
+// takes their convex hull (see BuildConvexHull()). World::SetVertices() splits concave outlines into
+// a compound instead, and only hands convex ones (and anything it can't split) on to here. They are 
+// copied into the vectors this Polygon already has, so reshaping it (or handing it out of the pool 
+// again) only allocates when it gets more vertices than it has ever had.
+void Polygon::SetVertices( const TransportVector2* vertices, int verticesLength )
 {
-	if ( vertices == __vertices )
+	if ( vertices == NULL || verticesLength <= 0 )
 	{
-		return;
+		throw std::exception( "vertices can't be null!" );
 	}
-	if ( vertices == NULL )
+	__shape = ShapeType::Polygon;
+	__radius = 0.0f;
+	BuildConvexHull( vertices, verticesLength );
+	UpdateGlobalVertices();
+	UpdateFaces();
+	UpdateNormals();
+	UpdateCenterOfMass();      // Requires faces to be created.
+	UpdateRotationalInertia(); // Requires center of mass.
+	UpdateGlobalVertices();    // The center of mass moved the local vertices.
+	UpdateIsBox();
+}
+
+
+ShapeType Polygon::GetShape()
+{
+	return __shape;
+}
+
+
+// How far a circle or capsule reaches past its vertices (0 for everything else).
+float Polygon::GetRadius()
+{
+	return __radius;
+}
+
+
+// Makes this Polygon a circle of the given radius around its position. Circles collide with 
+// closed-form tests instead of going through SAT, so they are far cheaper than a many-sided Polygon.
+void Polygon::SetCircle( float radius )
+{
+	SetCapsule( glm::vec2(), glm::vec2(), radius );
+}
+
+
+// Makes this Polygon a capsule: every point within radius of the segment from a to b (in local 
+// space). Like SetVertices(), the shape is moved so the center of mass (the middle of the segment)
+// lands on the position. A segment shorter than the vertex welding distance makes a circle.
+void Polygon::SetCapsule( glm::vec2 a, glm::vec2 b, float radius )
+{
+	if ( !( radius > 0.0f ) )
 	{
-		throw std::exception( "vertices can't be null!" );
+		throw std::exception( "radius has to be greater than 0!" );
 	}
-	if ( __vertices != NULL )
+
+	glm::vec2 halfSegment = 0.5f * ( b - a );
+	__vertices->clear();
+	if ( glm::length( b - a ) <= VERTEX_WELD_DISTANCE )
 	{
-		delete __vertices;
+		__shape = ShapeType::Circle;
+		__vertices->push_back( glm::vec2() );
 	}
-	__vertices = vertices;
+	else
+	{
+		__shape = ShapeType::Capsule;
+		__vertices->push_back( -halfSegment );
+		__vertices->push_back( halfSegment );
+	}
+	__radius = radius;
+	__isBox = false;
 	UpdateGlobalVertices();
 	UpdateFaces();
-	UpdateCenterOfMass();      // Requires faces to be created.
-	UpdateRotationalInertia(); // Requires center of mass.
+	UpdateNormals();
+	UpdateRotationalInertia();
+}
+
+
+// Casts the segment from origin to origin + maxFraction * ( end - origin ) against this Polygon. If it
+// enters the Polygon, writes where along the segment (as a fraction of end - origin) and the outward
+// normal of the face it entered through, and returns true. Segments starting inside don't hit.
+bool Polygon::RayCast( glm::vec2 origin, glm::vec2 end, float maxFraction, float* fraction, glm::vec2* normal )
+{
+	// A compound is hit wherever its nearest piece is.
+	if ( !__pieces.empty() )
+	{
+		bool isHit = false;
+		for ( Polygon* piece : __pieces )
+		{
+			if ( piece->RayCast( origin, end, maxFraction, fraction, normal ) )
+			{
+				maxFraction = *fraction;
+				isHit = true;
+			}
+		}
+		return isHit;
+	}
+	if ( __shape != ShapeType::Polygon )
+	{
+		return RayCastRound( origin, end, maxFraction, fraction, normal );
+	}
+
+	// Bring the segment into local space, where the cached normals live.
+	float cos = glm::cos( __rotation );
+	float sin = glm::sin( __rotation );
+	glm::vec2 localOrigin = origin - __position;
+	localOrigin = glm::vec2( cos * localOrigin.x + sin * localOrigin.y, -sin * localOrigin.x + cos * localOrigin.y );
+	glm::vec2 localDirection = end - origin;
+	localDirection = glm::vec2( cos * localDirection.x + sin * localDirection.y, -sin * localDirection.x + cos * localDirection.y );
+
+	// Clip the segment against each face's half-plane in turn. What's left (if anything) is inside.
+	float lower = 0.0f;
+	float upper = maxFraction;
+	int enteringFace = -1;
+	for ( int i = 0; i < (int)__normals.size(); i++ )
+	{
+		float numerator = glm::dot( __normals[ i ], __vertices->at( i ) - localOrigin );
+		float denominator = glm::dot( __normals[ i ], localDirection );
+
+		if ( denominator == 0.0f )
+		{
+			// Parallel to this face, so either entirely inside its half-plane or entirely outside.
+			if ( numerator < 0.0f )
+			{
+				return false;
+			}
+		}
+		else if ( denominator < 0.0f && numerator < lower * denominator )
+		{
+			// Entering this face's half-plane.
+			lower = numerator / denominator;
+			enteringFace = i;
+		}
+		else if ( denominator > 0.0f && numerator < upper * denominator )
+		{
+			// Leaving this face's half-plane.
+			upper = numerator / denominator;
+		}
+
+		if ( upper < lower )
+		{
+			return false;
+		}
+	}
+
+	if ( enteringFace < 0 )
+	{
+		return false;
+	}
+
+	glm::vec2 localNormal = __normals[ enteringFace ];
+	*fraction = lower;
+	*normal = glm::vec2( cos * localNormal.x - sin * localNormal.y, sin * localNormal.x + cos * localNormal.y );
+	return true;
+}
+
+
+// RayCast() for every lane of packet whose laneHits entry is set, all at once. The face clipping is 
+// done lane by lane without branches (a ray that misses just stops being "alive") so each face is a 
+// single SIMD pass over the packet. On return laneHits says which rays hit, and for those fractions 
+// and normals are filled in like RayCast() would. Returns whether any ray hit. A compound casts the 
+// packet at each piece in turn, clipping packet's maxFraction for every ray that hits one.
+bool Polygon::RayCastPacket( RayPacket& packet, int* laneHits, float* fractions, glm::vec2* normals )
+{
+	const int SIZE = RayPacket::SIZE;
+	if ( !__pieces.empty() )
+	{
+		int isCast[ SIZE ];
+		int pieceHits[ SIZE ];
+		float pieceFractions[ SIZE ];
+		glm::vec2 pieceNormals[ SIZE ];
+		int anyHit = 0;
+		for ( int lane = 0; lane < SIZE; lane++ )
+		{
+			isCast[ lane ] = laneHits[ lane ];
+			laneHits[ lane ] = 0;
+		}
+		for ( Polygon* piece : __pieces )
+		{
+			memcpy( pieceHits, isCast, sizeof( pieceHits ) );
+			if ( !piece->RayCastPacket( packet, pieceHits, pieceFractions, pieceNormals ) )
+			{
+				continue;
+			}
+			for ( int lane = 0; lane < SIZE; lane++ )
+			{
+				if ( pieceHits[ lane ] )
+				{
+					laneHits[ lane ] = 1;
+					fractions[ lane ] = pieceFractions[ lane ];
+					normals[ lane ] = pieceNormals[ lane ];
+					packet.maxFraction[ lane ] = pieceFractions[ lane ];
+					anyHit = 1;
+				}
+			}
+		}
+		return anyHit != 0;
+	}
+	if ( __shape != ShapeType::Polygon )
+	{
+		// Circles and capsules have no faces to clip against, so their lanes are cast one by one.
+		int anyHit = 0;
+		for ( int lane = 0; lane < SIZE; lane++ )
+		{
+			if ( laneHits[ lane ] )
+			{
+				glm::vec2 origin = glm::vec2( packet.originX[ lane ], packet.originY[ lane ] );
+				glm::vec2 end = origin + glm::vec2( packet.directionX[ lane ], packet.directionY[ lane ] );
+				laneHits[ lane ] = RayCastRound( origin, end, packet.maxFraction[ lane ], &fractions[ lane ], &normals[ lane ] ) ? 1 : 0;
+				anyHit |= laneHits[ lane ];
+			}
+		}
+		return anyHit != 0;
+	}
+
+	float cos = glm::cos( __rotation );
+	float sin = glm::sin( __rotation );
+
+	float localOriginX[ SIZE ];
+	float localOriginY[ SIZE ];
+	float localDirectionX[ SIZE ];
+	float localDirectionY[ SIZE ];
+	float lower[ SIZE ];
+	float upper[ SIZE ];
+	int enteringFace[ SIZE ];
+	int isAlive[ SIZE ];
+	for ( int lane = 0; lane < SIZE; lane++ )
+	{
+		float originX = packet.originX[ lane ] - __position.x;
+		float originY = packet.originY[ lane ] - __position.y;
+		localOriginX[ lane ] = cos * originX + sin * originY;
+		localOriginY[ lane ] = -sin * originX + cos * originY;
+		localDirectionX[ lane ] = cos * packet.directionX[ lane ] + sin * packet.directionY[ lane ];
+		localDirectionY[ lane ] = -sin * packet.directionX[ lane ] + cos * packet.directionY[ lane ];
+		lower[ lane ] = 0.0f;
+		upper[ lane ] = packet.maxFraction[ lane ];
+		enteringFace[ lane ] = -1;
+		isAlive[ lane ] = laneHits[ lane ];
+	}
+
+	for ( int i = 0; i < (int)__normals.size(); i++ )
+	{
+		glm::vec2 normal = __normals[ i ];
+		glm::vec2 vertex = __vertices->at( i );
+		for ( int lane = 0; lane < SIZE; lane++ )
+		{
+			float numerator = normal.x * ( vertex.x - localOriginX[ lane ] ) + normal.y * ( vertex.y - localOriginY[ lane ] );
+			float denominator = normal.x * localDirectionX[ lane ] + normal.y * localDirectionY[ lane ];
+			float t = numerator / ( denominator != 0.0f ? denominator : 1.0f );
+
+			// Same cases as RayCast(): entering or leaving this face's half-plane, or parallel to it.
+			int isEntering = denominator < 0.0f && t > lower[ lane ];
+			int isLeaving = denominator > 0.0f && t < upper[ lane ];
+			int isParallelOutside = denominator == 0.0f && numerator < 0.0f;
+			lower[ lane ] = isEntering ? t : lower[ lane ];
+			enteringFace[ lane ] = isEntering ? i : enteringFace[ lane ];
+			upper[ lane ] = isLeaving ? t : upper[ lane ];
+			isAlive[ lane ] &= !isParallelOutside & ( upper[ lane ] >= lower[ lane ] );
+		}
+	}
+
+	int anyHit = 0;
+	for ( int lane = 0; lane < SIZE; lane++ )
+	{
+		laneHits[ lane ] = isAlive[ lane ] & ( enteringFace[ lane ] >= 0 );
+		anyHit |= laneHits[ lane ];
+		if ( laneHits[ lane ] )
+		{
+			glm::vec2 localNormal = __normals[ enteringFace[ lane ] ];
+			fractions[ lane ] = lower[ lane ];
+			normals[ lane ] = glm::vec2( cos * localNormal.x - sin * localNormal.y, sin * localNormal.x + cos * localNormal.y );
+		}
+	}
+	return anyHit != 0;
+}
+
+
+// Whether this Polygon is made of several convex pieces (see World::SetVertices()). Its own vertices 
+// and faces are then the convex hull around the pieces.
+bool Polygon::GetIsCompound()
+{
+	return !__pieces.empty();
+}
+
+
+// How many convex pieces this Polygon is made of. A Polygon that isn't a compound is its own piece.
+int Polygon::GetPieceCount()
+{
+	return __pieces.empty() ? 1 : (int)__pieces.size();
+}
+
+
+Polygon* Polygon::GetPiece( int index )
+{
+	return __pieces.empty() ? this : __pieces.at( index );
 }
@@ -1,48 +1,132 @@
 #pragma once
 #include <vector>
 #include <glm.hpp>
+#include "POLYGON_HANDLE.c"
+#include "TransportVector2.c"
+#include "AABB.h"
+#include "PieceTree.h"
 
 class Face;
+struct RayPacket;
+
+// What a Polygon's local vertices describe. A Polygon is the convex hull of its vertices, a Circle 
+// is the disc of __radius around its single vertex and a Capsule is every point within __radius of 
+// the segment between its two vertices (see Polygon::SetCapsule()).
+enum class ShapeType : int
+{
+	Polygon,
+	Circle,
+	Capsule
+};
 
 class Polygon
 {
 	friend class World;
+	friend class PolygonPool;
+	friend struct ContactConstraint;
 
 	private:
 
 	std::vector<glm::vec2>* __vertices;
 	std::vector<glm::vec2> __globalVertices;
+	std::vector<glm::vec2> __normals;
 	std::vector<Face> __faces;
 	bool      __useGravity;
 	bool	  __isStatic;
+	bool      __isDeterministic;
+	bool      __isBullet;
+	bool      __isKinematic;
+	bool      __isSensor;
 	float     __mass;
 	float     __rotationalInertia;
+	float     __inverseMass;
+	float     __inverseRotationalInertia;
 	glm::vec2 __position;
 	glm::vec2 __velocity;
 	float     __rotation;
 	float     __rotationalVelocity;
-
-	Polygon( std::vector<glm::vec2>* vertices, glm::vec2 position, float rotation = 0.0f, float mass = 1.0f, bool useGravity = false, bool isStatic = false );
+	glm::vec2 __previousPosition;
+	float     __previousRotation;
+	AABB      __aabb;
+	POLYGON_HANDLE __handle;
+	int       __proxyId;
+	unsigned int __collisionCategory;
+	unsigned int __collisionMask;
+	int       __contactCount;
+	std::vector<Polygon*> __pieces; // The convex pieces of a compound Polygon (see BuildCompound()).
+	Polygon*  __body;               // The compound Polygon this one is a piece of, or NULL.
+	PieceTree __pieceTree;
+	ShapeType __shape;
+	float     __radius;             // How far a Circle or Capsule reaches past its vertices, 0 otherwise.
+	bool      __isBox;              // Whether the vertices make a rectangle (see UpdateIsBox()).
+	glm::vec2 __halfExtents;        // Half the lengths of a box's first two edges.
+	bool      __isAwake;            // Sleeping Polygons are left out of the step (see World::UpdateSleep()).
+	float     __sleepTime;          // How long the Polygon has been at rest.
+	glm::vec2 __restPosition;       // Where the Polygon was when it came to rest.
+	float     __restRotation;
+	Polygon*  __island;             // Union-find parent while the World groups touching Polygons into islands.
+	bool      __isIslandResting;
+
+	Polygon();
 	~Polygon();
 
+	void Reset( glm::vec2 position, float rotation, float mass, bool useGravity, bool isStatic );
+	void Reserve( int vertexCount );
+
+	void BuildConvexHull( const TransportVector2* vertices, int verticesLength );
+	void BuildConvexHullOfPoints( glm::vec2 firstVertex );
+	void BuildCompound();
+	static bool DecomposeOutline( const TransportVector2* vertices, int verticesLength, std::vector<std::vector<glm::vec2>>& pieces );
+
 	void UpdateCenterOfMass();
 	void UpdateFaces();
+	void UpdateNormals();
+	void UpdateIsBox();
 	void UpdateGlobalVertices();
+	void UpdateGlobalVerticesFixed();
+	void UpdatePieces();
+	AABB GetLocalAABB( AABB aabb );
+	void UpdateAABB();
+	void SetTransform( glm::vec2 position, float rotation );
 	void UpdateRotationalInertia();
+	void UpdateInverseMass();
+	bool RayCastRound( glm::vec2 origin, glm::vec2 end, float maxFraction, float* fraction, glm::vec2* normal );
 
 
 	public:
 
+	POLYGON_HANDLE GetHandle();
+	AABB GetAABB();
+
+	unsigned int GetCollisionCategory();
+	unsigned int GetCollisionMask();
+
 	bool GetUseGravity();
 	void SetUseGravity( bool useGravity );
 
 	bool GetIsStatic();
 	void SetIsStatic( bool isStatic );
 
+	bool GetIsDeterministic();
+	void SetIsDeterministic( bool isDeterministic );
+
+	bool GetIsBullet();
+	void SetIsBullet( bool isBullet );
+
+	bool GetIsKinematic();
+	void SetIsKinematic( bool isKinematic );
+
+	bool GetIsSensor();
+	void SetIsSensor( bool isSensor );
+
+	bool GetIsAwake();
+
 	float GetMass();
 	void SetMass( float mass );
+	float GetInverseMass();
 
 	glm::vec2 GetPosition();
+	glm::vec2 GetPreviousPosition();
 	void SetPosition( glm::vec2 position );
 	void Translate( glm::vec2 dPosition );
 
@@ -51,8 +135,10 @@ class Polygon
 	void Accelerate( glm::vec2 dVelocity );
 
 	float GetRotationalInertia();
+	float GetInverseRotationalInertia();
 
 	float GetRotation();
+	float GetPreviousRotation();
 	void SetRotation( float rotation );
 	void Rotate( float dRotation );
 
@@ -67,5 +153,39 @@ class Polygon
 	glm::vec2 GetGlobalVertex( int index );
 	std::vector<glm::vec2>& GetVertices();
 	std::vector<glm::vec2>& GetGlobalVertices();
-	void SetVertices( std::vector<glm::vec2>* vertices );
+	void SetVertices( const TransportVector2* vertices, int verticesLength );
+
+	ShapeType GetShape();
+	float GetRadius();
+	void SetCircle( float radius );
+	void SetCapsule( glm::vec2 a, glm::vec2 b, float radius );
+
+	bool GetIsCompound();
+	int GetPieceCount();
+	Polygon* GetPiece( int index );
+
+	// Calls callback( piece ) for every piece (see GetPiece()) whose box overlaps aabb, until callback
+	// returns false. A compound only looks at the pieces its PieceTree finds near aabb.
+	template<typename T>
+	void QueryPieces( AABB aabb, T& callback )
+	{
+		if( __pieces.empty() )
+		{
+			if( __aabb.Overlaps( aabb ) )
+			{
+				callback( this );
+			}
+			return;
+		}
+
+		auto testPiece = [&]( int index )
+		{
+			Polygon* piece = __pieces[ index ];
+			return !piece->__aabb.Overlaps( aabb ) || callback( piece );
+		};
+		__pieceTree.Query( GetLocalAABB( aabb ), testPiece );
+	}
+
+	bool RayCast( glm::vec2 origin, glm::vec2 end, float maxFraction, float* fraction, glm::vec2* normal );
+	bool RayCastPacket( RayPacket& packet, int* laneHits, float* fractions, glm::vec2* normals );
 };
@@ -0,0 +1,12 @@
+#pragma once
+
+// Bits of the flags PolygonCreateBatch() takes for each Polygon, with the same meaning as the
+// matching PolygonCreate() arguments and PolygonSet*() calls.
+enum PolygonFlags
+{
+	POLYGON_USE_GRAVITY = 1,
+	POLYGON_IS_STATIC = 2,
+	POLYGON_IS_KINEMATIC = 4,
+	POLYGON_IS_SENSOR = 8,
+	POLYGON_IS_BULLET = 16
+};
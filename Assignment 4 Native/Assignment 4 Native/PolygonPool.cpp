@@ -0,0 +1,140 @@
+#include "PolygonPool.h"
+#include "Polygon.h"
+
+// PolygonPool
+
+// PRIVATE
+
+// Builds BLOCK_SIZE more Polygons, each with room for RESERVED_VERTEX_COUNT vertices, and frees them.
+void PolygonPool::AddPolygonBlock()
+{
+	Polygon* block = new Polygon[ BLOCK_SIZE ];
+	__blocks.push_back( block );
+	__polygonCapacity += BLOCK_SIZE;
+	__freePolygons.reserve( __polygonCapacity );
+	for( int i = BLOCK_SIZE - 1; i >= 0; i-- )
+	{
+		block[ i ].Reserve( RESERVED_VERTEX_COUNT );
+		__freePolygons.push_back( block + i );
+	}
+}
+
+
+// Carves BLOCK_SIZE more nodes out of one allocation and puts them on the free list.
+void PolygonPool::AddNodeBlock()
+{
+	char* block = new char[ BLOCK_SIZE * NODE_SIZE ];
+	__nodeBlocks.push_back( block );
+	__nodeCapacity += BLOCK_SIZE;
+	for( int i = BLOCK_SIZE - 1; i >= 0; i-- )
+	{
+		void* node = block + i * NODE_SIZE;
+		*(void**)node = __freeNodes;
+		__freeNodes = node;
+	}
+}
+
+
+// PUBLIC
+
+PolygonPool::PolygonPool()
+	: __blocks( std::vector<Polygon*>() )
+	, __freePolygons( std::vector<Polygon*>() )
+	, __nodeBlocks( std::vector<char*>() )
+	, __freeNodes( NULL )
+	, __polygonCapacity( 0 )
+	, __nodeCapacity( 0 )
+{
+}
+
+
+PolygonPool::~PolygonPool()
+{
+	for( Polygon* block : __blocks )
+	{
+		delete[] block;
+	}
+	for( char* block : __nodeBlocks )
+	{
+		delete[] block;
+	}
+}
+
+
+// Hands out a free Polygon (building another block of them first if there are none left). It still
+// has whatever shape it had last, so Reset() it and give it vertices before using it.
+Polygon* PolygonPool::Acquire()
+{
+	if( __freePolygons.empty() )
+	{
+		AddPolygonBlock();
+	}
+	Polygon* polygon = __freePolygons.back();
+	__freePolygons.pop_back();
+	return polygon;
+}
+
+
+// Gives a Polygon taken with Acquire() back to the pool.
+void PolygonPool::Release( Polygon* polygon )
+{
+	__freePolygons.push_back( polygon );
+}
+
+
+void* PolygonPool::AllocateNode( size_t bytes )
+{
+	if( bytes > NODE_SIZE )
+	{
+		return new char[ bytes ];
+	}
+	if( __freeNodes == NULL )
+	{
+		AddNodeBlock();
+	}
+	void* node = __freeNodes;
+	__freeNodes = *(void**)node;
+	return node;
+}
+
+
+// bytes has to match what the node was allocated with, so it goes back where it came from.
+void PolygonPool::FreeNode( void* node, size_t bytes )
+{
+	if( bytes > NODE_SIZE )
+	{
+		delete[] (char*)node;
+		return;
+	}
+	*(void**)node = __freeNodes;
+	__freeNodes = node;
+}
+
+
+// Grows the pool until it holds at least polygonCount Polygons (and as many map nodes), so that many 
+// can be alive at once without the pool touching the heap again.
+void PolygonPool::Reserve( int polygonCount )
+{
+	while( __polygonCapacity < polygonCount )
+	{
+		AddPolygonBlock();
+	}
+	// One extra node for the map's own head node.
+	while( __nodeCapacity < polygonCount + 1 )
+	{
+		AddNodeBlock();
+	}
+}
+
+
+// How many Polygons the pool holds, in use or not.
+int PolygonPool::GetCapacity()
+{
+	return __polygonCapacity;
+}
+
+
+int PolygonPool::GetFreeCount()
+{
+	return (int)__freePolygons.size();
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+class Polygon;
+
+// Fixed-block pool the World takes its Polygons from, so spawning and destroying them is a push or
+// pop on a free list instead of a trip to the heap. Polygons are built BLOCK_SIZE at a time and are
+// never destroyed while the pool is alive: a released Polygon keeps its vertex, normal and face 
+// vectors, so handing it out again only allocates if it needs more vertices than it ever had.
+// The pool also hands out the small fixed-size nodes of the World's handle map (see 
+// PolygonPoolAllocator), which would otherwise be one more allocation per Polygon.
+class PolygonPool
+{
+	private:
+
+	std::vector<Polygon*> __blocks;
+	std::vector<Polygon*> __freePolygons;
+	std::vector<char*> __nodeBlocks;
+	void* __freeNodes; // Each free node starts with a pointer to the next one.
+	int __polygonCapacity;
+	int __nodeCapacity;
+
+	void AddPolygonBlock();
+	void AddNodeBlock();
+
+	public:
+
+	static const int BLOCK_SIZE = 64;
+	static const int RESERVED_VERTEX_COUNT = 8;
+	static const size_t NODE_SIZE = 64;
+
+	PolygonPool();
+	~PolygonPool();
+
+	Polygon* Acquire();
+	void Release( Polygon* polygon );
+
+	void* AllocateNode( size_t bytes );
+	void FreeNode( void* node, size_t bytes );
+
+	void Reserve( int polygonCount );
+	int GetCapacity();
+	int GetFreeCount();
+};
+
+// Standard allocator that takes single nodes of up to PolygonPool::NODE_SIZE bytes from a PolygonPool
+// and anything else from the heap. The World's handle map uses it, so each node it needs for a new
+// Polygon comes off the pool's free list.
+template<typename T>
+class PolygonPoolAllocator
+{
+	public:
+
+	typedef T value_type;
+
+	PolygonPool* pool;
+
+	PolygonPoolAllocator( PolygonPool* pool )
+		: pool( pool )
+	{
+	}
+
+	template<typename U>
+	PolygonPoolAllocator( const PolygonPoolAllocator<U>& other )
+		: pool( other.pool )
+	{
+	}
+
+	T* allocate( size_t count )
+	{
+		return (T*)pool->AllocateNode( count * sizeof( T ) );
+	}
+
+	void deallocate( T* items, size_t count )
+	{
+		pool->FreeNode( items, count * sizeof( T ) );
+	}
+
+	template<typename U>
+	bool operator==( const PolygonPoolAllocator<U>& other ) const
+	{
+		return pool == other.pool;
+	}
+
+	template<typename U>
+	bool operator!=( const PolygonPoolAllocator<U>& other ) const
+	{
+		return pool != other.pool;
+	}
+};
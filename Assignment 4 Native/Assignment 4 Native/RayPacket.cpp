@@ -0,0 +1,56 @@
+#include "RayPacket.h"
+#include <algorithm>
+#include <cfloat>
+
+
+// Every lane starts out unused.
+RayPacket::RayPacket()
+{
+	for( int lane = 0; lane < SIZE; lane++ )
+	{
+		originX[ lane ] = 0.0f;
+		originY[ lane ] = 0.0f;
+		directionX[ lane ] = 0.0f;
+		directionY[ lane ] = 0.0f;
+		inverseDirectionX[ lane ] = FLT_MAX;
+		inverseDirectionY[ lane ] = FLT_MAX;
+		maxFraction[ lane ] = -1.0f;
+		mask[ lane ] = 0;
+	}
+}
+
+
+// Put the segment from origin to end into lane. Axis-parallel segments get FLT_MAX rather than 
+// infinity as their inverse direction so the slab test never multiplies infinity by zero.
+void RayPacket::SetRay( int lane, glm::vec2 origin, glm::vec2 end, unsigned int rayMask )
+{
+	glm::vec2 direction = end - origin;
+	originX[ lane ] = origin.x;
+	originY[ lane ] = origin.y;
+	directionX[ lane ] = direction.x;
+	directionY[ lane ] = direction.y;
+	inverseDirectionX[ lane ] = direction.x != 0.0f ? 1.0f / direction.x : FLT_MAX;
+	inverseDirectionY[ lane ] = direction.y != 0.0f ? 1.0f / direction.y : FLT_MAX;
+	maxFraction[ lane ] = 1.0f;
+	mask[ lane ] = rayMask;
+}
+
+
+// Slab test of every lane against aabb at once. Sets laneHits[ lane ] to 1 for each ray that passes 
+// through the box before its maxFraction (0 otherwise) and returns whether any of them did.
+bool RayPacket::TestAABB( AABB aabb, int* laneHits )
+{
+	int anyHit = 0;
+	for( int lane = 0; lane < SIZE; lane++ )
+	{
+		float tx1 = ( aabb.lower.x - originX[ lane ] ) * inverseDirectionX[ lane ];
+		float tx2 = ( aabb.upper.x - originX[ lane ] ) * inverseDirectionX[ lane ];
+		float ty1 = ( aabb.lower.y - originY[ lane ] ) * inverseDirectionY[ lane ];
+		float ty2 = ( aabb.upper.y - originY[ lane ] ) * inverseDirectionY[ lane ];
+		float entry = std::max( std::max( std::min( tx1, tx2 ), std::min( ty1, ty2 ) ), 0.0f );
+		float exit = std::min( std::min( std::max( tx1, tx2 ), std::max( ty1, ty2 ) ), maxFraction[ lane ] );
+		laneHits[ lane ] = entry <= exit ? 1 : 0;
+		anyHit |= laneHits[ lane ];
+	}
+	return anyHit != 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <glm.hpp>
+#include "AABB.h"
+
+// A small bundle of rays traced through the broadphase together, so a box is fetched and tested once
+// for all of them rather than once per ray. Rays are stored structure-of-arrays and every loop over 
+// the lanes is branch-free with a fixed trip count, so the compiler turns them into SIMD. Each ray is
+// the segment from origin to origin + maxFraction * direction. Unused lanes have a negative 
+// maxFraction and never hit anything.
+struct RayPacket
+{
+	static const int SIZE = 8;
+
+	float originX[ SIZE ];
+	float originY[ SIZE ];
+	float directionX[ SIZE ];
+	float directionY[ SIZE ];
+	float inverseDirectionX[ SIZE ];
+	float inverseDirectionY[ SIZE ];
+	float maxFraction[ SIZE ];
+	unsigned int mask[ SIZE ];
+
+	RayPacket();
+
+	void SetRay( int lane, glm::vec2 origin, glm::vec2 end, unsigned int mask );
+	bool TestAABB( AABB aabb, int* laneHits );
+};
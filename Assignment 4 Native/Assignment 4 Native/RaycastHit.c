@@ -0,0 +1,13 @@
+#pragma once
+#include "POLYGON_HANDLE.c"
+#include "TransportVector2.c"
+
+// C-style is important! No methods allowed because of __declspec( dllexport )!
+// What WorldRaycast() hit. handle is 0 when the ray didn't hit anything.
+struct RaycastHit
+{
+	POLYGON_HANDLE handle;
+	struct TransportVector2 point;
+	struct TransportVector2 normal;
+	float fraction;
+};
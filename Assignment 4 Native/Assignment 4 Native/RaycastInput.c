@@ -0,0 +1,12 @@
+#pragma once
+#include "TransportVector2.c"
+
+// C-style is important! No methods allowed because of __declspec( dllexport )!
+// One ray for WorldRaycastBatch(), with the same meaning as the arguments of WorldRaycast().
+struct RaycastInput
+{
+	struct TransportVector2 origin;
+	struct TransportVector2 direction;
+	float maxDistance;
+	unsigned int mask;
+};
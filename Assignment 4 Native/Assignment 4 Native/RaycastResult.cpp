@@ -0,0 +1,10 @@
+#include "RaycastResult.h"
+
+
+RaycastResult::RaycastResult()
+	: polygon( NULL )
+	, point( glm::vec2() )
+	, normal( glm::vec2() )
+	, fraction( 1.0f )
+{
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <glm.hpp>
+
+class Polygon;
+
+// The closest Polygon hit by World::Raycast(), where the ray hit it, the outward normal of the face 
+// it hit and how far along the ray (as a fraction of its maximum distance) the hit is.
+struct RaycastResult
+{
+	Polygon* polygon;
+	glm::vec2 point;
+	glm::vec2 normal;
+	float fraction;
+
+	RaycastResult();
+};
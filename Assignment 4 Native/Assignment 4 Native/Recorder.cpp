@@ -0,0 +1,67 @@
+#include "Recorder.h"
+
+// PRIVATE
+
+Recorder::Recorder( const char* path )
+	: __file( path, std::ios::binary | std::ios::trunc )
+	, __buffer( std::vector<char>() )
+{
+	__buffer.reserve( BUFFER_SIZE );
+}
+
+
+
+// PUBLIC
+
+// Flushes whatever is still buffered and closes the log.
+Recorder::~Recorder()
+{
+	Flush();
+}
+
+
+// Opens (and truncates) the log at path. Returns NULL if the file can't be opened.
+Recorder* Recorder::Open( const char* path )
+{
+	Recorder* recorder = new Recorder( path );
+	if( !recorder->__file.is_open() )
+	{
+		delete recorder;
+		return NULL;
+	}
+	return recorder;
+}
+
+
+// Appends length bytes to the log. Anything bigger than the buffer (snapshots) goes straight to disk.
+void Recorder::Write( const void* data, int length )
+{
+	if( __buffer.size() + length > BUFFER_SIZE )
+	{
+		Flush();
+	}
+	if( length > BUFFER_SIZE )
+	{
+		__file.write( (const char*)data, length );
+		return;
+	}
+	const char* bytes = (const char*)data;
+	__buffer.insert( __buffer.end(), bytes, bytes + length );
+}
+
+
+void Recorder::WriteCall( RecordedCall call )
+{
+	Write( (unsigned char)call );
+}
+
+
+void Recorder::Flush()
+{
+	if( !__buffer.empty() )
+	{
+		__file.write( __buffer.data(), __buffer.size() );
+		__buffer.clear();
+	}
+	__file.flush();
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include <fstream>
+#include <vector>
+
+// Every extern "C" call a Recorder can log. The values are written to the log, so only ever append.
+enum class RecordedCall : unsigned char
+{
+	WorldUpdate,
+	WorldSetDeterministic,
+	WorldGetStateHash,
+	WorldGetSnapshotSize,
+	WorldSnapshot,
+	WorldRestore,
+	PolygonCreate,
+	PolygonDestroy,
+	PolygonSetVertices,
+	PolygonGetMass,
+	PolygonSetMass,
+	PolygonGetRotationalInertia,
+	PolygonGetPosition,
+	PolygonSetPosition,
+	PolygonTranslate,
+	PolygonGetVelocity,
+	PolygonSetVelocity,
+	PolygonAccelerate,
+	PolygonGetRotation,
+	PolygonSetRotation,
+	PolygonRotate,
+	PolygonGetRotationalVelocity,
+	PolygonSetRotationalVelocity,
+	PolygonAccelerateRotation,
+	IsPolygonColliding,
+	PolygonGetCollisionCategory,
+	PolygonGetCollisionMask,
+	PolygonSetCollisionFilter,
+	WorldRaycast,
+	WorldRaycastBatch,
+	WorldQueryAABB,
+	WorldQueryPolygon,
+	PolygonGetIsBullet,
+	PolygonSetIsBullet,
+	WorldGetSubstepCount,
+	WorldSetSubstepCount,
+	PolygonGetIsKinematic,
+	PolygonSetIsKinematic,
+	PolygonGetIsSensor,
+	PolygonSetIsSensor,
+	WorldGetContacts,
+	WorldGetCollidingPolygons,
+	WorldGetInterpolationAlpha,
+	WorldGetMaxStepsPerUpdate,
+	WorldSetMaxStepsPerUpdate,
+	PolygonGetPreviousPosition,
+	PolygonGetPreviousRotation,
+	WorldGetAllocationCheck,
+	WorldSetAllocationCheck,
+	WorldReserve,
+	PolygonCreateCompound,
+	PolygonCreateCircle,
+	PolygonCreateCapsule,
+	WorldGetSleepEnabled,
+	WorldSetSleepEnabled,
+	PolygonGetIsAwake,
+	PolygonCreateBatch
+};
+
+// A recording starts with this header, followed by a World snapshot of snapshotLength bytes holding
+// the state of the World when recording began. After that come the calls: each one is a single 
+// RecordedCall byte followed by its arguments in declaration order. Arrays are written as an int 
+// length followed by the elements.
+struct RecordingHeader
+{
+	char magic[ 4 ];
+	unsigned int version;
+	float fixedTimestepSeconds;
+	float gravityAcceleration;
+	int isDeterministic;
+	int substepCount;
+	int maxStepsPerUpdate;
+	int isSleepEnabled;
+	int snapshotLength;
+};
+
+static const char RECORDING_MAGIC[ 4 ] = { 'N', 'P', 'R', 'C' };
+static const unsigned int RECORDING_VERSION = 4;
+
+// Streams the calls made on one World into a binary log so the exact workload can be replayed 
+// offline (see the --replay mode of ConsoleTester). Writes are collected in memory and only hit the 
+// file once BUFFER_SIZE bytes have piled up, so recording costs next to nothing per call.
+class Recorder
+{
+	private:
+
+	std::ofstream __file;
+	std::vector<char> __buffer;
+
+	Recorder( const char* path );
+
+
+	public:
+
+	static const int BUFFER_SIZE = 64 * 1024;
+
+	~Recorder();
+
+	static Recorder* Open( const char* path );
+
+	void Write( const void* data, int length );
+	void WriteCall( RecordedCall call );
+	void Flush();
+
+	template<typename T>
+	void Write( T value )
+	{
+		Write( &value, sizeof( T ) );
+	}
+
+	template<typename T>
+	void WriteArray( const T* values, int length )
+	{
+		Write( length );
+		Write( values, length * sizeof( T ) );
+	}
+};
@@ -0,0 +1,5 @@
+#pragma once
+
+// Opaque pointer to a native World, handed out by WorldCreate(). C-style so it can cross the
+// extern "C" interface (it arrives in Unity as an IntPtr).
+typedef void* WORLD_HANDLE;
\ No newline at end of file
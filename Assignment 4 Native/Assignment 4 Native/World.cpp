@@ -1,245 +1,3110 @@
 #include "World.h"
+#include "AllocationCounter.h"
 #include "Collision.h"
 #include "Face.h"
+#include "Fixed.h"
+#include "Recorder.h"
+#include "RaycastResult.h"
+#include "RayPacket.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+// SNAPSHOT LAYOUT
+
+// A snapshot is one SnapshotHeader, followed by one PolygonSnapshot per Polygon in handle order, 
+// followed by every Polygon's local vertices back to back, followed by the vertex count of every 
+// compound's pieces (in the same order), then the pieces' local vertices back to back, one 
+// ContactSnapshot per contact between sleeping Polygons (which later steps don't look for again) and
+// finally the sorted keys of every pair touching in the last step (so the step after a rollback 
+// reports them as CONTACT_PERSIST rather than CONTACT_BEGIN, see RecordContactEvents()).
+// Everything is plain old data so saving and restoring are little more than memcpy()s. Every field 
+// is 4 or 8 bytes wide and aligned, so there is no padding and the same World always produces the 
+// same bytes.
+static const unsigned int SNAPSHOT_VERSION = 9;
+
+struct SnapshotHeader
+{
+	unsigned int version;
+	int polygonCount;
+	int vertexCount;
+	int pieceCount;
+	int pieceVertexCount;
+	POLYGON_HANDLE nextHandle;
+	float accumulatedTimeSeconds;
+	float currentTimeSeconds;
+	int sleepingContactCount;
+	int contactKeyCount;
+	unsigned long long stateHash;
+};
+
+struct PolygonSnapshot
+{
+	POLYGON_HANDLE handle;
+	int vertexCount;
+	int pieceCount;
+	glm::vec2 position;
+	glm::vec2 velocity;
+	float rotation;
+	float rotationalVelocity;
+	float mass;
+	float rotationalInertia;
+	int useGravity;
+	int isStatic;
+	unsigned int collisionCategory;
+	unsigned int collisionMask;
+	int isBullet;
+	int isKinematic;
+	int isSensor;
+	int shape;
+	float radius;
+	int isAwake;
+	float sleepTime;
+	glm::vec2 restPosition;
+	float restRotation;
+};
+
+struct ContactSnapshot
+{
+	POLYGON_HANDLE faceHandle;
+	POLYGON_HANDLE contactHandle;
+	glm::vec2 faceNormal;
+	glm::vec2 contactVertex;
+	float depth;
+	float impulse;
+};
+
+// Does one of the polygonCount PolygonSnapshots at polygonRecords (in handle order, the way Snapshot()
+// writes them) belong to handle?
+static bool HasPolygonRecord( const char* polygonRecords, int polygonCount, POLYGON_HANDLE handle )
+{
+	int low = 0;
+	int high = polygonCount - 1;
+	while( low <= high )
+	{
+		int middle = low + ( high - low ) / 2;
+		PolygonSnapshot state;
+		memcpy( &state, polygonRecords + middle * sizeof( PolygonSnapshot ), sizeof( PolygonSnapshot ) );
+		if( state.handle == handle )
+		{
+			return true;
+		}
+		if( state.handle < handle )
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle - 1;
+		}
+	}
+	return false;
+}
+
+// CONTINUOUS COLLISION
+
+// A bullet counts as having reached another Polygon once they are closer than this.
+static const float CCD_TOLERANCE = 0.0025f;
+
+// How far past the time of impact a bullet is pushed, so that it overlaps what it hit and the next 
+// step's SAT test picks the contact up and responds to it.
+static const float CCD_SLOP = 0.01f;
+
+// Conservative advancement gives up (keeping the safe time it has reached) after this many iterations.
+static const int CCD_MAX_ITERATIONS = 20;
+
+
+// SOFT CONTACT SOLVER
+
+// Stiffness of soft contacts, capped at a quarter of the sub-step rate so they can't get too stiff 
+// for the sub-step to resolve. The heavy damping keeps them from bouncing.
+static const float SOFT_CONTACT_HERTZ = 30.0f;
+static const float TWO_PI = 6.28318531f;
+static const float SOFT_CONTACT_DAMPING_RATIO = 10.0f;
+
+// The fastest soft contacts will push overlapping Polygons apart.
+static const float SOFT_CONTACT_PUSH_VELOCITY = 3.0f;
+
+// Same restitution as CollisionResponse(), but only for contacts closing faster than the threshold.
+static const float SOFT_CONTACT_RESTITUTION = 1.0f;
+static const float SOFT_CONTACT_RESTITUTION_THRESHOLD = 1.0f;
+
+
+// SLEEPING
+
+// A Polygon counts as resting while no component of its velocity is faster than these and it hasn't 
+// drifted further than the drifts from where it came to rest. The solvers leave resting contacts 
+// rocking back and forth a little, which the drifts see through, while anything creeping along 
+// slowly still gets its rest timer reset once it has moved far enough. Comparing components (instead
+// of lengths) keeps the test exact, so deterministic Worlds agree on it.
+static const float SLEEP_LINEAR_TOLERANCE = 0.25f;
+static const float SLEEP_ANGULAR_TOLERANCE = 0.5f;
+static const float SLEEP_LINEAR_DRIFT = 0.01f;
+static const float SLEEP_ANGULAR_DRIFT = 0.02f;
+
+// How long every Polygon of an island has to rest before the island falls asleep.
+static const float TIME_TO_SLEEP = 0.5f;
+
+
+// POSITION CORRECTION
+
+// How many NGS iterations CorrectPositions() may take, how much of the overlap each one removes, 
+// how much overlap is left alone (so resting contacts stay in contact) and the most a single 
+// iteration may move a contact.
+static const int POSITION_CORRECTION_ITERATIONS = 3;
+static const float POSITION_CORRECTION_BAUMGARTE = 0.2f;
+static const float POSITION_CORRECTION_SLOP = 0.005f;
+static const float POSITION_CORRECTION_MAX = 0.2f;
+
+
+// BATCH RAYCASTS
+
+// RaycastBatch() doesn't start a thread for fewer rays than this, since starting one costs about as
+// much as tracing a few hundred rays.
+static const int MIN_BATCH_RAYS_PER_THREAD = 256;
+
+
+// BATCH CREATION
+
+// CreatePolygonBatch() doesn't start a thread for fewer Polygons than this.
+static const int MIN_BATCH_POLYGONS_PER_THREAD = 1024;
+
+
+// CONTACT EVENTS
+
+// The contact lists that outlive a step (see ReserveContacts()) start out with room for this many, so
+// small scenes never grow them mid-step. Reserve() makes room for RESERVED_CONTACTS_PER_POLYGON times
+// its capacity. Each box in a tightly packed pile touches up to four others, two pairs per box, and 
+// pairs coming and going during a step add a BEGIN or END event on top.
+static const int INITIAL_CONTACT_CAPACITY = 256;
+static const int RESERVED_CONTACTS_PER_POLYGON = 4;
+
+// The key RecordContactEvents() tracks a touching pair by: both handles, the lower one on top.
+static unsigned long long GetContactKey( Collision collision )
+{
+	unsigned int aHandle = (unsigned int)collision.facePolygon->GetHandle();
+	unsigned int bHandle = (unsigned int)collision.contactPolygon->GetHandle();
+	return ( (unsigned long long)std::min( aHandle, bHandle ) << 32 ) | std::max( aHandle, bHandle );
+}
+
+
+// CIRCLES AND CAPSULES
+
+// The z-component of the 3D cross product of ( a, 0 ) and ( b, 0 ).
+static float Cross( glm::vec2 a, glm::vec2 b )
+{
+	return a.x * b.y - a.y * b.x;
+}
+
+// Fill in collision with a contact found by one of the round shape tests (see World::CollideRound()).
+static void SetContact( Collision* collision, Polygon* facePolygon, Polygon* contactPolygon, glm::vec2 faceNormal, glm::vec2 contactVertex, float depth )
+{
+	collision->facePolygon = facePolygon;
+	collision->contactPolygon = contactPolygon;
+	collision->faceNormal = faceNormal;
+	collision->contactVertex = contactVertex;
+	collision->depth = depth;
+}
+
+// The point on the segment from a to b closest to point. The segment may be a single point.
+static glm::vec2 ClosestPointOnSegment( glm::vec2 point, glm::vec2 a, glm::vec2 b )
+{
+	glm::vec2 segment = b - a;
+	float lengthSquared = glm::dot( segment, segment );
+	if( lengthSquared == 0.0f )
+	{
+		return a;
+	}
+	return a + glm::clamp( glm::dot( point - a, segment ) / lengthSquared, 0.0f, 1.0f ) * segment;
+}
+
+static FixedVector2 ClosestPointOnSegment( FixedVector2 point, FixedVector2 a, FixedVector2 b )
+{
+	FixedVector2 segment = b - a;
+	Fixed lengthSquared = FixedVector2::Dot( segment, segment );
+	if( lengthSquared == Fixed() )
+	{
+		return a;
+	}
+	Fixed t = FixedVector2::Dot( point - a, segment ) / lengthSquared;
+	t = t < Fixed() ? Fixed() : ( t > Fixed( 1 ) ? Fixed( 1 ) : t );
+	return a + segment * t;
+}
+
+// The closest pair of points on the segments aStart -> aEnd and bStart -> bEnd (either of which may 
+// be a single point). Segments that cross meet at a point of both; otherwise one of the four ends 
+// is part of the closest pair, so it's the nearest of each end to the other segment.
+static void ClosestPointsOnSegments( glm::vec2 aStart, glm::vec2 aEnd, glm::vec2 bStart, glm::vec2 bEnd, glm::vec2* aPoint, glm::vec2* bPoint )
+{
+	glm::vec2 aSegment = aEnd - aStart;
+	glm::vec2 bSegment = bEnd - bStart;
+	float denominator = Cross( aSegment, bSegment );
+	if( denominator != 0.0f )
+	{
+		float s = Cross( bStart - aStart, bSegment ) / denominator;
+		float t = Cross( bStart - aStart, aSegment ) / denominator;
+		if( s >= 0.0f && s <= 1.0f && t >= 0.0f && t <= 1.0f )
+		{
+			*aPoint = aStart + s * aSegment;
+			*bPoint = *aPoint;
+			return;
+		}
+	}
+
+	glm::vec2 candidates[ 4 ][ 2 ] = {
+		{ aStart, ClosestPointOnSegment( aStart, bStart, bEnd ) },
+		{ aEnd, ClosestPointOnSegment( aEnd, bStart, bEnd ) },
+		{ ClosestPointOnSegment( bStart, aStart, aEnd ), bStart },
+		{ ClosestPointOnSegment( bEnd, aStart, aEnd ), bEnd }
+	};
+	float minDistanceSquared = FLT_MAX;
+	for( auto& candidate : candidates )
+	{
+		glm::vec2 offset = candidate[ 1 ] - candidate[ 0 ];
+		float distanceSquared = glm::dot( offset, offset );
+		if( distanceSquared < minDistanceSquared )
+		{
+			minDistanceSquared = distanceSquared;
+			*aPoint = candidate[ 0 ];
+			*bPoint = candidate[ 1 ];
+		}
+	}
+}
+
+static void ClosestPointsOnSegments( FixedVector2 aStart, FixedVector2 aEnd, FixedVector2 bStart, FixedVector2 bEnd, FixedVector2* aPoint, FixedVector2* bPoint )
+{
+	FixedVector2 aSegment = aEnd - aStart;
+	FixedVector2 bSegment = bEnd - bStart;
+	Fixed denominator = FixedVector2::Cross( aSegment, bSegment );
+	if( !( denominator == Fixed() ) )
+	{
+		Fixed s = FixedVector2::Cross( bStart - aStart, bSegment ) / denominator;
+		Fixed t = FixedVector2::Cross( bStart - aStart, aSegment ) / denominator;
+		if( s >= Fixed() && s <= Fixed( 1 ) && t >= Fixed() && t <= Fixed( 1 ) )
+		{
+			*aPoint = aStart + aSegment * s;
+			*bPoint = *aPoint;
+			return;
+		}
+	}
+
+	FixedVector2 candidates[ 4 ][ 2 ] = {
+		{ aStart, ClosestPointOnSegment( aStart, bStart, bEnd ) },
+		{ aEnd, ClosestPointOnSegment( aEnd, bStart, bEnd ) },
+		{ ClosestPointOnSegment( bStart, aStart, aEnd ), bStart },
+		{ ClosestPointOnSegment( bEnd, aStart, aEnd ), bEnd }
+	};
+	Fixed minDistanceSquared = Fixed::Max();
+	for( auto& candidate : candidates )
+	{
+		FixedVector2 offset = candidate[ 1 ] - candidate[ 0 ];
+		Fixed distanceSquared = FixedVector2::Dot( offset, offset );
+		if( distanceSquared < minDistanceSquared )
+		{
+			minDistanceSquared = distanceSquared;
+			*aPoint = candidate[ 0 ];
+			*bPoint = candidate[ 1 ];
+		}
+	}
+}
+
 
 // PRIVATE
 
-// Returns a new unique HANDLE each time it is called that the World uses to make it possible 
-// to look up Polygons uniquely using integer values.
-POLYGON_HANDLE World::GeneratePolygonHandle()
+// Returns a new unique HANDLE each time it is called that the World uses to make it possible 
+// to look up Polygons uniquely using integer values.
+POLYGON_HANDLE World::GeneratePolygonHandle()
+{
+	return __nextHandle++;
+}
+
+// Hand a Polygon that already has its shape a handle and a broadphase proxy, store it in the 
+// __polygons map so we can look it up by its handle later and return the handle.
+POLYGON_HANDLE World::AddPolygon( Polygon* polygon )
+{
+	auto handle = GeneratePolygonHandle();
+	if( __isDeterministic )
+	{
+		polygon->SetIsDeterministic( true );
+	}
+	polygon->__handle = handle;
+	SynchronizeProxy( polygon );
+	// Handles only ever go up, so the new one always goes at the end of the map.
+	__polygons.emplace_hint( __polygons.end(), handle, polygon );
+	return handle;
+}
+
+// Handles a single physics step.
+// All the per-step lists (collisions, sensor overlaps, pair candidates, contact constraints) live in
+// __frameArena and are thrown away together at the start of the next step. Once the arena (and the 
+// contact lists that outlive a step, see ReserveContacts()) have grown to fit the busiest step so far,
+// stepping makes no heap allocations at all, which is what the allocation check (see 
+// SetIsAllocationCheckEnabled()) is there to catch regressions in.
+void World::Step( float deltaTimeSeconds )
+{
+	unsigned long long allocationCount = AllocationCounter::GetCount();
+
+	// Clean out collisions from last frame.
+	ClearCollisions();
+	ResetFrameArena();
+
+	// Collision detection.
+	FindCollisions();
+
+	// Anything awake that touched a sleeping island wakes all of it up before the solvers run.
+	if( __isSleepEnabled )
+	{
+		WakeIslands();
+	}
+
+	// Sleeping Polygons sit out the rest of the step, so everything after this only walks the awake ones.
+	for( auto aIterator = __polygons.begin(); aIterator != __polygons.end(); ++aIterator )
+	{
+		if( aIterator->second->__isAwake )
+		{
+			__awakePolygons.Add( aIterator->second );
+		}
+	}
+
+	// Both float solvers track this step's contacts with ContactConstraints.
+	if( !__isDeterministic )
+	{
+		for( Collision collision : __collisions )
+		{
+			__contactConstraints.Add( ContactConstraint( collision ) );
+		}
+	}
+
+	if( __substepCount > 0 && !__isDeterministic )
+	{
+		SolveSubstepped( deltaTimeSeconds );
+	}
+	else
+	{
+		// Collision resolution.
+		for( Collision& collision : __collisions )
+		{
+			if( __isDeterministic )
+			{
+				collision.impulse = CollisionResponseFixed( collision.facePolygon, collision.contactPolygon, collision );
+			}
+			else
+			{
+				collision.impulse = CollisionResponse(collision.facePolygon, collision.contactPolygon, collision);		
+			}
+		}
+
+		// Integrate force -> acceleration -> velocity -> position.
+		for( Polygon* polygon : __awakePolygons )
+		{
+			polygon->__previousPosition = polygon->__position;
+			polygon->__previousRotation = polygon->__rotation;
+			if( __isDeterministic )
+			{
+				IntegrateFixed( polygon, deltaTimeSeconds );
+			}
+			else
+			{
+				Integrate( polygon, deltaTimeSeconds );
+			}
+		}
+
+		// Push apart whatever the impulses left overlapping.
+		if( !__isDeterministic )
+		{
+			CorrectPositions();
+		}
+
+		for( Polygon* polygon : __awakePolygons )
+		{
+			SynchronizeProxy( polygon );
+		}
+	}
+
+	// Pull bullets back to wherever they first touched something along the way.
+	for( Polygon* polygon : __awakePolygons )
+	{
+		if( polygon->__isBullet && !polygon->__isSensor )
+		{
+			if( __isDeterministic )
+			{
+				SweepBulletFixed( polygon );
+			}
+			else
+			{
+				SweepBullet( polygon );
+			}
+		}
+	}
+
+	if( __isSleepEnabled )
+	{
+		UpdateSleep( deltaTimeSeconds );
+	}
+
+	RecordContactEvents();
+
+	if( __isDeterministic )
+	{
+		__stateHash = ComputeStateHash();
+	}
+
+	if( __isAllocationCheckEnabled && AllocationCounter::GetCount() != allocationCount )
+	{
+		throw std::exception( "World::Step() allocated on the heap while the allocation check was enabled." );
+	}
+}
+
+// Fills __collisions with every colliding pair (and __sensorOverlaps with every overlapping pair that
+// has a sensor in it). Rather than testing every pair with SAT, each Polygon
+// asks the broadphase for the Polygons whose boxes overlap its own, and pairs whose collision filters
+// don't agree are dropped there before they ever reach TestCollision().
+void World::FindCollisions()
+{
+	for( auto aIterator = __polygons.begin(); aIterator != __polygons.end(); ++aIterator )
+	{
+		Polygon* aPolygon = aIterator->second;
+		if( !IsActive( aPolygon ) )
+		{
+			continue;
+		}
+		unsigned int aCategory = aPolygon->__collisionCategory;
+		unsigned int aMask = aPolygon->__collisionMask;
+
+		__pairCandidates.Clear();
+		auto addCandidate = [&]( int proxyId )
+		{
+			// Every pair is found from both ends, so only keep it from the end with the lower handle.
+			// This skips aPolygon itself as well. Sleeping and static Polygons don't look for pairs at
+			// all, so their pairs are kept from the awake end.
+			// Kinematic Polygons only collide with dynamic ones, since nothing else can respond.
+			Polygon* bPolygon = __broadphase.GetPolygon( proxyId );
+			bool isKinematicPair = ( aPolygon->__isKinematic || bPolygon->__isKinematic ) && aPolygon->__inverseMass == 0.0f && bPolygon->__inverseMass == 0.0f;
+			// Sensors don't trigger each other, and static Polygons (the level) don't trigger sensors.
+			bool isIgnoredSensorPair = ( aPolygon->__isSensor && ( bPolygon->__isSensor || bPolygon->__isStatic ) ) || ( bPolygon->__isSensor && aPolygon->__isStatic );
+			if( ( bPolygon->__handle > aPolygon->__handle || !IsActive( bPolygon ) ) && !isKinematicPair && !isIgnoredSensorPair && DynamicTree::ShouldCollide( aCategory, aMask, __broadphase.GetCategory( proxyId ), __broadphase.GetMask( proxyId ) ) )
+			{
+				__pairCandidates.Add( bPolygon );
+			}
+			return true;
+		};
+		__broadphase.Query( aPolygon->__aabb, addCandidate );
+
+		// The shape of the tree depends on the order Polygons were added and moved in, which a restored
+		// snapshot doesn't reproduce. Sorting keeps the pairs (and so the responses) in handle order.
+		std::sort( __pairCandidates.begin(), __pairCandidates.end(), []( Polygon* a, Polygon* b ) { return a->__handle < b->__handle; } );
+
+		// Actually test whether this pair collides and store the collision if so. Pairs with a sensor
+		// never reach the solver, so all they need to know is whether they overlap.
+		for( Polygon* bPolygon : __pairCandidates )
+		{
+			if( aPolygon->__isSensor || bPolygon->__isSensor )
+			{
+				if( TestPieceOverlap( aPolygon, bPolygon ) )
+				{
+					Collision overlap;
+					overlap.facePolygon = aPolygon;
+					overlap.contactPolygon = bPolygon;
+					__sensorOverlaps.Add( overlap );
+					aPolygon->__contactCount++;
+					bPolygon->__contactCount++;
+				}
+				continue;
+			}
+
+			FindPieceCollisions( aPolygon, bPolygon );
+		}
+	}
+}
+
+// Empties __collisions and __sensorOverlaps, zeroing the contact count of every Polygon in them on the
+// way so the counts never need a pass over the whole World.
+void World::ClearCollisions()
+{
+	for( Collision collision : __collisions )
+	{
+		collision.facePolygon->__contactCount = 0;
+		collision.contactPolygon->__contactCount = 0;
+	}
+	for( Collision overlap : __sensorOverlaps )
+	{
+		overlap.facePolygon->__contactCount = 0;
+		overlap.contactPolygon->__contactCount = 0;
+	}
+	for( Collision contact : __sleepingContacts )
+	{
+		contact.facePolygon->__contactCount = 0;
+		contact.contactPolygon->__contactCount = 0;
+	}
+	__collisions.Clear();
+	__sensorOverlaps.Clear();
+
+	// Contacts between sleeping Polygons carry over to this step, unless one of them has been woken
+	// up since (and so will look for the contact itself).
+	auto isWoken = [&]( Collision contact ) { return IsActive( contact.facePolygon ) || IsActive( contact.contactPolygon ); };
+	__sleepingContacts.erase( std::remove_if( __sleepingContacts.begin(), __sleepingContacts.end(), isWoken ), __sleepingContacts.end() );
+	for( Collision contact : __sleepingContacts )
+	{
+		contact.facePolygon->__contactCount++;
+		contact.contactPolygon->__contactCount++;
+	}
+}
+
+// Hands every per-step list's memory back to __frameArena in one go. The lists have to let go of
+// their storage along with it, since the arena is about to give it out again.
+void World::ResetFrameArena()
+{
+	__frameArena.Reset();
+	__collisions.Release();
+	__sensorOverlaps.Release();
+	__pairCandidates.Release();
+	__contactConstraints.Release();
+	__awakePolygons.Release();
+}
+
+// Removes every entry in contacts that involves polygon (which is about to be deleted), taking it off
+// the other Polygon's contact count as well.
+void World::ForgetContacts( FrameList<Collision>& contacts, Polygon* polygon )
+{
+	for( int i = 0; i < contacts.GetCount(); )
+	{
+		Collision& contact = contacts[ i ];
+		if( contact.facePolygon == polygon || contact.contactPolygon == polygon )
+		{
+			Polygon* other = contact.facePolygon == polygon ? contact.contactPolygon : contact.facePolygon;
+			other->__contactCount--;
+			contacts.RemoveAt( i );
+		}
+		else
+		{
+			i++;
+		}
+	}
+}
+
+void World::ForgetContacts( std::vector<Collision>& contacts, Polygon* polygon )
+{
+	for( size_t i = 0; i < contacts.size(); )
+	{
+		Collision& contact = contacts[ i ];
+		if( contact.facePolygon == polygon || contact.contactPolygon == polygon )
+		{
+			Polygon* other = contact.facePolygon == polygon ? contact.contactPolygon : contact.facePolygon;
+			other->__contactCount--;
+			contacts.erase( contacts.begin() + i );
+		}
+		else
+		{
+			i++;
+		}
+	}
+}
+
+// Give a Polygon (and its pieces, if it is a compound) back to __polygonPool.
+void World::ReleasePolygon( Polygon* polygon )
+{
+	ReleasePieces( polygon->__pieces );
+	__polygonPool.Release( polygon );
+}
+
+// Make polygon (which has no pieces) a compound of the convex outlines Polygon::DecomposeOutline()
+// split its outline into, each one a Polygon from __polygonPool.
+void World::SetOutlines( Polygon* polygon, std::vector<std::vector<glm::vec2>>& outlines )
+{
+	for( std::vector<glm::vec2>& outline : outlines )
+	{
+		Polygon* piece = __polygonPool.Acquire();
+		piece->Reset( polygon->__position, polygon->__rotation, 1.0f, false, false );
+		piece->__vertices->assign( outline.begin(), outline.end() );
+		polygon->__pieces.push_back( piece );
+	}
+	polygon->BuildCompound();
+}
+
+// The part of CreatePolygonBatch() that runs on worker threads: gives polygons[ begin ] up to 
+// polygons[ end ] their shapes. Only touches those Polygons, so ranges that don't overlap can run at
+// the same time. Concave outlines are only split up here (into outlines[ i ]), since their pieces
+// have to come from the pool, and whatever Polygon::SetVertices() throws ends up in errors[ i ].
+void World::BuildBatchShapes( Polygon** polygons, const TransportVector2* vertices, const int* vertexOffsets, std::vector<std::vector<glm::vec2>>* outlines, std::exception_ptr* errors, int begin, int end )
+{
+	for( int i = begin; i < end; i++ )
+	{
+		const TransportVector2* polygonVertices = vertices + vertexOffsets[ i ];
+		int verticesLength = vertexOffsets[ i + 1 ] - vertexOffsets[ i ];
+		try
+		{
+			if( !Polygon::DecomposeOutline( polygonVertices, verticesLength, outlines[ i ] ) )
+			{
+				polygons[ i ]->SetVertices( polygonVertices, verticesLength );
+			}
+		}
+		catch( ... )
+		{
+			errors[ i ] = std::current_exception();
+		}
+	}
+}
+
+// Give every Polygon in pieces back to __polygonPool and empty the list.
+void World::ReleasePieces( std::vector<Polygon*>& pieces )
+{
+	for( Polygon* piece : pieces )
+	{
+		__polygonPool.Release( piece );
+	}
+	pieces.clear();
+}
+
+// Resolve this step's collisions and integrate with the soft contact solver (TGS-soft). The step is 
+// split into __substepCount sub-steps that all reuse the collisions found at the start of the step. 
+// Each sub-step integrates velocities, re-applies the impulses accumulated so far, runs a single 
+// velocity iteration with the contacts as soft springs, integrates positions and then runs one more
+// iteration without the springs' push-out (the relax pass). Restitution is applied once at the end.
+// Small sub-steps converge far better than extra iterations, so stacks and big mass ratios stay 
+// stable without shrinking the World's timestep.
+void World::SolveSubstepped( float deltaTimeSeconds )
+{
+	for( Polygon* polygon : __awakePolygons )
+	{
+		polygon->__previousPosition = polygon->__position;
+		polygon->__previousRotation = polygon->__rotation;
+	}
+
+	float substepSeconds = deltaTimeSeconds / __substepCount;
+	float inverseSubstepSeconds = 1.0f / substepSeconds;
+
+	// Turn the contact stiffness into the spring coefficients the solver uses.
+	float contactHertz = std::min( SOFT_CONTACT_HERTZ, 0.25f * inverseSubstepSeconds );
+	float omega = TWO_PI * contactHertz;
+	float a1 = 2.0f * SOFT_CONTACT_DAMPING_RATIO + substepSeconds * omega;
+	float a2 = substepSeconds * omega * a1;
+	float a3 = 1.0f / ( 1.0f + a2 );
+	float biasRate = omega / a1;
+	float massScale = a2 * a3;
+	float impulseScale = a3;
+
+	for( int substep = 0; substep < __substepCount; substep++ )
+	{
+		for( Polygon* polygon : __awakePolygons )
+		{
+			if( polygon->__inverseMass > 0.0f && polygon->__useGravity )
+			{
+				polygon->__velocity.y += __gravityAcceleration * substepSeconds;
+			}
+		}
+
+		for( ContactConstraint& constraint : __contactConstraints )
+		{
+			constraint.WarmStart();
+		}
+		for( ContactConstraint& constraint : __contactConstraints )
+		{
+			constraint.Solve( inverseSubstepSeconds, biasRate, massScale, impulseScale, SOFT_CONTACT_PUSH_VELOCITY, true );
+		}
+
+		// Only the pose changes here. The global vertices wait until the end of the step.
+		for( Polygon* polygon : __awakePolygons )
+		{
+			if( !polygon->__isStatic )
+			{
+				polygon->__position += substepSeconds * polygon->__velocity;
+				polygon->__rotation += substepSeconds * polygon->__rotationalVelocity;
+			}
+		}
+
+		for( ContactConstraint& constraint : __contactConstraints )
+		{
+			constraint.Solve( inverseSubstepSeconds, biasRate, massScale, impulseScale, SOFT_CONTACT_PUSH_VELOCITY, false );
+		}
+	}
+
+	for( int i = 0; i < __contactConstraints.GetCount(); i++ )
+	{
+		__contactConstraints[ i ].ApplyRestitution( SOFT_CONTACT_RESTITUTION, SOFT_CONTACT_RESTITUTION_THRESHOLD );
+		__collisions[ i ].impulse = __contactConstraints[ i ].normalImpulse;
+	}
+
+	for( Polygon* polygon : __awakePolygons )
+	{
+		polygon->UpdateGlobalVertices();
+		SynchronizeProxy( polygon );
+	}
+}
+
+// Turns this step's collisions and sensor overlaps into ContactEvents, appended to the ones from the
+// other steps of the current Update(). A pair is keyed by its two handles (lower first), and the keys
+// are kept sorted so each step can be checked against the one before with binary searches.
+void World::RecordContactEvents()
+{
+	__previousContactKeys.swap( __contactKeys );
+	__contactKeys.clear();
+
+	for( Collision collision : __collisions )
+	{
+		__contactKeys.push_back( GetContactKey( collision ) );
+	}
+	for( Collision overlap : __sensorOverlaps )
+	{
+		__contactKeys.push_back( GetContactKey( overlap ) );
+	}
+	for( Collision contact : __sleepingContacts )
+	{
+		__contactKeys.push_back( GetContactKey( contact ) );
+	}
+	std::sort( __contactKeys.begin(), __contactKeys.end() );
+
+	for( Collision collision : __collisions )
+	{
+		bool wasTouching = std::binary_search( __previousContactKeys.begin(), __previousContactKeys.end(), GetContactKey( collision ) );
+		AddContactEvent( collision, wasTouching ? CONTACT_PERSIST : CONTACT_BEGIN );
+	}
+	for( Collision contact : __sleepingContacts )
+	{
+		bool wasTouching = std::binary_search( __previousContactKeys.begin(), __previousContactKeys.end(), GetContactKey( contact ) );
+		AddContactEvent( contact, wasTouching ? CONTACT_PERSIST : CONTACT_BEGIN );
+	}
+	for( Collision overlap : __sensorOverlaps )
+	{
+		overlap.depth = 0.0f;
+		bool wasTouching = std::binary_search( __previousContactKeys.begin(), __previousContactKeys.end(), GetContactKey( overlap ) );
+		AddContactEvent( overlap, wasTouching ? CONTACT_PERSIST : CONTACT_BEGIN );
+	}
+
+	for( unsigned long long key : __previousContactKeys )
+	{
+		if( !std::binary_search( __contactKeys.begin(), __contactKeys.end(), key ) )
+		{
+			ContactEvent event = {};
+			event.aHandle = (POLYGON_HANDLE)( key >> 32 );
+			event.bHandle = (POLYGON_HANDLE)( key & 0xFFFFFFFF );
+			event.state = CONTACT_END;
+			__contactEvents.push_back( event );
+		}
+	}
+}
+
+void World::AddContactEvent( Collision collision, ContactEventState state )
+{
+	ContactEvent event;
+	event.aHandle = collision.facePolygon->__handle;
+	event.bHandle = collision.contactPolygon->__handle;
+	event.normal.x = collision.faceNormal.x;
+	event.normal.y = collision.faceNormal.y;
+	event.point.x = collision.contactVertex.x;
+	event.point.y = collision.contactVertex.y;
+	event.depth = collision.depth;
+	event.impulse = collision.impulse;
+	event.state = state;
+	__contactEvents.push_back( event );
+}
+
+// Position correction for the original solver, which only ever changes velocities and so would 
+// otherwise leave Polygons sunk into each other for many steps (piling up collisions, SAT work and 
+// jitter). Runs a few non-linear Gauss-Seidel iterations over this step's contacts using the depth 
+// SAT found, and stops early once no contact overlaps by much more than the slop.
+void World::CorrectPositions()
+{
+	if( __contactConstraints.IsEmpty() )
+	{
+		return;
+	}
+
+	for( int iteration = 0; iteration < POSITION_CORRECTION_ITERATIONS; iteration++ )
+	{
+		float minSeparation = 0.0f;
+		for( ContactConstraint& constraint : __contactConstraints )
+		{
+			minSeparation = std::min( minSeparation, constraint.SolvePosition( POSITION_CORRECTION_BAUMGARTE, POSITION_CORRECTION_SLOP, POSITION_CORRECTION_MAX ) );
+		}
+		if( minSeparation >= -3.0f * POSITION_CORRECTION_SLOP )
+		{
+			break;
+		}
+	}
+
+	for( ContactConstraint& constraint : __contactConstraints )
+	{
+		if( constraint.aInverseMass > 0.0f )
+		{
+			constraint.aPolygon->UpdateGlobalVertices();
+		}
+		if( constraint.bInverseMass > 0.0f )
+		{
+			constraint.bPolygon->UpdateGlobalVertices();
+		}
+	}
+}
+
+// Whether polygon looks for its own pairs in FindCollisions() and moves in Step(). With sleeping on,
+// only awake Polygons that can move (and sensors, so they still see sleeping Polygons) do: static 
+// Polygons never move, so a pair of them has nothing to tell anyone.
+bool World::IsActive( Polygon* polygon )
+{
+	return !__isSleepEnabled || polygon->__isSensor || ( polygon->__isAwake && !polygon->__isStatic );
+}
+
+// Union-find over Polygon::__island, halving the path on the way up.
+Polygon* World::FindIsland( Polygon* polygon )
+{
+	while( polygon->__island != polygon )
+	{
+		polygon->__island = polygon->__island->__island;
+		polygon = polygon->__island;
+	}
+	return polygon;
+}
+
+// Joins the islands of two touching Polygons. An awake root always wins, so an island's root is awake
+// whenever any Polygon in it is.
+void World::MergeIslands( Polygon* aPolygon, Polygon* bPolygon )
+{
+	Polygon* aIsland = FindIsland( aPolygon );
+	Polygon* bIsland = FindIsland( bPolygon );
+	if( aIsland == bIsland )
+	{
+		return;
+	}
+	if( bIsland->__isAwake )
+	{
+		aIsland->__island = bIsland;
+	}
+	else
+	{
+		bIsland->__island = aIsland;
+	}
+}
+
+// Groups the dynamic Polygons into islands by this step's contacts (both the ones FindCollisions() 
+// found and the ones kept for sleeping Polygons) and wakes every island that has anything awake in 
+// it. Static and kinematic Polygons don't join islands, or a whole level would be one island, but a 
+// kinematic Polygon that is awake wakes whatever it touches. Contacts that are awake again go back 
+// to the solvers. Every Polygon starts out as an island of its own (see UpdateSleep()).
+void World::WakeIslands()
+{
+	for( Collision collision : __collisions )
+	{
+		Polygon* aPolygon = collision.facePolygon;
+		Polygon* bPolygon = collision.contactPolygon;
+		if( aPolygon->__isKinematic && aPolygon->__isAwake )
+		{
+			WakePolygon( bPolygon );
+		}
+		if( bPolygon->__isKinematic && bPolygon->__isAwake )
+		{
+			WakePolygon( aPolygon );
+		}
+	}
+
+	auto mergeIslands = [&]( Collision contact )
+	{
+		if( contact.facePolygon->__inverseMass > 0.0f && contact.contactPolygon->__inverseMass > 0.0f )
+		{
+			MergeIslands( contact.facePolygon, contact.contactPolygon );
+		}
+	};
+	for( Collision collision : __collisions )
+	{
+		mergeIslands( collision );
+	}
+	for( Collision contact : __sleepingContacts )
+	{
+		mergeIslands( contact );
+	}
+
+	// Only a Polygon with a contact can share an island with anything.
+	auto wakeIsland = [&]( Polygon* polygon )
+	{
+		if( !polygon->__isAwake && FindIsland( polygon )->__isAwake )
+		{
+			polygon->__isAwake = true;
+			polygon->__sleepTime = 0.0f;
+		}
+	};
+	for( Collision collision : __collisions )
+	{
+		wakeIsland( collision.facePolygon );
+		wakeIsland( collision.contactPolygon );
+	}
+	for( Collision contact : __sleepingContacts )
+	{
+		wakeIsland( contact.facePolygon );
+		wakeIsland( contact.contactPolygon );
+	}
+
+	// The sleeping Polygons haven't moved, so their contacts are still exactly right. Their contact
+	// counts were taken care of by ClearCollisions().
+	int sleepingCount = 0;
+	for( Collision contact : __sleepingContacts )
+	{
+		if( IsActive( contact.facePolygon ) || IsActive( contact.contactPolygon ) )
+		{
+			__collisions.Add( contact );
+		}
+		else
+		{
+			__sleepingContacts[ sleepingCount++ ] = contact;
+		}
+	}
+	__sleepingContacts.resize( sleepingCount );
+}
+
+// Runs each awake Polygon's rest timer and puts every island whose Polygons have all rested for 
+// TIME_TO_SLEEP to sleep. Sleeping Polygons stop moving, aren't integrated or moved in the broadphase
+// and don't look for pairs, so a settled pile costs next to nothing until something touches it, it
+// is changed through the API or the World's sleeping is turned off. Their contacts are kept (and 
+// keep being reported) in __sleepingContacts.
+void World::UpdateSleep( float deltaTimeSeconds )
+{
+	for( Polygon* polygon : __awakePolygons )
+	{
+		polygon->__isIslandResting = true;
+	}
+
+	for( Polygon* polygon : __awakePolygons )
+	{
+		if( polygon->__isStatic )
+		{
+			continue;
+		}
+
+		bool isMoving = polygon->__isSensor
+			|| std::abs( polygon->__velocity.x ) > SLEEP_LINEAR_TOLERANCE
+			|| std::abs( polygon->__velocity.y ) > SLEEP_LINEAR_TOLERANCE
+			|| std::abs( polygon->__rotationalVelocity ) > SLEEP_ANGULAR_TOLERANCE;
+		bool hasDrifted = polygon->__sleepTime > 0.0f && (
+			std::abs( polygon->__position.x - polygon->__restPosition.x ) > SLEEP_LINEAR_DRIFT
+			|| std::abs( polygon->__position.y - polygon->__restPosition.y ) > SLEEP_LINEAR_DRIFT
+			|| std::abs( polygon->__rotation - polygon->__restRotation ) > SLEEP_ANGULAR_DRIFT );
+		if( isMoving || hasDrifted )
+		{
+			polygon->__sleepTime = 0.0f;
+		}
+		else
+		{
+			if( polygon->__sleepTime == 0.0f )
+			{
+				polygon->__restPosition = polygon->__position;
+				polygon->__restRotation = polygon->__rotation;
+			}
+			polygon->__sleepTime += deltaTimeSeconds;
+		}
+
+		if( polygon->__sleepTime < TIME_TO_SLEEP )
+		{
+			FindIsland( polygon )->__isIslandResting = false;
+		}
+	}
+
+	for( Polygon* polygon : __awakePolygons )
+	{
+		if( !polygon->__isStatic && FindIsland( polygon )->__isIslandResting )
+		{
+			polygon->__isAwake = false;
+			polygon->__velocity = glm::vec2();
+			polygon->__rotationalVelocity = 0.0f;
+			polygon->__previousPosition = polygon->__position;
+			polygon->__previousRotation = polygon->__rotation;
+		}
+	}
+
+	for( int i = 0; i < __collisions.GetCount(); )
+	{
+		Collision collision = __collisions[ i ];
+		if( !IsActive( collision.facePolygon ) && !IsActive( collision.contactPolygon ) )
+		{
+			__sleepingContacts.push_back( collision );
+			__collisions.RemoveAt( i );
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	// Break the islands up again for the next step. Anything that was merged is either awake this
+	// step or sleeping with a contact.
+	for( Polygon* polygon : __awakePolygons )
+	{
+		polygon->__island = polygon;
+	}
+	for( Collision contact : __sleepingContacts )
+	{
+		contact.facePolygon->__island = contact.facePolygon;
+		contact.contactPolygon->__island = contact.contactPolygon;
+	}
+}
+
+// Continuous collision for a bullet that has just been integrated. Integration only looks at the end
+// of the step, so a fast bullet can jump straight over a thin Polygon. Instead, every non-bullet the
+// bullet could have passed on the way (from the broadphase, using the box around both ends of its 
+// move) is swept with conservative advancement: the SAT separation is a lower bound on the distance
+// between the two, and no point of the bullet moves further than motionBound per unit of the step, 
+// so the bullet can safely be advanced by separation / motionBound until they touch. The other 
+// Polygon is taken to be where it ended the step, which is exact for the walls bullets usually hit.
+// The bullet is left at the earliest time of impact (plus CCD_SLOP) or at the end of its move.
+void World::SweepBullet( Polygon* bullet )
+{
+	glm::vec2 startPosition = bullet->__previousPosition;
+	glm::vec2 endPosition = bullet->__position;
+	glm::vec2 translation = endPosition - startPosition;
+	float startRotation = bullet->__previousRotation;
+	float endRotation = bullet->__rotation;
+	float rotation = endRotation - startRotation;
+
+	float radius = 0.0f;
+	for ( glm::vec2 vertex : *bullet->__vertices )
+	{
+		radius = std::max( radius, glm::length( vertex ) );
+	}
+	radius += bullet->__radius;
+	float motionBound = glm::length( translation ) + glm::abs( rotation ) * radius;
+	if( motionBound <= CCD_TOLERANCE )
+	{
+		return;
+	}
+
+	AABB endAABB = bullet->__aabb;
+	bullet->SetTransform( startPosition, startRotation );
+	AABB sweptAABB = AABB::Combine( bullet->__aabb, endAABB );
+
+	float timeOfImpact = 1.0f;
+	auto sweepAgainst = [&]( int proxyId )
+	{
+		Polygon* other = __broadphase.GetPolygon( proxyId );
+		if( other == bullet || other->__isBullet || other->__isSensor || !DynamicTree::ShouldCollide( bullet->__collisionCategory, bullet->__collisionMask, __broadphase.GetCategory( proxyId ), __broadphase.GetMask( proxyId ) ) )
+		{
+			return true;
+		}
+
+		// Polygons already touching at the start of the step are left to the regular SAT test.
+		bullet->SetTransform( startPosition, startRotation );
+		float separation = ComputeSweepSeparation( bullet, other );
+		if( separation <= CCD_TOLERANCE )
+		{
+			return true;
+		}
+
+		float time = 0.0f;
+		for( int i = 0; i < CCD_MAX_ITERATIONS && separation > CCD_TOLERANCE; i++ )
+		{
+			time += separation / motionBound;
+			if( time >= timeOfImpact )
+			{
+				return true;
+			}
+			bullet->SetTransform( startPosition + time * translation, startRotation + time * rotation );
+			separation = ComputeSweepSeparation( bullet, other );
+		}
+		timeOfImpact = time;
+		return true;
+	};
+	__broadphase.Query( sweptAABB, sweepAgainst );
+
+	if( timeOfImpact < 1.0f )
+	{
+		float time = std::min( 1.0f, timeOfImpact + CCD_SLOP / motionBound );
+		bullet->SetTransform( startPosition + time * translation, startRotation + time * rotation );
+	}
+	else
+	{
+		bullet->SetTransform( endPosition, endRotation );
+	}
+	SynchronizeProxy( bullet );
+}
+
+// The SAT separation between two Polygons using the faces of facePolygon: the largest distance from
+// one of its faces to the nearest vertex of vertexPolygon. Positive means they are apart (and by at 
+// least that much), zero or negative means they overlap on every one of these faces.
+float World::ComputeSeparation( Polygon* facePolygon, Polygon* vertexPolygon )
+{
+	std::vector<glm::vec2>& faceVertices = facePolygon->__globalVertices;
+	std::vector<glm::vec2>& vertices = vertexPolygon->__globalVertices;
+
+	float maxSeparation = -FLT_MAX;
+	for( int i = 0; i < (int)faceVertices.size(); i++ )
+	{
+		// CW ordering so we compute a left-normal.
+		glm::vec2 faceVertex = faceVertices[ i ];
+		glm::vec2 faceVector = glm::normalize( faceVertices[ ( i + 1 ) % faceVertices.size() ] - faceVertex );
+		glm::vec2 faceNormal = glm::vec2( -faceVector.y, faceVector.x );
+
+		float minDistance = FLT_MAX;
+		for( glm::vec2 vertex : vertices )
+		{
+			minDistance = std::min( minDistance, glm::dot( vertex - faceVertex, faceNormal ) );
+		}
+		maxSeparation = std::max( maxSeparation, minDistance );
+	}
+	return maxSeparation;
+}
+
+// The lower bound on the distance between a bullet and another Polygon that SweepBullet() advances 
+// by: the SAT separation (both ways round) from the nearest of other's pieces. A compound bullet goes
+// by its convex hull, which can only make the bound smaller. Circles and capsules go by the distance
+// their own tests find (see CollideRound()).
+float World::ComputeSweepSeparation( Polygon* bullet, Polygon* other )
+{
+	float separation = FLT_MAX;
+	for( int i = 0; i < other->GetPieceCount(); i++ )
+	{
+		Polygon* piece = other->GetPiece( i );
+		if( bullet->__shape != ShapeType::Polygon || piece->__shape != ShapeType::Polygon )
+		{
+			Collision collision;
+			separation = std::min( separation, CollideRound( bullet, piece, &collision ) );
+			continue;
+		}
+		separation = std::min( separation, std::max( ComputeSeparation( bullet, piece ), ComputeSeparation( piece, bullet ) ) );
+	}
+	return separation;
+}
+
+// SweepBullet() done in Fixed math for deterministic mode, so bullets stop at the same time of 
+// impact on every machine.
+void World::SweepBulletFixed( Polygon* bullet )
+{
+	FixedVector2 startPosition = FixedVector2( bullet->__previousPosition );
+	FixedVector2 translation = FixedVector2( bullet->__position ) - startPosition;
+	glm::vec2 endPosition = bullet->__position;
+	Fixed startRotation = Fixed::FromFloat( bullet->__previousRotation );
+	Fixed rotation = Fixed::FromFloat( bullet->__rotation ) - startRotation;
+	float endRotation = bullet->__rotation;
+
+	Fixed radius = Fixed();
+	for ( glm::vec2 vertex : *bullet->__vertices )
+	{
+		FixedVector2 fixedVertex = FixedVector2( vertex );
+		Fixed length = Fixed::Sqrt( FixedVector2::Dot( fixedVertex, fixedVertex ) );
+		if( length > radius )
+		{
+			radius = length;
+		}
+	}
+	radius += Fixed::FromFloat( bullet->__radius );
+	Fixed turn = rotation < Fixed() ? -rotation : rotation;
+	Fixed motionBound = Fixed::Sqrt( FixedVector2::Dot( translation, translation ) ) + turn * radius;
+	Fixed tolerance = Fixed::FromFloat( CCD_TOLERANCE );
+	if( motionBound <= tolerance )
+	{
+		return;
+	}
+
+	AABB endAABB = bullet->__aabb;
+	bullet->SetTransform( startPosition.ToGLM(), startRotation.ToFloat() );
+	AABB sweptAABB = AABB::Combine( bullet->__aabb, endAABB );
+
+	Fixed timeOfImpact = Fixed( 1 );
+	auto sweepAgainst = [&]( int proxyId )
+	{
+		Polygon* other = __broadphase.GetPolygon( proxyId );
+		if( other == bullet || other->__isBullet || other->__isSensor || !DynamicTree::ShouldCollide( bullet->__collisionCategory, bullet->__collisionMask, __broadphase.GetCategory( proxyId ), __broadphase.GetMask( proxyId ) ) )
+		{
+			return true;
+		}
+
+		// Polygons already touching at the start of the step are left to the regular SAT test.
+		bullet->SetTransform( startPosition.ToGLM(), startRotation.ToFloat() );
+		Fixed separation = ComputeSweepSeparationFixed( bullet, other );
+		if( separation <= tolerance )
+		{
+			return true;
+		}
+
+		Fixed time = Fixed();
+		for( int i = 0; i < CCD_MAX_ITERATIONS && separation > tolerance; i++ )
+		{
+			time += separation / motionBound;
+			if( time >= timeOfImpact )
+			{
+				return true;
+			}
+			bullet->SetTransform( ( startPosition + translation * time ).ToGLM(), ( startRotation + rotation * time ).ToFloat() );
+			separation = ComputeSweepSeparationFixed( bullet, other );
+		}
+		timeOfImpact = time;
+		return true;
+	};
+	__broadphase.Query( sweptAABB, sweepAgainst );
+
+	if( timeOfImpact < Fixed( 1 ) )
+	{
+		Fixed time = timeOfImpact + Fixed::FromFloat( CCD_SLOP ) / motionBound;
+		if( time > Fixed( 1 ) )
+		{
+			time = Fixed( 1 );
+		}
+		bullet->SetTransform( ( startPosition + translation * time ).ToGLM(), ( startRotation + rotation * time ).ToFloat() );
+	}
+	else
+	{
+		bullet->SetTransform( endPosition, endRotation );
+	}
+	SynchronizeProxy( bullet );
+}
+
+// ComputeSeparation() done in Fixed math for deterministic mode.
+Fixed World::ComputeSeparationFixed( Polygon* facePolygon, Polygon* vertexPolygon )
+{
+	std::vector<glm::vec2>& faceVertices = facePolygon->__globalVertices;
+	std::vector<glm::vec2>& vertices = vertexPolygon->__globalVertices;
+
+	Fixed maxSeparation = -Fixed::Max();
+	for( int i = 0; i < (int)faceVertices.size(); i++ )
+	{
+		// CW ordering so we compute a left-normal.
+		FixedVector2 faceVertex = FixedVector2( faceVertices[ i ] );
+		FixedVector2 faceVector = FixedVector2::Normalize( FixedVector2( faceVertices[ ( i + 1 ) % faceVertices.size() ] ) - faceVertex );
+		FixedVector2 faceNormal = FixedVector2( -faceVector.y, faceVector.x );
+
+		Fixed minDistance = Fixed::Max();
+		for( glm::vec2 vertex : vertices )
+		{
+			Fixed distance = FixedVector2::Dot( FixedVector2( vertex ) - faceVertex, faceNormal );
+			if( distance < minDistance )
+			{
+				minDistance = distance;
+			}
+		}
+		if( minDistance > maxSeparation )
+		{
+			maxSeparation = minDistance;
+		}
+	}
+	return maxSeparation;
+}
+
+// ComputeSweepSeparation() done in Fixed math for deterministic mode.
+Fixed World::ComputeSweepSeparationFixed( Polygon* bullet, Polygon* other )
+{
+	Fixed separation = Fixed::Max();
+	for( int i = 0; i < other->GetPieceCount(); i++ )
+	{
+		Polygon* piece = other->GetPiece( i );
+		Fixed pieceSeparation;
+		if( bullet->__shape != ShapeType::Polygon || piece->__shape != ShapeType::Polygon )
+		{
+			Collision collision;
+			pieceSeparation = CollideRoundFixed( bullet, piece, &collision );
+		}
+		else
+		{
+			Fixed aSeparation = ComputeSeparationFixed( bullet, piece );
+			Fixed bSeparation = ComputeSeparationFixed( piece, bullet );
+			pieceSeparation = aSeparation > bSeparation ? aSeparation : bSeparation;
+		}
+		if( pieceSeparation < separation )
+		{
+			separation = pieceSeparation;
+		}
+	}
+	return separation;
+}
+
+// Integrate force -> acceleration -> velocity -> position for a single Polygon.
+void World::Integrate( Polygon* polygon, float deltaTimeSeconds )
+{
+	// Apply gravity if this polygon is expecting it (kinematic Polygons only ever move as they're told).
+	if ( polygon->GetUseGravity() && !polygon->GetIsKinematic() )
+	{
+		polygon->Accelerate( glm::vec2( 0.0f, __gravityAcceleration * deltaTimeSeconds ) );
+	}
+
+	// Maybe here is a good place to account for any forces acting on your polygons...
+	// TODO
+
+	// Integrate velocity to position (Euler method).
+	polygon->Translate( polygon->GetVelocity() * deltaTimeSeconds );
+
+	// Integrate rotational velocity to rotation (Euler method).
+	polygon->Rotate( polygon->GetRotationalVelocity() * deltaTimeSeconds );
+}
+
+// Integrate() done in Fixed math for deterministic mode. The float state is only read and written 
+// at the ends, and those conversions are exact, so every machine ends up with the same bits.
+void World::IntegrateFixed( Polygon* polygon, float deltaTimeSeconds )
+{
+	Fixed timestep = Fixed::FromFloat( deltaTimeSeconds );
+
+	FixedVector2 velocity = FixedVector2( polygon->GetVelocity() );
+	if ( polygon->GetUseGravity() && !polygon->GetIsKinematic() )
+	{
+		velocity.y += Fixed::FromFloat( __gravityAcceleration ) * timestep;
+		polygon->SetVelocity( velocity.ToGLM() );
+	}
+
+	FixedVector2 position = FixedVector2( polygon->GetPosition() ) + velocity * timestep;
+	Fixed rotation = Fixed::FromFloat( polygon->GetRotation() ) + Fixed::FromFloat( polygon->GetRotationalVelocity() ) * timestep;
+	polygon->SetPosition( position.ToGLM() );
+	polygon->SetRotation( rotation.ToFloat() );
+}
+
+// Hashes the quantized state of every Polygon in handle order. Two worlds that have simulated the
+// same inputs in deterministic mode produce the same hash, so clients can compare it each step.
+unsigned long long World::ComputeStateHash()
+{
+	unsigned long long hash = 14695981039346656037ULL;
+	for( auto iterator = __polygons.begin(); iterator != __polygons.end(); ++iterator )
+	{
+		Polygon* polygon = iterator->second;
+		long long values[] = {
+			iterator->first,
+			Fixed::FromFloat( polygon->GetPosition().x ).GetRaw(),
+			Fixed::FromFloat( polygon->GetPosition().y ).GetRaw(),
+			Fixed::FromFloat( polygon->GetRotation() ).GetRaw(),
+			Fixed::FromFloat( polygon->GetVelocity().x ).GetRaw(),
+			Fixed::FromFloat( polygon->GetVelocity().y ).GetRaw(),
+			Fixed::FromFloat( polygon->GetRotationalVelocity() ).GetRaw()
+		};
+		for( long long value : values )
+		{
+			// FNV-1a over whole 64-bit words, with a rotation so the high bits get mixed in too.
+			hash ^= (unsigned long long)value;
+			hash *= 1099511628211ULL;
+			hash ^= hash >> 29;
+		}
+	}
+	return hash;
+}
+
+// Count up the vertex, piece and piece vertex records a snapshot of this World needs.
+void World::CountSnapshotRecords( int* vertexCount, int* pieceCount, int* pieceVertexCount )
+{
+	*vertexCount = 0;
+	*pieceCount = 0;
+	*pieceVertexCount = 0;
+	for( auto iterator = __polygons.begin(); iterator != __polygons.end(); ++iterator )
+	{
+		Polygon* polygon = iterator->second;
+		*vertexCount += (int)polygon->__vertices->size();
+		*pieceCount += (int)polygon->__pieces.size();
+		for( Polygon* piece : polygon->__pieces )
+		{
+			*pieceVertexCount += (int)piece->__vertices->size();
+		}
+	}
+}
+
+// Writes the state stored in a PolygonSnapshot record into polygon (taking one from __polygonPool 
+// first if it is NULL) and returns it. The vertices in a snapshot are already centered on the center of mass, so they are
+// copied straight in rather than going through SetVertices(). A compound's pieces (their vertex 
+// counts in pieceRecords, their vertices in pieceVertices) are rebuilt from scratch the same way.
+Polygon* World::RestorePolygon( Polygon* polygon, const char* record, const glm::vec2* vertices, const int* pieceRecords, const glm::vec2* pieceVertices )
+{
+	PolygonSnapshot state;
+	memcpy( &state, record, sizeof( PolygonSnapshot ) );
+
+	if( polygon == NULL )
+	{
+		polygon = __polygonPool.Acquire();
+		polygon->Reset( state.position, state.rotation, state.mass, false, false );
+		polygon->__isDeterministic = __isDeterministic;
+	}
+
+	std::vector<glm::vec2>& localVertices = *polygon->__vertices;
+	bool hasOutlineChanged = (int)localVertices.size() != state.vertexCount || polygon->__shape != (ShapeType)state.shape;
+	localVertices.assign( vertices, vertices + state.vertexCount );
+	polygon->__shape = (ShapeType)state.shape;
+	polygon->__radius = state.radius;
+
+	ReleasePieces( polygon->__pieces );
+	for( int i = 0; i < state.pieceCount; i++ )
+	{
+		Polygon* piece = __polygonPool.Acquire();
+		piece->Reset( state.position, state.rotation, 1.0f, false, false );
+		piece->__vertices->assign( pieceVertices, pieceVertices + pieceRecords[ i ] );
+		piece->__body = polygon;
+		polygon->__pieces.push_back( piece );
+		pieceVertices += pieceRecords[ i ];
+	}
+
+	polygon->__position = state.position;
+	polygon->__velocity = state.velocity;
+	polygon->__rotation = state.rotation;
+	polygon->__rotationalVelocity = state.rotationalVelocity;
+	polygon->__mass = state.mass;
+	polygon->__rotationalInertia = state.rotationalInertia;
+	polygon->__useGravity = state.useGravity != 0;
+	polygon->__isStatic = state.isStatic != 0;
+	polygon->__handle = state.handle;
+	polygon->__collisionCategory = state.collisionCategory;
+	polygon->__collisionMask = state.collisionMask;
+	polygon->__isBullet = state.isBullet != 0;
+	polygon->__isKinematic = state.isKinematic != 0;
+	polygon->__isSensor = state.isSensor != 0;
+	polygon->__isAwake = state.isAwake != 0 || !__isSleepEnabled;
+	polygon->__sleepTime = state.sleepTime;
+	polygon->__restPosition = state.restPosition;
+	polygon->__restRotation = state.restRotation;
+	polygon->__contactCount = 0;
+	polygon->__previousPosition = state.position;
+	polygon->__previousRotation = state.rotation;
+	polygon->UpdateInverseMass();
+
+	polygon->UpdateGlobalVertices();
+	polygon->UpdateNormals();
+	if( hasOutlineChanged )
+	{
+		polygon->UpdateFaces();
+	}
+	polygon->UpdateIsBox();
+	for( Polygon* piece : polygon->__pieces )
+	{
+		piece->UpdateFaces();
+		piece->UpdateNormals();
+		piece->UpdateIsBox();
+	}
+	polygon->__pieceTree.Build( polygon->__pieces );
+	SynchronizeProxy( polygon );
+	__broadphase.SetProxyFilter( polygon->__proxyId, state.collisionCategory, state.collisionMask );
+	return polygon;
+}
+
+// Adds a collision to __collisions for every pair of pieces (see Polygon::GetPiece()) of two Polygons
+// that collide. Each Polygon's PieceTree hands over only the pieces whose boxes overlap the other 
+// side, so a ship built from dozens of pieces brushing a wall only tests the few pieces near it. The 
+// collisions are made out to the Polygons themselves, so the solvers, contact counts and contact 
+// events never see the pieces. A compound resting on two supports just gets a collision at each.
+void World::FindPieceCollisions( Polygon* aPolygon, Polygon* bPolygon )
+{
+	auto testAPiece = [&]( Polygon* aPiece )
+	{
+		auto testBPiece = [&]( Polygon* bPiece )
+		{
+			Collision collision;
+			if( TestCollision( aPiece, bPiece, &collision ) )
+			{
+				collision.facePolygon = collision.facePolygon == aPiece ? aPolygon : bPolygon;
+				collision.contactPolygon = collision.contactPolygon == aPiece ? aPolygon : bPolygon;
+				__collisions.Add( collision );
+				aPolygon->__contactCount++;
+				bPolygon->__contactCount++;
+			}
+			return true;
+		};
+		bPolygon->QueryPieces( aPiece->__aabb, testBPiece );
+		return true;
+	};
+	aPolygon->QueryPieces( bPolygon->__aabb, testAPiece );
+}
+
+// Whether any piece of aPolygon overlaps any piece of bPolygon (see TestOverlap()).
+bool World::TestPieceOverlap( Polygon* aPolygon, Polygon* bPolygon )
+{
+	bool isOverlapping = false;
+	auto testAPiece = [&]( Polygon* aPiece )
+	{
+		auto testBPiece = [&]( Polygon* bPiece )
+		{
+			isOverlapping = TestOverlap( aPiece, bPiece );
+			return !isOverlapping;
+		};
+		bPolygon->QueryPieces( aPiece->__aabb, testBPiece );
+		return !isOverlapping;
+	};
+	aPolygon->QueryPieces( bPolygon->__aabb, testAPiece );
+	return isOverlapping;
+}
+
+bool World::TestCollision( Polygon* aPolygon, Polygon* bPolygon, Collision* maybeCollision )
+{
+	// Circles and capsules skip SAT for closed-form tests of their own.
+	if( aPolygon->__shape != ShapeType::Polygon || bPolygon->__shape != ShapeType::Polygon )
+	{
+		if( __isDeterministic )
+		{
+			return CollideRoundFixed( aPolygon, bPolygon, maybeCollision ) <= Fixed();
+		}
+		return CollideRound( aPolygon, bPolygon, maybeCollision ) <= 0.0f;
+	}
+
+	// Test SAT with the faces of aPolygon and the vertices of bPolygon.
+	if( __isDeterministic )
+	{
+		return TestSeparateAxisTheoremFixed( aPolygon, bPolygon, maybeCollision ) && TestSeparateAxisTheoremFixed( bPolygon, aPolygon, maybeCollision );
+	}
+
+	// Two boxes only have four axes between them (see TestBoxAxes()).
+	if( aPolygon->__isBox && bPolygon->__isBox )
+	{
+		return TestBoxAxes( aPolygon, bPolygon, maybeCollision ) && TestBoxAxes( bPolygon, aPolygon, maybeCollision );
+	}
+
+	if( !TestSeparateAxisTheorem( aPolygon, bPolygon, maybeCollision ) )
+	{
+		return false;
+	}
+
+	// Test SAT with the faces of bPolygon and the vertices of aPolygon.
+	if( !TestSeparateAxisTheorem( bPolygon, aPolygon, maybeCollision ) )
+	{
+		return false;
+	}
+
+	// If we haven't exited out yet, return the collision object.
+	return true;
+}
+
+// Whether two Polygons overlap at all, for pairs with a sensor in them. Unlike TestCollision() there's
+// no deepest axis or contact to find, so this gets to quit as early as possible. Deterministic mode 
+// still goes through the Fixed SAT so every client agrees on what a sensor touched, and circles and 
+// capsules have nothing cheaper than their usual test.
+bool World::TestOverlap( Polygon* aPolygon, Polygon* bPolygon )
+{
+	if( __isDeterministic || aPolygon->__shape != ShapeType::Polygon || bPolygon->__shape != ShapeType::Polygon )
+	{
+		Collision collision;
+		return TestCollision( aPolygon, bPolygon, &collision );
+	}
+	if( aPolygon->__isBox && bPolygon->__isBox )
+	{
+		Collision collision;
+		return TestBoxAxes( aPolygon, bPolygon, &collision ) && TestBoxAxes( bPolygon, aPolygon, &collision );
+	}
+	return TestOverlapSeparatingAxes( aPolygon, bPolygon ) && TestOverlapSeparatingAxes( bPolygon, aPolygon );
+}
+
+// False if one of facePolygon's faces separates the Polygons. Each face stops at the first vertex of 
+// vertexPolygon behind it, since that already proves it isn't a separating axis.
+bool World::TestOverlapSeparatingAxes( Polygon* facePolygon, Polygon* vertexPolygon )
+{
+	std::vector<glm::vec2>& vertices = vertexPolygon->GetGlobalVertices();
+	for( Face& face : facePolygon->GetFaces() )
+	{
+		bool isSeparatingAxis = true;
+		for( glm::vec2 vertex : vertices )
+		{
+			if( face.GetGlobalDistance( vertex ) <= 0.0f )
+			{
+				isSeparatingAxis = false;
+				break;
+			}
+		}
+		if( isSeparatingAxis )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool World::TestSeparateAxisTheorem( Polygon* facePolygon, Polygon* vertexPolygon, Collision* maybeCollision )
+{
+	// For each face in bPolygon
+	for( Face aFace : facePolygon->GetFaces() )
+	{
+		// Find the vertex in bPolygon with the minimum distance from the face.
+		float minDistance = FLT_MAX;
+		glm::vec2 minVertex;
+		for( glm::vec2 bVertex : vertexPolygon->GetGlobalVertices() )
+		{
+			float distance = aFace.GetGlobalDistance( bVertex );
+			if( distance < minDistance )
+			{
+				minDistance = distance;
+				minVertex = bVertex;
+			}
+		}
+
+		// If the distance to the nearest vertex in b is greater than 0, we can't be in collision.
+		if( minDistance > 0 )
+		{
+			return false;
+		}
+
+		// The least negative distance is the best candidate for depenetration.
+		if( minDistance > maybeCollision->depth )
+		{
+			maybeCollision->facePolygon = facePolygon;
+			maybeCollision->contactPolygon = vertexPolygon;
+			maybeCollision->contactVertex = minVertex;
+			maybeCollision->depth = minDistance;
+			maybeCollision->faceNormal = aFace.GetGlobalNormal();
+		}
+	}
+
+	return true;
+}
+
+// TestSeparateAxisTheorem() for a pair of boxes (see Polygon::UpdateIsBox()). Opposite faces of a 
+// box share an axis, so each of facePolygon's two axes only needs the face turned towards 
+// vertexPolygon, and both boxes' extents along it come from their half extents instead of a pass 
+// over the vertices. The axes are the first two edges over their known lengths, so nothing gets 
+// normalized. The contact is the same deepest vertex TestSeparateAxisTheorem() would pick.
+bool World::TestBoxAxes( Polygon* facePolygon, Polygon* vertexPolygon, Collision* maybeCollision )
+{
+	std::vector<glm::vec2>& faceVertices = facePolygon->__globalVertices;
+	std::vector<glm::vec2>& vertices = vertexPolygon->__globalVertices;
+	glm::vec2 faceExtents = facePolygon->__halfExtents;
+	glm::vec2 extents = vertexPolygon->__halfExtents;
+
+	glm::vec2 faceAxes[ 2 ] = { ( faceVertices[ 1 ] - faceVertices[ 0 ] ) / ( 2.0f * faceExtents.x ), ( faceVertices[ 2 ] - faceVertices[ 1 ] ) / ( 2.0f * faceExtents.y ) };
+	glm::vec2 axes[ 2 ] = { ( vertices[ 1 ] - vertices[ 0 ] ) / ( 2.0f * extents.x ), ( vertices[ 2 ] - vertices[ 1 ] ) / ( 2.0f * extents.y ) };
+	glm::vec2 offset = 0.5f * ( vertices[ 0 ] + vertices[ 2 ] - faceVertices[ 0 ] - faceVertices[ 2 ] );
+	float faceExtentsAlongAxes[ 2 ] = { faceExtents.x, faceExtents.y };
+
+	for( int i = 0; i < 2; i++ )
+	{
+		float distance = glm::dot( offset, faceAxes[ i ] );
+		glm::vec2 faceNormal = distance < 0.0f ? -faceAxes[ i ] : faceAxes[ i ];
+		float extent = glm::abs( glm::dot( axes[ 0 ], faceNormal ) ) * extents.x + glm::abs( glm::dot( axes[ 1 ], faceNormal ) ) * extents.y;
+		float separation = glm::abs( distance ) - faceExtentsAlongAxes[ i ] - extent;
+
+		// If the boxes are apart along this axis, we can't be in collision.
+		if( separation > 0.0f )
+		{
+			return false;
+		}
+
+		// The least negative distance is the best candidate for depenetration.
+		if( separation > maybeCollision->depth )
+		{
+			int deepest = 0;
+			for( int j = 1; j < 4; j++ )
+			{
+				if( glm::dot( vertices[ j ] - vertices[ deepest ], faceNormal ) < 0.0f )
+				{
+					deepest = j;
+				}
+			}
+			maybeCollision->facePolygon = facePolygon;
+			maybeCollision->contactPolygon = vertexPolygon;
+			maybeCollision->contactVertex = vertices[ deepest ];
+			maybeCollision->depth = separation;
+			maybeCollision->faceNormal = faceNormal;
+		}
+	}
+
+	return true;
+}
+
+// TestSeparateAxisTheorem() done in Fixed math for deterministic mode. Face normals are rebuilt from
+// the global vertices with a fixed-point square root instead of going through glm::normalize().
+bool World::TestSeparateAxisTheoremFixed( Polygon* facePolygon, Polygon* vertexPolygon, Collision* maybeCollision )
+{
+	std::vector<glm::vec2>& faceVertices = facePolygon->GetGlobalVertices();
+	std::vector<glm::vec2>& vertices = vertexPolygon->GetGlobalVertices();
+
+	for( int i = 0; i < (int)faceVertices.size(); i++ )
+	{
+		// CW ordering so we compute a left-normal.
+		FixedVector2 faceVertex = FixedVector2( faceVertices[ i ] );
+		FixedVector2 faceVector = FixedVector2::Normalize( FixedVector2( faceVertices[ ( i + 1 ) % faceVertices.size() ] ) - faceVertex );
+		FixedVector2 faceNormal = FixedVector2( -faceVector.y, faceVector.x );
+
+		// Find the vertex in vertexPolygon with the minimum distance from the face.
+		Fixed minDistance = Fixed::Max();
+		glm::vec2 minVertex;
+		for( glm::vec2 vertex : vertices )
+		{
+			Fixed distance = FixedVector2::Dot( FixedVector2( vertex ) - faceVertex, faceNormal );
+			if( distance < minDistance )
+			{
+				minDistance = distance;
+				minVertex = vertex;
+			}
+		}
+
+		// If the distance to the nearest vertex is greater than 0, we can't be in collision.
+		if( minDistance > Fixed() )
+		{
+			return false;
+		}
+
+		// The least negative distance is the best candidate for depenetration.
+		if( minDistance.ToFloat() > maybeCollision->depth )
+		{
+			maybeCollision->facePolygon = facePolygon;
+			maybeCollision->contactPolygon = vertexPolygon;
+			maybeCollision->contactVertex = minVertex;
+			maybeCollision->depth = minDistance.ToFloat();
+			maybeCollision->faceNormal = faceNormal.ToGLM();
+		}
+	}
+
+	return true;
+}
+
+// The signed distance between two Polygons of which at least one is a circle or a capsule (see 
+// Polygon::SetCapsule()): positive means they are that far apart, zero or negative means they 
+// overlap by that much. Each pairing of shapes has a closed-form test instead of going through SAT,
+// and the contact is written to collision the same way TestSeparateAxisTheorem() writes it.
+float World::CollideRound( Polygon* aPolygon, Polygon* bPolygon, Collision* collision )
+{
+	if( aPolygon->__shape == ShapeType::Polygon )
+	{
+		return CollideRoundAndPolygon( bPolygon, aPolygon, collision );
+	}
+	if( bPolygon->__shape == ShapeType::Polygon )
+	{
+		return CollideRoundAndPolygon( aPolygon, bPolygon, collision );
+	}
+	return CollideRoundShapes( aPolygon, bPolygon, collision );
+}
+
+// Circle-circle, circle-capsule and capsule-capsule: the distance between the nearest points of the
+// two segments, less both radii. A circle's segment is a single point, so two circles are a single 
+// distance check. The normal runs from aPolygon to bPolygon and the contact is bPolygon's deepest point.
+float World::CollideRoundShapes( Polygon* aPolygon, Polygon* bPolygon, Collision* collision )
+{
+	glm::vec2 aPoint = aPolygon->__globalVertices.front();
+	glm::vec2 bPoint = bPolygon->__globalVertices.front();
+	if( aPolygon->__shape == ShapeType::Capsule || bPolygon->__shape == ShapeType::Capsule )
+	{
+		ClosestPointsOnSegments( aPoint, aPolygon->__globalVertices.back(), bPoint, bPolygon->__globalVertices.back(), &aPoint, &bPoint );
+	}
+
+	// Segments that touch have no direction between them, so fall back on the one between centers.
+	glm::vec2 offset = bPoint - aPoint;
+	float distance = glm::length( offset );
+	glm::vec2 normal = glm::vec2( 0.0f, 1.0f );
+	if( distance > 0.0f )
+	{
+		normal = offset / distance;
+	}
+	else if( bPolygon->__position != aPolygon->__position )
+	{
+		normal = glm::normalize( bPolygon->__position - aPolygon->__position );
+	}
+
+	float depth = distance - aPolygon->__radius - bPolygon->__radius;
+	SetContact( collision, aPolygon, bPolygon, normal, bPoint - normal * bPolygon->__radius, depth );
+	return depth;
+}
+
+// Circle-polygon and capsule-polygon, as separating axes: the polygon's faces, the two sides of a 
+// capsule and, for each end of the round shape's segment that lies outside the polygon, the 
+// direction from the nearest point of the polygon (which takes care of its corners). The round 
+// shape's extent along an axis is its segment's plus the radius. The least negative axis wins.
+float World::CollideRoundAndPolygon( Polygon* round, Polygon* polygon, Collision* collision )
+{
+	glm::vec2 start = round->__globalVertices.front();
+	glm::vec2 end = round->__globalVertices.back();
+	float radius = round->__radius;
+	std::vector<glm::vec2>& vertices = polygon->__globalVertices;
+
+	float maxSeparation = -FLT_MAX;
+	float startOutside = -FLT_MAX;
+	float endOutside = -FLT_MAX;
+	for( Face& face : polygon->GetFaces() )
+	{
+		float startDistance = face.GetGlobalDistance( start );
+		float endDistance = face.GetGlobalDistance( end );
+		startOutside = std::max( startOutside, startDistance );
+		endOutside = std::max( endOutside, endDistance );
+
+		float separation = std::min( startDistance, endDistance ) - radius;
+		if( separation > maxSeparation )
+		{
+			maxSeparation = separation;
+			glm::vec2 normal = face.GetGlobalNormal();
+			SetContact( collision, polygon, round, normal, ( startDistance <= endDistance ? start : end ) - normal * radius, separation );
+		}
+	}
+
+	if( round->__shape == ShapeType::Capsule )
+	{
+		glm::vec2 axis = glm::normalize( end - start );
+		glm::vec2 sideNormals[ 2 ] = { glm::vec2( -axis.y, axis.x ), glm::vec2( axis.y, -axis.x ) };
+		for( glm::vec2 normal : sideNormals )
+		{
+			float minDistance = FLT_MAX;
+			glm::vec2 minVertex;
+			for( glm::vec2 vertex : vertices )
+			{
+				float distance = glm::dot( vertex - start, normal );
+				if( distance < minDistance )
+				{
+					minDistance = distance;
+					minVertex = vertex;
+				}
+			}
+
+			float separation = minDistance - radius;
+			if( separation > maxSeparation )
+			{
+				maxSeparation = separation;
+				SetContact( collision, round, polygon, normal, minVertex, separation );
+			}
+		}
+	}
+
+	glm::vec2 ends[ 2 ] = { start, end };
+	float outside[ 2 ] = { startOutside, endOutside };
+	for( int i = 0; i < ( round->__shape == ShapeType::Capsule ? 2 : 1 ); i++ )
+	{
+		if( outside[ i ] <= 0.0f )
+		{
+			continue;
+		}
+
+		glm::vec2 nearest;
+		float nearestDistanceSquared = FLT_MAX;
+		for( int j = 0; j < (int)vertices.size(); j++ )
+		{
+			glm::vec2 point = ClosestPointOnSegment( ends[ i ], vertices[ j ], vertices[ ( j + 1 ) % vertices.size() ] );
+			glm::vec2 offset = ends[ i ] - point;
+			if( glm::dot( offset, offset ) < nearestDistanceSquared )
+			{
+				nearestDistanceSquared = glm::dot( offset, offset );
+				nearest = point;
+			}
+		}
+
+		glm::vec2 normal = glm::normalize( ends[ i ] - nearest );
+		float startDistance = glm::dot( start - nearest, normal );
+		float endDistance = glm::dot( end - nearest, normal );
+		float separation = std::min( startDistance, endDistance ) - radius;
+		if( separation > maxSeparation )
+		{
+			maxSeparation = separation;
+			SetContact( collision, polygon, round, normal, ( startDistance <= endDistance ? start : end ) - normal * radius, separation );
+		}
+	}
+
+	return maxSeparation;
+}
+
+// CollideRound() done in Fixed math for deterministic mode.
+Fixed World::CollideRoundFixed( Polygon* aPolygon, Polygon* bPolygon, Collision* collision )
+{
+	if( aPolygon->__shape == ShapeType::Polygon )
+	{
+		return CollideRoundAndPolygonFixed( bPolygon, aPolygon, collision );
+	}
+	if( bPolygon->__shape == ShapeType::Polygon )
+	{
+		return CollideRoundAndPolygonFixed( aPolygon, bPolygon, collision );
+	}
+	return CollideRoundShapesFixed( aPolygon, bPolygon, collision );
+}
+
+// CollideRoundShapes() done in Fixed math for deterministic mode.
+Fixed World::CollideRoundShapesFixed( Polygon* aPolygon, Polygon* bPolygon, Collision* collision )
+{
+	FixedVector2 aPoint = FixedVector2( aPolygon->__globalVertices.front() );
+	FixedVector2 bPoint = FixedVector2( bPolygon->__globalVertices.front() );
+	if( aPolygon->__shape == ShapeType::Capsule || bPolygon->__shape == ShapeType::Capsule )
+	{
+		ClosestPointsOnSegments( aPoint, FixedVector2( aPolygon->__globalVertices.back() ), bPoint, FixedVector2( bPolygon->__globalVertices.back() ), &aPoint, &bPoint );
+	}
+
+	FixedVector2 offset = bPoint - aPoint;
+	Fixed distance = Fixed::Sqrt( FixedVector2::Dot( offset, offset ) );
+	FixedVector2 normal = FixedVector2( Fixed(), Fixed( 1 ) );
+	if( distance > Fixed() )
+	{
+		normal = FixedVector2( offset.x / distance, offset.y / distance );
+	}
+	else if( bPolygon->__position != aPolygon->__position )
+	{
+		normal = FixedVector2::Normalize( FixedVector2( bPolygon->__position ) - FixedVector2( aPolygon->__position ) );
+	}
+
+	Fixed bRadius = Fixed::FromFloat( bPolygon->__radius );
+	Fixed depth = distance - Fixed::FromFloat( aPolygon->__radius ) - bRadius;
+	SetContact( collision, aPolygon, bPolygon, normal.ToGLM(), ( bPoint - normal * bRadius ).ToGLM(), depth.ToFloat() );
+	return depth;
+}
+
+// CollideRoundAndPolygon() done in Fixed math for deterministic mode. Face normals are rebuilt from
+// the global vertices the same way TestSeparateAxisTheoremFixed() rebuilds them.
+Fixed World::CollideRoundAndPolygonFixed( Polygon* round, Polygon* polygon, Collision* collision )
+{
+	FixedVector2 start = FixedVector2( round->__globalVertices.front() );
+	FixedVector2 end = FixedVector2( round->__globalVertices.back() );
+	Fixed radius = Fixed::FromFloat( round->__radius );
+	std::vector<glm::vec2>& vertices = polygon->__globalVertices;
+
+	Fixed maxSeparation = -Fixed::Max();
+	Fixed startOutside = -Fixed::Max();
+	Fixed endOutside = -Fixed::Max();
+	for( int i = 0; i < (int)vertices.size(); i++ )
+	{
+		// CW ordering so we compute a left-normal.
+		FixedVector2 faceVertex = FixedVector2( vertices[ i ] );
+		FixedVector2 faceVector = FixedVector2::Normalize( FixedVector2( vertices[ ( i + 1 ) % vertices.size() ] ) - faceVertex );
+		FixedVector2 normal = FixedVector2( -faceVector.y, faceVector.x );
+
+		Fixed startDistance = FixedVector2::Dot( start - faceVertex, normal );
+		Fixed endDistance = FixedVector2::Dot( end - faceVertex, normal );
+		startOutside = startDistance > startOutside ? startDistance : startOutside;
+		endOutside = endDistance > endOutside ? endDistance : endOutside;
+
+		bool isStartDeeper = startDistance <= endDistance;
+		Fixed separation = ( isStartDeeper ? startDistance : endDistance ) - radius;
+		if( separation > maxSeparation )
+		{
+			maxSeparation = separation;
+			SetContact( collision, polygon, round, normal.ToGLM(), ( ( isStartDeeper ? start : end ) - normal * radius ).ToGLM(), separation.ToFloat() );
+		}
+	}
+
+	if( round->__shape == ShapeType::Capsule )
+	{
+		FixedVector2 axis = FixedVector2::Normalize( end - start );
+		FixedVector2 sideNormals[ 2 ] = { FixedVector2( -axis.y, axis.x ), FixedVector2( axis.y, -axis.x ) };
+		for( FixedVector2 normal : sideNormals )
+		{
+			Fixed minDistance = Fixed::Max();
+			glm::vec2 minVertex;
+			for( glm::vec2 vertex : vertices )
+			{
+				Fixed distance = FixedVector2::Dot( FixedVector2( vertex ) - start, normal );
+				if( distance < minDistance )
+				{
+					minDistance = distance;
+					minVertex = vertex;
+				}
+			}
+
+			Fixed separation = minDistance - radius;
+			if( separation > maxSeparation )
+			{
+				maxSeparation = separation;
+				SetContact( collision, round, polygon, normal.ToGLM(), minVertex, separation.ToFloat() );
+			}
+		}
+	}
+
+	FixedVector2 ends[ 2 ] = { start, end };
+	Fixed outside[ 2 ] = { startOutside, endOutside };
+	for( int i = 0; i < ( round->__shape == ShapeType::Capsule ? 2 : 1 ); i++ )
+	{
+		if( outside[ i ] <= Fixed() )
+		{
+			continue;
+		}
+
+		FixedVector2 nearest;
+		Fixed nearestDistanceSquared = Fixed::Max();
+		for( int j = 0; j < (int)vertices.size(); j++ )
+		{
+			FixedVector2 point = ClosestPointOnSegment( ends[ i ], FixedVector2( vertices[ j ] ), FixedVector2( vertices[ ( j + 1 ) % vertices.size() ] ) );
+			FixedVector2 offset = ends[ i ] - point;
+			Fixed distanceSquared = FixedVector2::Dot( offset, offset );
+			if( distanceSquared < nearestDistanceSquared )
+			{
+				nearestDistanceSquared = distanceSquared;
+				nearest = point;
+			}
+		}
+
+		FixedVector2 normal = FixedVector2::Normalize( ends[ i ] - nearest );
+		Fixed startDistance = FixedVector2::Dot( start - nearest, normal );
+		Fixed endDistance = FixedVector2::Dot( end - nearest, normal );
+		bool isStartDeeper = startDistance <= endDistance;
+		Fixed separation = ( isStartDeeper ? startDistance : endDistance ) - radius;
+		if( separation > maxSeparation )
+		{
+			maxSeparation = separation;
+			SetContact( collision, polygon, round, normal.ToGLM(), ( ( isStartDeeper ? start : end ) - normal * radius ).ToGLM(), separation.ToFloat() );
+		}
+	}
+
+	return maxSeparation;
+}
+
+float World::CollisionResponse(Polygon * aPolygon, Polygon * bPolygon, Collision collision)
+{
+	// Static and kinematic polygons have a cached inverse mass and inverse rotational inertia of 0, so they never react and we never divide by their mass
+	float invMassA = aPolygon->GetInverseMass();
+	float invMassB = bPolygon->GetInverseMass();
+	if (invMassA + invMassB == 0.0f)
+		return 0.0f;
+
+	// The impulse along the face normal that reverses the closing speed of the contact points (spin included), times the restitution
+	float impulseScalar = -collision.GetAngularMomentum();
+	//No need to continue if the contact points are separating already
+	if (impulseScalar <= 0.0f)
+		return 0.0f;
+	glm::vec2 impulse = impulseScalar * collision.faceNormal; // Impulse is the impulse scalar multiplied by the normal of the face polygon
+
+	// The same impulse at the contact point also spins each polygon by its inverse rotational inertia times r x impulse
+	glm::vec2 aCenterOfMassToContact = collision.contactVertex - aPolygon->GetPosition();
+	glm::vec2 bCenterOfMassToContact = collision.contactVertex - bPolygon->GetPosition();
+
+	if(invMassA > 0.0f) // if polygon is dynamic then we react to the collision
+	{
+		aPolygon->SetVelocity(aPolygon->GetVelocity() - (invMassA * impulse)); // Add impulse velocity
+		aPolygon->SetRotationalVelocity(aPolygon->GetRotationalVelocity() - aPolygon->GetInverseRotationalInertia() * Cross(aCenterOfMassToContact, impulse));
+	}
+	if (invMassB > 0.0f) 
+	{
+		bPolygon->SetVelocity(bPolygon->GetVelocity() + (invMassB * impulse));
+		bPolygon->SetRotationalVelocity(bPolygon->GetRotationalVelocity() + bPolygon->GetInverseRotationalInertia() * Cross(bCenterOfMassToContact, impulse));
+	}
+
+	return impulseScalar; // Report how hard we pushed for contact events
+}
+
+
+// CollisionResponse() done in Fixed math for deterministic mode.
+float World::CollisionResponseFixed( Polygon* aPolygon, Polygon* bPolygon, Collision collision )
+{
+	// Static and kinematic Polygons have cached inverses of 0, so they never react.
+	bool isAMovable = aPolygon->GetInverseMass() > 0.0f;
+	bool isBMovable = bPolygon->GetInverseMass() > 0.0f;
+	if( !isAMovable && !isBMovable )
+	{
+		return 0.0f;
+	}
+
+	Fixed impulseScalar = -collision.GetAngularMomentumFixed();
+	if( impulseScalar <= Fixed() )
+	{
+		return 0.0f;
+	}
+	FixedVector2 impulse = FixedVector2( collision.faceNormal ) * impulseScalar;
+	FixedVector2 contact = FixedVector2( collision.contactVertex );
+
+	if( isAMovable )
+	{
+		FixedVector2 aCenterOfMassToContact = contact - FixedVector2( aPolygon->GetPosition() );
+		Fixed aSpin = Fixed::FromFloat( aPolygon->GetRotationalVelocity() ) - Fixed::FromFloat( aPolygon->GetInverseRotationalInertia() ) * FixedVector2::Cross( aCenterOfMassToContact, impulse );
+		aPolygon->SetVelocity( ( FixedVector2( aPolygon->GetVelocity() ) - impulse * Fixed::FromFloat( aPolygon->GetInverseMass() ) ).ToGLM() );
+		aPolygon->SetRotationalVelocity( aSpin.ToFloat() );
+	}
+	if( isBMovable )
+	{
+		FixedVector2 bCenterOfMassToContact = contact - FixedVector2( bPolygon->GetPosition() );
+		Fixed bSpin = Fixed::FromFloat( bPolygon->GetRotationalVelocity() ) + Fixed::FromFloat( bPolygon->GetInverseRotationalInertia() ) * FixedVector2::Cross( bCenterOfMassToContact, impulse );
+		bPolygon->SetVelocity( ( FixedVector2( bPolygon->GetVelocity() ) + impulse * Fixed::FromFloat( bPolygon->GetInverseMass() ) ).ToGLM() );
+		bPolygon->SetRotationalVelocity( bSpin.ToFloat() );
+	}
+
+	return impulseScalar.ToFloat();
+}
+
+
+// Trace rays[ begin ] up to rays[ end - 1 ] through the broadphase RayPacket::SIZE at a time and 
+// write the closest hit of each into the matching hits entry (a 0 handle for misses). Only reads the
+// World, so several threads can run this on different ranges at once.
+void World::RaycastPackets( const RaycastInput* rays, RaycastHit* hits, int begin, int end )
+{
+	for( int packetBegin = begin; packetBegin < end; packetBegin += RayPacket::SIZE )
+	{
+		int packetSize = std::min( end - packetBegin, (int)RayPacket::SIZE );
+		RayPacket packet;
+		Polygon* closestPolygons[ RayPacket::SIZE ] = {};
+		glm::vec2 closestNormals[ RayPacket::SIZE ];
+		for( int lane = 0; lane < packetSize; lane++ )
+		{
+			const RaycastInput& ray = rays[ packetBegin + lane ];
+			glm::vec2 direction = glm::vec2( ray.direction.x, ray.direction.y );
+			if( ray.maxDistance > 0.0f && ( direction.x != 0.0f || direction.y != 0.0f ) )
+			{
+				glm::vec2 origin = glm::vec2( ray.origin.x, ray.origin.y );
+				packet.SetRay( lane, origin, origin + glm::normalize( direction ) * ray.maxDistance, ray.mask );
+			}
+		}
+
+		auto raycastPolygon = [&]( int proxyId, int* laneHits )
+		{
+			unsigned int category = __broadphase.GetCategory( proxyId );
+			int anyHit = 0;
+			for( int lane = 0; lane < RayPacket::SIZE; lane++ )
+			{
+				laneHits[ lane ] &= ( category & packet.mask[ lane ] ) != 0;
+				anyHit |= laneHits[ lane ];
+			}
+
+			float fractions[ RayPacket::SIZE ];
+			glm::vec2 normals[ RayPacket::SIZE ];
+			Polygon* polygon = __broadphase.GetPolygon( proxyId );
+			if( !anyHit || !polygon->RayCastPacket( packet, laneHits, fractions, normals ) )
+			{
+				return;
+			}
+
+			// Clip every ray that hit so the rest of the walk only looks for closer hits.
+			for( int lane = 0; lane < RayPacket::SIZE; lane++ )
+			{
+				if( laneHits[ lane ] )
+				{
+					packet.maxFraction[ lane ] = fractions[ lane ];
+					closestPolygons[ lane ] = polygon;
+					closestNormals[ lane ] = normals[ lane ];
+				}
+			}
+		};
+		__broadphase.RayCastPacket( packet, raycastPolygon );
+
+		for( int lane = 0; lane < packetSize; lane++ )
+		{
+			RaycastHit& hit = hits[ packetBegin + lane ];
+			if( closestPolygons[ lane ] != NULL )
+			{
+				float fraction = packet.maxFraction[ lane ];
+				glm::vec2 point = glm::vec2( packet.originX[ lane ], packet.originY[ lane ] ) + fraction * glm::vec2( packet.directionX[ lane ], packet.directionY[ lane ] );
+				hit.handle = closestPolygons[ lane ]->__handle;
+				hit.point.x = point.x;
+				hit.point.y = point.y;
+				hit.normal.x = closestNormals[ lane ].x;
+				hit.normal.y = closestNormals[ lane ].y;
+				hit.fraction = fraction;
+			}
+			else
+			{
+				hit = RaycastHit();
+			}
+		}
+	}
+}
+
+
+// Finds every Polygon in one of the collision layers in mask that overlaps __queryPolygon (whose 
+// local vertices the caller has already filled in) placed at position and rotation. The broadphase 
+// narrows things down to the Polygons whose boxes overlap, then the same SAT test Step() uses has 
+// the final say. Writes up to capacity handles into handles, in handle order, and returns how many 
+// matched in total (which can be more than capacity). The query Polygon and the result list are 
+// reused from call to call, so once they have grown to fit, queries don't allocate.
+int World::QueryOverlaps( glm::vec2 position, float rotation, unsigned int mask, POLYGON_HANDLE* handles, int capacity )
+{
+	Polygon* queryPolygon = __queryPolygon;
+	queryPolygon->__position = position;
+	queryPolygon->__rotation = rotation;
+	queryPolygon->__isDeterministic = __isDeterministic;
+	queryPolygon->UpdateGlobalVertices();
+	queryPolygon->UpdateFaces();
+
+	__queryResults.clear();
+	auto testPolygon = [&]( int proxyId )
+	{
+		Polygon* polygon = __broadphase.GetPolygon( proxyId );
+		if( ( __broadphase.GetCategory( proxyId ) & mask ) != 0 && TestPieceOverlap( queryPolygon, polygon ) )
+		{
+			__queryResults.push_back( polygon->__handle );
+		}
+		return true;
+	};
+	__broadphase.Query( queryPolygon->__aabb, testPolygon );
+
+	// Handle order rather than tree order, so which handles make the cut doesn't depend on history.
+	std::sort( __queryResults.begin(), __queryResults.end() );
+	int count = (int)__queryResults.size();
+	std::copy( __queryResults.begin(), __queryResults.begin() + std::min( count, std::max( capacity, 0 ) ), handles );
+	return count;
+}
+
+
+
+// PUBLIC
+
+// Constructor: Defaults a bunch of values on startup.
+World::World( float fixedTimestepSeconds, float gravityAcceleration )
+	: __gravityAcceleration( gravityAcceleration )
+	, __accumulatedTimeSeconds( 0.0f )
+	, __currentTimeSeconds( 0.0f )
+	, __fixedTimestepSeconds( fixedTimestepSeconds )
+	, __isDeterministic( false )
+	, __substepCount( 0 )
+	, __maxStepsPerUpdate( 0 )
+	, __stateHash( 0 )
+	, __recorder( NULL )
+	, __nextHandle( 1 )
+	, __polygonPool()
+	, __polygons( PolygonMap::key_compare(), PolygonMap::allocator_type( &__polygonPool ) )
+	, __isAllocationCheckEnabled( false )
+	, __isSleepEnabled( false )
+	, __frameArena()
+	, __collisions( &__frameArena )
+	, __sensorOverlaps( &__frameArena )
+	, __sleepingContacts( std::vector<Collision>() )
+	, __broadphase( DynamicTree() )
+	, __pairCandidates( &__frameArena )
+	, __contactConstraints( &__frameArena )
+	, __awakePolygons( &__frameArena )
+	, __queryPolygon( new Polygon() )
+	, __queryResults( std::vector<POLYGON_HANDLE>() )
+{
+	ReserveContacts( INITIAL_CONTACT_CAPACITY );
+}
+
+// Destructor: Closes any recording in progress. The Polygons go with __polygonPool.
+World::~World()
+{
+	delete __recorder;
+	delete __queryPolygon;
+}
+
+// Update the World's clock by taking the in deltaTimeSeconds and calling Step() once for each 
+// interval of __fixedTimestepSeconds so the simulations catches up to real time.
+// Note: This is the time accumulator pattern that we'll discuss in class!
+// The ContactEvents from the previous Update() are dropped first (see GetContacts()).
+// With a step cap (see SetMaxStepsPerUpdate()), whole steps still owed once the cap is reached are 
+// dropped rather than carried over, so one slow frame can't snowball into the next.
+void World::Update( float deltaTimeSeconds )
+{
+	__contactEvents.clear();
+	__accumulatedTimeSeconds += deltaTimeSeconds;
+	int stepCount = 0;
+	while( __accumulatedTimeSeconds >= __fixedTimestepSeconds )
+	{
+		// Only the part of a step left over is kept, so the interpolation alpha still lines up.
+		if( __maxStepsPerUpdate > 0 && stepCount == __maxStepsPerUpdate )
+		{
+			__accumulatedTimeSeconds = std::fmod( __accumulatedTimeSeconds, __fixedTimestepSeconds );
+			break;
+		}
+		stepCount++;
+		__accumulatedTimeSeconds -= __fixedTimestepSeconds;
+		Step( __fixedTimestepSeconds );
+		__currentTimeSeconds += __fixedTimestepSeconds;
+	}
+}
+
+// Take a Polygon from __polygonPool, give it its shape and add it to the World (see AddPolygon()).
+POLYGON_HANDLE World::CreatePolygon( const TransportVector2* vertices, int verticesLength, glm::vec2 position, float rotation, float mass, bool useGravity, bool isStatic )
+{
+	Polygon* polygon = __polygonPool.Acquire();
+	polygon->Reset( position, rotation, mass, useGravity, isStatic );
+	try
+	{
+		SetVertices( polygon, vertices, verticesLength );
+	}
+	catch( ... )
+	{
+		// Bad vertices: the Polygon goes straight back to the pool instead of going missing.
+		ReleasePolygon( polygon );
+		throw;
+	}
+	return AddPolygon( polygon );
+}
+
+// CreatePolygon() for a circle of the given radius centered on position (see Polygon::SetCircle()).
+POLYGON_HANDLE World::CreateCircle( glm::vec2 position, float radius, float rotation, float mass, bool useGravity, bool isStatic )
+{
+	return CreateCapsule( glm::vec2(), glm::vec2(), radius, position, rotation, mass, useGravity, isStatic );
+}
+
+// CreatePolygon() for a capsule around the segment from a to b in local space (see 
+// Polygon::SetCapsule()).
+POLYGON_HANDLE World::CreateCapsule( glm::vec2 a, glm::vec2 b, float radius, glm::vec2 position, float rotation, float mass, bool useGravity, bool isStatic )
+{
+	Polygon* polygon = __polygonPool.Acquire();
+	polygon->Reset( position, rotation, mass, useGravity, isStatic );
+	try
+	{
+		polygon->SetCapsule( a, b, radius );
+	}
+	catch( ... )
+	{
+		ReleasePolygon( polygon );
+		throw;
+	}
+	return AddPolygon( polygon );
+}
+
+// CreatePolygon() for a compound of several convex pieces (see SetPieces()).
+POLYGON_HANDLE World::CreateCompound( const TransportVector2* vertices, const int* pieceVertexCounts, int pieceCount, glm::vec2 position, float rotation, float mass, bool useGravity, bool isStatic )
+{
+	Polygon* polygon = __polygonPool.Acquire();
+	polygon->Reset( position, rotation, mass, useGravity, isStatic );
+	try
+	{
+		SetPieces( polygon, vertices, pieceVertexCounts, pieceCount );
+	}
+	catch( ... )
+	{
+		ReleasePolygon( polygon );
+		throw;
+	}
+	return AddPolygon( polygon );
+}
+
+// CreatePolygon() for count Polygons at once, for loading a level. Polygon i has the vertices from 
+// vertexOffsets[ i ] up to vertexOffsets[ i + 1 ] in vertices (so vertexOffsets holds count + 1 
+// offsets), positions[ i ], rotations[ i ], masses[ i ] and the PolygonFlags in flags[ i ], and its 
+// handle is written to handles[ i ]. Storage is reserved once up front, the shapes are built on up 
+// to threadCount threads and the broadphase gets all the new proxies in one go, so a level of tens
+// of thousands of Polygons loads in a few milliseconds. If any of the Polygons has bad vertices, 
+// none of them are created and the first one's exception is thrown.
+void World::CreatePolygonBatch( const TransportVector2* vertices, const int* vertexOffsets, int count, const TransportVector2* positions, const float* rotations, const float* masses, const int* flags, POLYGON_HANDLE* handles, int threadCount )
+{
+	if( count <= 0 )
+	{
+		return;
+	}
+	if( vertices == NULL || vertexOffsets == NULL || positions == NULL || rotations == NULL || masses == NULL || flags == NULL || handles == NULL )
+	{
+		throw std::exception( "PolygonCreateBatch() needs every array!" );
+	}
+
+	Reserve( __polygonPool.GetCapacity() - __polygonPool.GetFreeCount() + count );
+	std::vector<Polygon*> polygons( count );
+	for( int i = 0; i < count; i++ )
+	{
+		polygons[ i ] = __polygonPool.Acquire();
+		bool useGravity = ( flags[ i ] & POLYGON_USE_GRAVITY ) != 0;
+		bool isStatic = ( flags[ i ] & POLYGON_IS_STATIC ) != 0;
+		polygons[ i ]->Reset( glm::vec2( positions[ i ].x, positions[ i ].y ), rotations[ i ], masses[ i ], useGravity, isStatic );
+	}
+
+	std::vector<std::vector<std::vector<glm::vec2>>> outlines( count );
+	std::vector<std::exception_ptr> errors( count );
+	threadCount = std::max( 1, std::min( threadCount, count / MIN_BATCH_POLYGONS_PER_THREAD ) );
+	int polygonsPerThread = ( count + threadCount - 1 ) / threadCount;
+	std::vector<std::thread> workers;
+	for( int begin = polygonsPerThread; begin < count; begin += polygonsPerThread )
+	{
+		workers.emplace_back( &World::BuildBatchShapes, polygons.data(), vertices, vertexOffsets, outlines.data(), errors.data(), begin, std::min( begin + polygonsPerThread, count ) );
+	}
+	BuildBatchShapes( polygons.data(), vertices, vertexOffsets, outlines.data(), errors.data(), 0, std::min( polygonsPerThread, count ) );
+	for( std::thread& worker : workers )
+	{
+		worker.join();
+	}
+
+	for( int i = 0; i < count; i++ )
+	{
+		if( errors[ i ] != NULL )
+		{
+			for( Polygon* polygon : polygons )
+			{
+				ReleasePolygon( polygon );
+			}
+			std::rethrow_exception( errors[ i ] );
+		}
+	}
+
+	std::vector<ProxyInput> proxies( count );
+	for( int i = 0; i < count; i++ )
+	{
+		Polygon* polygon = polygons[ i ];
+		if( !outlines[ i ].empty() )
+		{
+			SetOutlines( polygon, outlines[ i ] );
+		}
+		polygon->SetIsKinematic( ( flags[ i ] & POLYGON_IS_KINEMATIC ) != 0 );
+		polygon->SetIsSensor( ( flags[ i ] & POLYGON_IS_SENSOR ) != 0 );
+		polygon->SetIsBullet( ( flags[ i ] & POLYGON_IS_BULLET ) != 0 );
+		if( __isDeterministic )
+		{
+			polygon->SetIsDeterministic( true );
+		}
+		polygon->__handle = GeneratePolygonHandle();
+		proxies[ i ].aabb = polygon->__aabb;
+		proxies[ i ].polygon = polygon;
+		proxies[ i ].category = polygon->__collisionCategory;
+		proxies[ i ].mask = polygon->__collisionMask;
+	}
+
+	std::vector<int> proxyIds( count );
+	__broadphase.CreateProxies( proxies.data(), count, proxyIds.data() );
+	for( int i = 0; i < count; i++ )
+	{
+		Polygon* polygon = polygons[ i ];
+		polygon->__proxyId = proxyIds[ i ];
+		handles[ i ] = polygon->__handle;
+		__polygons.emplace_hint( __polygons.end(), polygon->__handle, polygon );
+	}
+}
+
+// Destroy the Polygon at the provided handle by erasing the mapping in __polygons and giving the
+// Polygon back to __polygonPool.
+void World::DestroyPolygon( POLYGON_HANDLE handle )
+{
+	auto pair = __polygons.find( handle );
+	Polygon* polygon = pair->second;
+	__polygons.erase( pair );
+	__broadphase.DestroyProxy( polygon->__proxyId );
+	WakePolygon( polygon );
+	ForgetContacts( __collisions, polygon );
+	ForgetContacts( __sensorOverlaps, polygon );
+	ForgetContacts( __sleepingContacts, polygon );
+	ReleasePolygon( polygon );
+}
+
+// Make sure capacity Polygons can be alive at once without the World allocating anything to create
+// them: the pool, the handle map's nodes and the broadphase's tree nodes are all grown up front. 
+// Each piece of a compound takes a Polygon from the pool as well. The contact lists and the frame 
+// arena (from the next step on) get room for them to step without allocating too.
+void World::Reserve( int capacity )
+{
+	__polygonPool.Reserve( capacity );
+	__broadphase.Reserve( 2 * capacity );
+	ReserveContacts( capacity * RESERVED_CONTACTS_PER_POLYGON );
+
+	// Room in __frameArena for a step with every Polygon awake and in that many contacts. The per-step
+	// lists double as they grow and abandon their old storage to the arena, hence twice the size.
+	size_t contactBytes = sizeof( Collision ) + sizeof( ContactConstraint ) + sizeof( Polygon* );
+	__frameArena.Reserve( 2 * (size_t)capacity * ( sizeof( Polygon* ) + RESERVED_CONTACTS_PER_POLYGON * contactBytes ) );
+}
+
+// Grow the contact lists that have to outlive a single step (so can't come from __frameArena) to hold
+// contactCount contacts. Like the arena, they keep whatever they grow to, so steps only allocate 
+// while contacts reach a count they've never reached before.
+void World::ReserveContacts( int contactCount )
+{
+	__sleepingContacts.reserve( contactCount );
+	__contactEvents.reserve( contactCount );
+	__contactKeys.reserve( contactCount );
+	__previousContactKeys.reserve( contactCount );
+}
+
+// How many Polygons the World can hold before its pool has to grow.
+int World::GetPolygonCapacity()
 {
-	return __nextHandle++;
+	return __polygonPool.GetCapacity();
 }
 
-// Handles a single physics step.
-void World::Step( float deltaTimeSeconds )
+// If a Polygon exists at the provided handle, return a reference to it.
+Polygon* World::GetPolygon( POLYGON_HANDLE handle )
 {
-	// Clean out collisions from last frame.
-	__collisions.clear();
+	auto hasHandle = __polygons.count( handle );
+	if( !hasHandle )
+	{
+		throw std::exception( "No polygon exists at this handle!" );
+	}
+	return __polygons.at( handle );
+}
 
-	// Collision detection.
-	for( auto aIterator = __polygons.begin(); aIterator != __polygons.end(); ++aIterator )
+// Bring the broadphase up to date with a Polygon that has moved, rotated or changed shape (or hand it
+// a proxy if it doesn't have one yet). Cheap when the Polygon is still inside its fat box.
+void World::SynchronizeProxy( Polygon* polygon )
+{
+	if( polygon->__proxyId == DynamicTree::NULL_NODE )
 	{
-		Polygon* aPolygon = aIterator->second;
+		polygon->__proxyId = __broadphase.CreateProxy( polygon->__aabb, polygon, polygon->__collisionCategory, polygon->__collisionMask );
+	}
+	else
+	{
+		__broadphase.MoveProxy( polygon->__proxyId, polygon->__aabb );
+	}
+}
 
-		for( auto bIterator = aIterator; bIterator != __polygons.end(); ++bIterator )
+// Give a Polygon a new shape (bring the broadphase up to date with SynchronizeProxy() afterwards). 
+// Convex outlines, and anything that isn't a simple polygon, go straight to Polygon::SetVertices() 
+// and end up as their convex hull. Concave outlines are split into convex pieces instead (see 
+// Polygon::DecomposeOutline()), each one a Polygon from __polygonPool, so a concave level prop is 
+// still a single body with a single broadphase proxy. Bad vertices throw and leave the shape alone.
+void World::SetVertices( Polygon* polygon, const TransportVector2* vertices, int verticesLength )
+{
+	std::vector<std::vector<glm::vec2>> outlines;
+	std::vector<Polygon*> oldPieces;
+	oldPieces.swap( polygon->__pieces );
+	if( !Polygon::DecomposeOutline( vertices, verticesLength, outlines ) )
+	{
+		try
 		{
-			Polygon* bPolygon = bIterator->second;
+			polygon->SetVertices( vertices, verticesLength );
+		}
+		catch( ... )
+		{
+			polygon->__pieces.swap( oldPieces );
+			throw;
+		}
+		ReleasePieces( oldPieces );
+		return;
+	}
 
-			// We don't want to test collisions between this polygon and itself!
-			if( aPolygon == bPolygon )
-			{
-				continue;
-			}
+	ReleasePieces( oldPieces );
+	SetOutlines( polygon, outlines );
+}
 
-			// Actually test whether this pair collides and store the collision if so.
-			Collision collision;
-			if( TestCollision( aPolygon, bPolygon, &collision ) )
+// Give a Polygon a new shape made of several convex pieces that share its transform, its mass and 
+// its inertia, like a ship built from parts (bring the broadphase up to date with SynchronizeProxy()
+// afterwards). vertices holds the local vertices of every piece back to back and pieceVertexCounts 
+// says how many of them belong to each piece. Each piece becomes the convex hull of its vertices, 
+// the same as Polygon::SetVertices(). Bad vertices throw and leave the shape alone.
+void World::SetPieces( Polygon* polygon, const TransportVector2* vertices, const int* pieceVertexCounts, int pieceCount )
+{
+	if( vertices == NULL || pieceVertexCounts == NULL || pieceCount <= 0 )
+	{
+		throw std::exception( "A compound needs at least one piece!" );
+	}
+
+	std::vector<Polygon*> pieces;
+	try
+	{
+		for( int i = 0; i < pieceCount; i++ )
+		{
+			if( pieceVertexCounts[ i ] <= 0 )
 			{
-				__collisions.push_back( collision );
+				throw std::exception( "Every piece needs at least one vertex!" );
 			}
+			Polygon* piece = __polygonPool.Acquire();
+			pieces.push_back( piece );
+			piece->Reset( polygon->__position, polygon->__rotation, 1.0f, false, false );
+			piece->BuildConvexHull( vertices, pieceVertexCounts[ i ] );
+			vertices += pieceVertexCounts[ i ];
 		}
 	}
-
-	// Collision resolution.
-	for( auto collision : __collisions )
+	catch( ... )
 	{
-		CollisionResponse(collision.facePolygon, collision.contactPolygon, collision);		
+		ReleasePieces( pieces );
+		throw;
 	}
 
-	// Integrate force -> acceleration -> velocity -> position.
-	for ( auto aIterator = __polygons.begin(); aIterator != __polygons.end(); ++aIterator )
+	ReleasePieces( polygon->__pieces );
+	polygon->__pieces.swap( pieces );
+	polygon->BuildCompound();
+}
+
+// Put a Polygon into the collision layers in category and let it collide only with Polygons in the 
+// layers in mask. Two Polygons collide only if each one's category is in the other's mask. Every 
+// Polygon starts in layer 1 and colliding with everything.
+void World::SetCollisionFilter( Polygon* polygon, unsigned int category, unsigned int mask )
+{
+	polygon->__collisionCategory = category;
+	polygon->__collisionMask = mask;
+	__broadphase.SetProxyFilter( polygon->__proxyId, category, mask );
+}
+
+// Wake a Polygon up so the next step moves it again, along with everything that is asleep against 
+// it (it may have just moved out from under them). The next step wakes the rest of their islands.
+void World::WakePolygon( Polygon* polygon )
+{
+	polygon->__sleepTime = 0.0f;
+	if( polygon->__isAwake && !polygon->__isStatic )
 	{
-		Polygon* aPolygon = aIterator->second;
+		return;
+	}
 
-		// Apply gravity if this polygon is expecting it.
-		if ( aPolygon->GetUseGravity() )
+	polygon->__isAwake = true;
+	for( Collision contact : __sleepingContacts )
+	{
+		Polygon* other = contact.facePolygon == polygon ? contact.contactPolygon : contact.contactPolygon == polygon ? contact.facePolygon : NULL;
+		if( other != NULL && !other->__isStatic )
 		{
-			aPolygon->Accelerate( glm::vec2( 0.0f, __gravityAcceleration * deltaTimeSeconds ) );
+			other->__isAwake = true;
+			other->__sleepTime = 0.0f;
 		}
+	}
+}
+
+// Get the current physics clock time. This time exactly reflects the amount of time that the 
+// World has simulated up to now and does not include accumulated time that has not factored 
+// into a simulation step yet.
+float World::GetCurrentTimeSeconds()
+{
+	return __currentTimeSeconds;
+}
+
+float World::GetFixedTimestepSeconds()
+{
+	return __fixedTimestepSeconds;
+}
+
+// How far (0 to 1) the accumulated time is into the next step. Drawing each Polygon at 
+// mix( previous, current, alpha ) of its previous and current pose hides the fixed timestep without
+// taking any extra steps.
+float World::GetInterpolationAlpha()
+{
+	return __accumulatedTimeSeconds / __fixedTimestepSeconds;
+}
+
+// The most steps a single Update() will take, or 0 for no limit.
+int World::GetMaxStepsPerUpdate()
+{
+	return __maxStepsPerUpdate;
+}
+
+// Cap how many steps a single Update() may take (0, the default, means no limit). Once a hitch has 
+// left more time owed than that, the rest is dropped: the simulation runs slower than real time for
+// a moment instead of falling further and further behind. Lockstep clients need the same cap.
+void World::SetMaxStepsPerUpdate( int maxStepsPerUpdate )
+{
+	__maxStepsPerUpdate = std::max( maxStepsPerUpdate, 0 );
+}
 
-		// Maybe here is a good place to account for any forces acting on your polygons...
-		// TODO
+float World::GetGravityAcceleration()
+{
+	return __gravityAcceleration;
+}
 
-		// Integrate velocity to position (Euler method).
-		aPolygon->Translate( aPolygon->GetVelocity() * deltaTimeSeconds );
+// Get the Recorder logging calls made on this World, or NULL if nothing is being recorded.
+Recorder* World::GetRecorder()
+{
+	return __recorder;
+}
 
-		// Integrate rotational velocity to rotation (Euler method).
-		aPolygon->Rotate( aPolygon->GetRotationalVelocity() * deltaTimeSeconds );
+// Hand a Recorder over to this World, which deletes it (flushing the log) when it is replaced or 
+// when the World is destroyed. Pass NULL to stop recording.
+void World::SetRecorder( Recorder* recorder )
+{
+	if( __recorder != recorder )
+	{
+		delete __recorder;
 	}
+	__recorder = recorder;
 }
 
-bool World::TestCollision( Polygon* aPolygon, Polygon* bPolygon, Collision* maybeCollision )
+// Get the number of bytes Snapshot() needs to save this World as it is right now.
+int World::GetSnapshotSize()
 {
-	// Test SAT with the faces of aPolygon and the vertices of bPolygon.
-	if( !TestSeparateAxisTheorem( aPolygon, bPolygon, maybeCollision ) )
+	int vertexCount;
+	int pieceCount;
+	int pieceVertexCount;
+	CountSnapshotRecords( &vertexCount, &pieceCount, &pieceVertexCount );
+	return (int)( sizeof( SnapshotHeader ) + __polygons.size() * sizeof( PolygonSnapshot ) + ( vertexCount + pieceVertexCount ) * sizeof( glm::vec2 ) + pieceCount * sizeof( int ) + __sleepingContacts.size() * sizeof( ContactSnapshot ) + __contactKeys.size() * sizeof( unsigned long long ) );
+}
+
+// Save every Polygon's state, the handle allocator and the clock into buffer so Restore() can rewind
+// to this exact point later (for rollback). Returns the number of bytes written, or 0 if buffer is
+// too small to hold the snapshot.
+int World::Snapshot( void* buffer, int bufferLength )
+{
+	int snapshotSize = GetSnapshotSize();
+	if( buffer == NULL || bufferLength < snapshotSize )
 	{
-		return false;
+		return 0;
 	}
 
-	// Test SAT with the faces of bPolygon and the vertices of aPolygon.
-	if( !TestSeparateAxisTheorem( bPolygon, aPolygon, maybeCollision ) )
+	SnapshotHeader header;
+	header.version = SNAPSHOT_VERSION;
+	header.polygonCount = (int)__polygons.size();
+	CountSnapshotRecords( &header.vertexCount, &header.pieceCount, &header.pieceVertexCount );
+	header.nextHandle = __nextHandle;
+	header.accumulatedTimeSeconds = __accumulatedTimeSeconds;
+	header.currentTimeSeconds = __currentTimeSeconds;
+	header.sleepingContactCount = (int)__sleepingContacts.size();
+	header.contactKeyCount = (int)__contactKeys.size();
+	header.stateHash = __stateHash;
+
+	char* polygonRecords = (char*)buffer + sizeof( SnapshotHeader );
+	char* vertexRecords = polygonRecords + header.polygonCount * sizeof( PolygonSnapshot );
+	char* pieceRecords = vertexRecords + header.vertexCount * sizeof( glm::vec2 );
+	char* pieceVertexRecords = pieceRecords + header.pieceCount * sizeof( int );
+	char* contactRecords = pieceVertexRecords + header.pieceVertexCount * sizeof( glm::vec2 );
+
+	for( auto iterator = __polygons.begin(); iterator != __polygons.end(); ++iterator )
 	{
-		return false;
+		Polygon* polygon = iterator->second;
+		std::vector<glm::vec2>& vertices = *polygon->__vertices;
+
+		PolygonSnapshot state;
+		state.handle = iterator->first;
+		state.vertexCount = (int)vertices.size();
+		state.pieceCount = (int)polygon->__pieces.size();
+		state.position = polygon->__position;
+		state.velocity = polygon->__velocity;
+		state.rotation = polygon->__rotation;
+		state.rotationalVelocity = polygon->__rotationalVelocity;
+		state.mass = polygon->__mass;
+		state.rotationalInertia = polygon->__rotationalInertia;
+		state.useGravity = polygon->__useGravity ? 1 : 0;
+		state.isStatic = polygon->__isStatic ? 1 : 0;
+		state.collisionCategory = polygon->__collisionCategory;
+		state.collisionMask = polygon->__collisionMask;
+		state.isBullet = polygon->__isBullet ? 1 : 0;
+		state.isKinematic = polygon->__isKinematic ? 1 : 0;
+		state.isSensor = polygon->__isSensor ? 1 : 0;
+		state.shape = (int)polygon->__shape;
+		state.radius = polygon->__radius;
+		state.isAwake = polygon->__isAwake ? 1 : 0;
+		state.sleepTime = polygon->__sleepTime;
+		state.restPosition = polygon->__restPosition;
+		state.restRotation = polygon->__restRotation;
+		memcpy( polygonRecords, &state, sizeof( PolygonSnapshot ) );
+		polygonRecords += sizeof( PolygonSnapshot );
+
+		memcpy( vertexRecords, vertices.data(), vertices.size() * sizeof( glm::vec2 ) );
+		vertexRecords += vertices.size() * sizeof( glm::vec2 );
+
+		for( Polygon* piece : polygon->__pieces )
+		{
+			std::vector<glm::vec2>& pieceVertices = *piece->__vertices;
+			int pieceVertexCount = (int)pieceVertices.size();
+			memcpy( pieceRecords, &pieceVertexCount, sizeof( int ) );
+			pieceRecords += sizeof( int );
+			memcpy( pieceVertexRecords, pieceVertices.data(), pieceVertices.size() * sizeof( glm::vec2 ) );
+			pieceVertexRecords += pieceVertices.size() * sizeof( glm::vec2 );
+		}
 	}
 
-	// If we haven't exited out yet, return the collision object.
-	return true;
+	for( Collision contact : __sleepingContacts )
+	{
+		ContactSnapshot record;
+		record.faceHandle = contact.facePolygon->__handle;
+		record.contactHandle = contact.contactPolygon->__handle;
+		record.faceNormal = contact.faceNormal;
+		record.contactVertex = contact.contactVertex;
+		record.depth = contact.depth;
+		record.impulse = contact.impulse;
+		memcpy( contactRecords, &record, sizeof( ContactSnapshot ) );
+		contactRecords += sizeof( ContactSnapshot );
+	}
+	memcpy( contactRecords, __contactKeys.data(), __contactKeys.size() * sizeof( unsigned long long ) );
+
+	memcpy( buffer, &header, sizeof( SnapshotHeader ) );
+	return snapshotSize;
 }
 
-bool World::TestSeparateAxisTheorem( Polygon* facePolygon, Polygon* vertexPolygon, Collision* maybeCollision )
+// Rewind the World to a snapshot taken by Snapshot(). Polygons that still exist are overwritten in 
+// place, Polygons created since the snapshot are destroyed and Polygons destroyed since the snapshot
+// come back under their old handles. Collisions from the last step are cleared because they may 
+// point at Polygons that no longer exist; the next step recomputes them. The keys of the pairs that
+// were touching come back though, so that step sees the same beginnings and endings of contact as
+// the original timeline did.
+void World::Restore( const void* buffer, int bufferLength )
 {
-	// For each face in bPolygon
-	for( Face aFace : facePolygon->GetFaces() )
+	SnapshotHeader header;
+	if( buffer == NULL || bufferLength < (int)sizeof( SnapshotHeader ) )
 	{
-		// Find the vertex in bPolygon with the minimum distance from the face.
-		float minDistance = FLT_MAX;
-		glm::vec2 minVertex;
-		for( glm::vec2 bVertex : vertexPolygon->GetGlobalVertices() )
+		throw std::exception( "Snapshot buffer is too small!" );
+	}
+	memcpy( &header, buffer, sizeof( SnapshotHeader ) );
+	int snapshotSize = (int)( sizeof( SnapshotHeader ) + header.polygonCount * sizeof( PolygonSnapshot ) + ( header.vertexCount + header.pieceVertexCount ) * sizeof( glm::vec2 ) + header.pieceCount * sizeof( int ) + header.sleepingContactCount * sizeof( ContactSnapshot ) + header.contactKeyCount * sizeof( unsigned long long ) );
+	if( header.version != SNAPSHOT_VERSION || header.contactKeyCount < 0 || bufferLength < snapshotSize )
+	{
+		throw std::exception( "Snapshot buffer is invalid!" );
+	}
+
+	const char* polygonRecords = (const char*)buffer + sizeof( SnapshotHeader );
+	const glm::vec2* vertices = (const glm::vec2*)( polygonRecords + header.polygonCount * sizeof( PolygonSnapshot ) );
+	const int* pieceRecords = (const int*)( vertices + header.vertexCount );
+	const glm::vec2* pieceVertices = (const glm::vec2*)( pieceRecords + header.pieceCount );
+	const char* contactRecords = (const char*)( pieceVertices + header.pieceVertexCount );
+	const char* contactKeyRecords = contactRecords + header.sleepingContactCount * sizeof( ContactSnapshot );
+
+	// Every sleeping contact has to be between Polygons in the snapshot, which is checked before 
+	// anything is changed so a bad buffer leaves the World as it was.
+	for( int i = 0; i < header.sleepingContactCount; i++ )
+	{
+		ContactSnapshot record;
+		memcpy( &record, contactRecords + i * sizeof( ContactSnapshot ), sizeof( ContactSnapshot ) );
+		if( !HasPolygonRecord( polygonRecords, header.polygonCount, record.faceHandle ) || !HasPolygonRecord( polygonRecords, header.polygonCount, record.contactHandle ) )
 		{
-			float distance = aFace.GetGlobalDistance( bVertex );
-			if( distance < minDistance )
-			{
-				minDistance = distance;
-				minVertex = bVertex;
-			}
+			throw std::exception( "Snapshot buffer is invalid!" );
 		}
+	}
 
-		// If the distance to the nearest vertex in b is greater than 0, we can't be in collision.
-		if( minDistance > 0 )
+	// Both the snapshot and __polygons are sorted by handle, so walk them side by side.
+	auto iterator = __polygons.begin();
+	for( int i = 0; i < header.polygonCount; i++ )
+	{
+		PolygonSnapshot state;
+		memcpy( &state, polygonRecords, sizeof( PolygonSnapshot ) );
+
+		// Destroy Polygons created after the snapshot was taken.
+		while( iterator != __polygons.end() && iterator->first < state.handle )
 		{
-			return false;
+			__broadphase.DestroyProxy( iterator->second->__proxyId );
+			ReleasePolygon( iterator->second );
+			iterator = __polygons.erase( iterator );
 		}
 
-		// The least negative distance is the best candidate for depenetration.
-		if( minDistance > maybeCollision->depth )
+		if( iterator != __polygons.end() && iterator->first == state.handle )
 		{
-			maybeCollision->facePolygon = facePolygon;
-			maybeCollision->contactPolygon = vertexPolygon;
-			maybeCollision->contactVertex = minVertex;
-			maybeCollision->depth = minDistance;
-			maybeCollision->faceNormal = aFace.GetGlobalNormal();
+			RestorePolygon( iterator->second, polygonRecords, vertices, pieceRecords, pieceVertices );
+			++iterator;
+		}
+		else
+		{
+			__polygons.emplace_hint( iterator, state.handle, RestorePolygon( NULL, polygonRecords, vertices, pieceRecords, pieceVertices ) );
+		}
+
+		polygonRecords += sizeof( PolygonSnapshot );
+		vertices += state.vertexCount;
+		for( int j = 0; j < state.pieceCount; j++ )
+		{
+			pieceVertices += pieceRecords[ j ];
 		}
+		pieceRecords += state.pieceCount;
+	}
+	while( iterator != __polygons.end() )
+	{
+		__broadphase.DestroyProxy( iterator->second->__proxyId );
+		ReleasePolygon( iterator->second );
+		iterator = __polygons.erase( iterator );
 	}
 
-	return true;
+	__nextHandle = header.nextHandle;
+	__accumulatedTimeSeconds = header.accumulatedTimeSeconds;
+	__currentTimeSeconds = header.currentTimeSeconds;
+	__stateHash = header.stateHash;
+	__collisions.Clear();
+	__sensorOverlaps.Clear();
+	__contactEvents.clear();
+	__contactKeys.resize( header.contactKeyCount );
+	memcpy( __contactKeys.data(), contactKeyRecords, header.contactKeyCount * sizeof( unsigned long long ) );
+
+	// Sleeping Polygons won't look for their contacts again, so those come back with them (and count
+	// towards IsPolygonColliding() right away, the same as in ClearCollisions()).
+	__sleepingContacts.clear();
+	for( int i = 0; i < header.sleepingContactCount && __isSleepEnabled; i++ )
+	{
+		ContactSnapshot record;
+		memcpy( &record, contactRecords, sizeof( ContactSnapshot ) );
+		contactRecords += sizeof( ContactSnapshot );
+
+		Collision contact;
+		contact.facePolygon = __polygons.find( record.faceHandle )->second;
+		contact.contactPolygon = __polygons.find( record.contactHandle )->second;
+		contact.faceNormal = record.faceNormal;
+		contact.contactVertex = record.contactVertex;
+		contact.depth = record.depth;
+		contact.impulse = record.impulse;
+		contact.facePolygon->__contactCount++;
+		contact.contactPolygon->__contactCount++;
+		__sleepingContacts.push_back( contact );
+	}
 }
 
-void World::CollisionResponse(Polygon * aPolygon, Polygon * bPolygon, Collision collision)
+// Check if a polygon is intersecting any other. FindCollisions() keeps a count per Polygon, so this
+// is a single read rather than a search through every collision.
+bool World::IsPolygonColliding( Polygon* polygon )
 {
+	return polygon->__contactCount > 0;
+}
 
-	glm::vec2 relativeVelocity = bPolygon->GetVelocity() - aPolygon->GetVelocity(); // Get relative velocity between both polygons
-	float contactVelocity = glm::dot(relativeVelocity, collision.faceNormal); // Use dot product to get the contact velocity on the face normal
-	//No need to continue if velocities are separating already
-	if (contactVelocity > 0)
-		return;
+// IsPolygonColliding() for every Polygon at once: sets bit ( handle % 32 ) of bits[ handle / 32 ] for
+// each Polygon that is colliding (or overlapping a sensor) and clears the rest, writing at most 
+// wordCount words. Returns how many words it takes to cover every handle handed out so far.
+int World::GetCollidingBits( unsigned int* bits, int wordCount )
+{
+	int neededWordCount = ( __nextHandle + 31 ) / 32;
+	if( wordCount <= 0 )
+	{
+		return neededWordCount;
+	}
 
-	//Default restitution is 1.0f
-	//TODO add restitution to polygon
-	float restitution = 1.0f;
+	memset( bits, 0, std::min( wordCount, neededWordCount ) * sizeof( unsigned int ) );
+	auto setBit = [&]( POLYGON_HANDLE handle )
+	{
+		if( handle / 32 < wordCount )
+		{
+			bits[ handle / 32 ] |= 1u << ( handle % 32 );
+		}
+	};
+	for( Collision collision : __collisions )
+	{
+		setBit( collision.facePolygon->__handle );
+		setBit( collision.contactPolygon->__handle );
+	}
+	for( Collision overlap : __sensorOverlaps )
+	{
+		setBit( overlap.facePolygon->__handle );
+		setBit( overlap.contactPolygon->__handle );
+	}
+	for( Collision contact : __sleepingContacts )
+	{
+		setBit( contact.facePolygon->__handle );
+		setBit( contact.contactPolygon->__handle );
+	}
+	return neededWordCount;
+}
 
-	float impulseScalar = -(1.0f + restitution) * contactVelocity;
-	float invMassA = 1 / aPolygon->GetMass();
-	float invMassB = 1 / bPolygon->GetMass();
-	impulseScalar /= invMassA + invMassB;
-	glm::vec2 impulse = impulseScalar * collision.faceNormal; // Impulse is the impulse scalar multiplied by the normal of the face polygon
+// Copy up to capacity of the ContactEvents from the steps taken by the last Update() into contacts: 
+// every collision and sensor overlap (as CONTACT_BEGIN or CONTACT_PERSIST) and every pair that 
+// stopped touching (CONTACT_END), step by step. Returns how many there are in total, which can be 
+// more than capacity.
+int World::GetContacts( ContactEvent* contacts, int capacity )
+{
+	int count = (int)__contactEvents.size();
+	if( count > 0 && capacity > 0 )
+	{
+		memcpy( contacts, __contactEvents.data(), std::min( count, capacity ) * sizeof( ContactEvent ) );
+	}
+	return count;
+}
 
-	if(!aPolygon->GetIsStatic()) // if polygon is not static then we react to the collision
-		aPolygon->SetVelocity(aPolygon->GetVelocity() - (invMassA * impulse)); // Add impulse velocity
-	if (!bPolygon->GetIsStatic()) 
+// Find the closest Polygon in one of the collision layers in mask that a ray from origin along 
+// direction hits within maxDistance. The broadphase hands over only the Polygons whose boxes the ray 
+// passes through, nearest hit so far clipping the ray as it goes, and each of those is tested against
+// its cached face normals. Returns false (leaving result alone) if nothing was hit.
+bool World::Raycast( glm::vec2 origin, glm::vec2 direction, float maxDistance, unsigned int mask, RaycastResult* result )
+{
+	if( maxDistance <= 0.0f || ( direction.x == 0.0f && direction.y == 0.0f ) )
 	{
-		bPolygon->SetVelocity(bPolygon->GetVelocity() + (invMassB * impulse));
-		bPolygon->SetRotationalVelocity(-collision.GetAngularMomentum());
+		return false;
 	}
 
+	glm::vec2 end = origin + glm::normalize( direction ) * maxDistance;
+	Polygon* closestPolygon = NULL;
+	glm::vec2 closestNormal;
+	float closestFraction = 1.0f;
+
+	auto raycastPolygon = [&]( int proxyId, float maxFraction )
+	{
+		float fraction;
+		glm::vec2 normal;
+		if( ( __broadphase.GetCategory( proxyId ) & mask ) == 0 || !__broadphase.GetPolygon( proxyId )->RayCast( origin, end, maxFraction, &fraction, &normal ) )
+		{
+			return maxFraction;
+		}
+		closestPolygon = __broadphase.GetPolygon( proxyId );
+		closestNormal = normal;
+		closestFraction = fraction;
+		return fraction;
+	};
+	__broadphase.RayCast( origin, end, 1.0f, raycastPolygon );
+
+	if( closestPolygon == NULL )
+	{
+		return false;
+	}
+	result->polygon = closestPolygon;
+	result->point = origin + closestFraction * ( end - origin );
+	result->normal = closestNormal;
+	result->fraction = closestFraction;
+	return true;
 }
 
+// Raycast() for count rays at once, writing the closest hit of rays[ i ] straight into hits[ i ] 
+// (with a 0 handle for misses) and returning how many rays hit something. Rays are traced in packets
+// of RayPacket::SIZE, so rays that are next to each other in rays and head the same way (say, fanned
+// out from one origin) share most of their trip through the broadphase. With threadCount above 1 
+// the batch is split across up to that many threads, each with at least MIN_BATCH_RAYS_PER_THREAD 
+// rays; the World must not be changed until this returns. Doesn't allocate unless it starts threads.
+int World::RaycastBatch( const RaycastInput* rays, int count, RaycastHit* hits, int threadCount )
+{
+	if( count < 0 )
+	{
+		throw std::exception( "count can't be negative!" );
+	}
+	if( count == 0 )
+	{
+		return 0;
+	}
+	if( rays == NULL || hits == NULL )
+	{
+		throw std::exception( "rays and hits can't be null!" );
+	}
 
+	// Split on packet boundaries.
+	int packetCount = ( count + RayPacket::SIZE - 1 ) / RayPacket::SIZE;
+	threadCount = std::max( 1, std::min( threadCount, count / MIN_BATCH_RAYS_PER_THREAD ) );
+	int raysPerThread = ( packetCount + threadCount - 1 ) / threadCount * RayPacket::SIZE;
 
-// PUBLIC
+	if( threadCount == 1 )
+	{
+		RaycastPackets( rays, hits, 0, count );
+	}
+	else
+	{
+		std::vector<std::thread> workers;
+		for( int begin = raysPerThread; begin < count; begin += raysPerThread )
+		{
+			workers.emplace_back( &World::RaycastPackets, this, rays, hits, begin, std::min( begin + raysPerThread, count ) );
+		}
+		RaycastPackets( rays, hits, 0, std::min( raysPerThread, count ) );
+		for( std::thread& worker : workers )
+		{
+			worker.join();
+		}
+	}
 
-// Constructor: Defaults a bunch of values on startup.
-World::World( float fixedTimestepSeconds, float gravityAcceleration )
-	: __accumulatedTimeSeconds( 0.0f )
-	, __gravityAcceleration( gravityAcceleration )
-	, __fixedTimestepSeconds( fixedTimestepSeconds )
-	, __nextHandle( 1 )
-	, __polygons( std::map<POLYGON_HANDLE, Polygon*>() )
-{
+	int hitCount = 0;
+	for( int i = 0; i < count; i++ )
+	{
+		hitCount += hits[ i ].handle != 0 ? 1 : 0;
+	}
+	return hitCount;
+}
 
+// Find every Polygon in one of the collision layers in mask that overlaps aabb (touching counts). 
+// See QueryOverlaps() for how the results are written.
+int World::QueryAABB( AABB aabb, unsigned int mask, POLYGON_HANDLE* handles, int capacity )
+{
+	// CW ordering, like every other Polygon.
+	std::vector<glm::vec2>& vertices = *__queryPolygon->__vertices;
+	vertices.resize( 4 );
+	vertices[ 0 ] = glm::vec2( aabb.upper.x, aabb.upper.y );
+	vertices[ 1 ] = glm::vec2( aabb.upper.x, aabb.lower.y );
+	vertices[ 2 ] = glm::vec2( aabb.lower.x, aabb.lower.y );
+	vertices[ 3 ] = glm::vec2( aabb.lower.x, aabb.upper.y );
+	return QueryOverlaps( glm::vec2(), 0.0f, mask, handles, capacity );
 }
 
-// Destructor: Doesn't need to do anything.
-World::~World()
+// Find every Polygon in one of the collision layers in mask that overlaps the convex polygon with 
+// the given (CW ordered) local vertices placed at position and rotation. See QueryOverlaps() for how
+// the results are written.
+int World::QueryPolygon( const TransportVector2* vertices, int verticesLength, glm::vec2 position, float rotation, unsigned int mask, POLYGON_HANDLE* handles, int capacity )
 {
+	if( vertices == NULL || verticesLength < 3 )
+	{
+		throw std::exception( "A query polygon needs at least 3 vertices!" );
+	}
 
+	std::vector<glm::vec2>& localVertices = *__queryPolygon->__vertices;
+	localVertices.resize( verticesLength );
+	for( int i = 0; i < verticesLength; i++ )
+	{
+		localVertices[ i ] = glm::vec2( vertices[ i ].x, vertices[ i ].y );
+	}
+	return QueryOverlaps( position, rotation, mask, handles, capacity );
 }
 
-// Update the World's clock by taking the in deltaTimeSeconds and calling Step() once for each 
-// interval of __fixedTimestepSeconds so the simulations catches up to real time.
-// Note: This is the time accumulator pattern that we'll discuss in class!
-void World::Update( float deltaTimeSeconds )
+// Is this World running its steps in Fixed math?
+bool World::GetIsDeterministic()
 {
-	__accumulatedTimeSeconds += deltaTimeSeconds;
-	while( __accumulatedTimeSeconds >= __fixedTimestepSeconds )
+	return __isDeterministic;
+}
+
+// Switch deterministic mode on or off for this World and every Polygon in it. Every client in a 
+// lockstep session needs to switch it on before the first step.
+void World::SetIsDeterministic( bool isDeterministic )
+{
+	__isDeterministic = isDeterministic;
+	for( auto iterator = __polygons.begin(); iterator != __polygons.end(); ++iterator )
 	{
-		__accumulatedTimeSeconds -= __fixedTimestepSeconds;
-		Step( __fixedTimestepSeconds );
-		__currentTimeSeconds += __fixedTimestepSeconds;
+		iterator->second->SetIsDeterministic( isDeterministic );
+		SynchronizeProxy( iterator->second );
 	}
+	__stateHash = isDeterministic ? ComputeStateHash() : 0;
 }
 
-// Create a new Polygon instance and store it in the __polygons map so we can look it up by its
-// handle later.
-POLYGON_HANDLE World::CreatePolygon( std::vector<glm::vec2>* vertices, glm::vec2 position, float rotation, float mass, bool useGravity, bool isStatic )
+// How many sub-steps the soft contact solver splits each step into, or 0 for the original solver.
+int World::GetSubstepCount()
 {
-	auto handle = GeneratePolygonHandle();
-	__polygons.emplace( handle, new Polygon( vertices, position, rotation, mass, useGravity, isStatic ) );
-	return handle;
+	return __substepCount;
 }
 
-// Destroy the Polygon at the provided handle by erasing the mapping in __polygons and deleting 
-// the Polygon instance from the heap.
-void World::DestroyPolygon( POLYGON_HANDLE handle )
+// Switch between the original solver (0, the default), which hands out one impulse per collision 
+// and then integrates, and the sub-stepped soft contact solver (see SolveSubstepped()) with 
+// substepCount sub-steps per step. Deterministic mode always uses the original solver's Fixed math.
+void World::SetSubstepCount( int substepCount )
 {
-	auto pair = __polygons.find( handle );
-	Polygon* polygon = pair->second;
-	__polygons.erase( pair );
-	delete polygon;
+	__substepCount = std::max( substepCount, 0 );
 }
 
-// If a Polygon exists at the provided handle, return a reference to it.
-Polygon* World::GetPolygon( POLYGON_HANDLE handle )
+// Is Step() checking that it doesn't allocate?
+bool World::GetIsAllocationCheckEnabled()
 {
-	auto hasHandle = __polygons.count( handle );
-	if( !hasHandle )
+	return __isAllocationCheckEnabled;
+}
+
+// While enabled, Step() throws if it made any heap allocations. Turn it on once the World has run a
+// few steps of a typical scene, since the frame arena (and the broadphase and contact lists) still 
+// grow until they've seen the busiest step. Throws if the DLL was built without PHYSICS_ALLOCATION_CHECK,
+// since there's nothing counting the allocations then.
+void World::SetIsAllocationCheckEnabled( bool isAllocationCheckEnabled )
+{
+	if( isAllocationCheckEnabled && !AllocationCounter::GetIsCompiledIn() )
 	{
-		throw std::exception( "No polygon exists at this handle!" );
+		throw std::exception( "The allocation check needs a build with PHYSICS_ALLOCATION_CHECK defined!" );
 	}
-	return __polygons.at( handle );
+	__isAllocationCheckEnabled = isAllocationCheckEnabled;
 }
 
-// Get the current physics clock time. This time exactly reflects the amount of time that the 
-// World has simulated up to now and does not include accumulated time that has not factored 
-// into a simulation step yet.
-float World::GetCurrentTimeSeconds()
+// Can Polygons that have come to rest fall asleep?
+bool World::GetIsSleepEnabled()
 {
-	return __currentTimeSeconds;
+	return __isSleepEnabled;
 }
 
-// Check if 2 polygons are intersecting.
-bool World::IsPolygonColliding( Polygon* polygon )
+// Let Polygons (and whole piles of them) that have come to rest fall asleep, which takes them out of 
+// the step until something wakes them (see UpdateSleep()). Off by default. Turning it off wakes 
+// everything up.
+void World::SetIsSleepEnabled( bool isSleepEnabled )
 {
-	for( Collision collision : __collisions )
+	__isSleepEnabled = isSleepEnabled;
+	if( !isSleepEnabled )
 	{
-		if( polygon == collision.facePolygon )
+		for( auto iterator = __polygons.begin(); iterator != __polygons.end(); ++iterator )
 		{
-			return true;
-		}
-		else if( polygon == collision.contactPolygon )
-		{
-			return true;
+			iterator->second->__isAwake = true;
+			iterator->second->__sleepTime = 0.0f;
 		}
 	}
-	return false;
+}
+
+// Get the state hash produced by the most recent step in deterministic mode (0 otherwise).
+unsigned long long World::GetStateHash()
+{
+	return __stateHash;
 }
\ No newline at end of file
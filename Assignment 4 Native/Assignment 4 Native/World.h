@@ -1,10 +1,26 @@
 #pragma once
 #include <glm.hpp>
+#include <exception>
 #include <map>
 #include "POLYGON_HANDLE.c"
+#include "RaycastHit.c"
+#include "RaycastInput.c"
 #include "Polygon.h"
+#include "DynamicTree.h"
+#include "Collision.h"
+#include "ContactConstraint.h"
+#include "ContactEvent.c"
+#include "PolygonFlags.c"
+#include "FrameArena.h"
+#include "PolygonPool.h"
 
-struct Collision;
+class Fixed;
+struct RaycastResult;
+class Recorder;
+
+// Handle -> Polygon, sorted by handle so every pass over the World visits Polygons in the same order.
+// Its nodes come from the World's PolygonPool.
+typedef std::map<POLYGON_HANDLE, Polygon*, std::less<POLYGON_HANDLE>, PolygonPoolAllocator<std::pair<const POLYGON_HANDLE, Polygon*>>> PolygonMap;
 
 class World
 {
@@ -14,18 +30,85 @@ class World
 	float __accumulatedTimeSeconds;
 	float __currentTimeSeconds;
 	float __fixedTimestepSeconds;
+	bool __isDeterministic;
+	int __substepCount;
+	int __maxStepsPerUpdate;
+	unsigned long long __stateHash;
+	Recorder* __recorder;
 	POLYGON_HANDLE __nextHandle;
-	std::map<POLYGON_HANDLE, Polygon*> __polygons;
-	std::vector<Collision> __collisions;
+	PolygonPool __polygonPool;
+	PolygonMap __polygons;
+	bool __isAllocationCheckEnabled;
+	bool __isSleepEnabled;
+	FrameArena __frameArena; // Everything a single Step() needs for itself comes from here (see Step()).
+	FrameList<Collision> __collisions;
+	FrameList<Collision> __sensorOverlaps;
+	std::vector<Collision> __sleepingContacts; // Contacts between Polygons that are asleep, kept from step to step.
+	std::vector<ContactEvent> __contactEvents;
+	std::vector<unsigned long long> __contactKeys;
+	std::vector<unsigned long long> __previousContactKeys;
+	DynamicTree __broadphase;
+	FrameList<Polygon*> __pairCandidates;
+	FrameList<ContactConstraint> __contactConstraints;
+	FrameList<Polygon*> __awakePolygons;
+	Polygon* __queryPolygon;
+	std::vector<POLYGON_HANDLE> __queryResults;
 
 	POLYGON_HANDLE GeneratePolygonHandle();
+	POLYGON_HANDLE AddPolygon( Polygon* polygon );
 
 	void Step( float deltaTimeSeconds );
+	void FindCollisions();
+	void ClearCollisions();
+	void ResetFrameArena();
+	void ForgetContacts( FrameList<Collision>& contacts, Polygon* polygon );
+	void ForgetContacts( std::vector<Collision>& contacts, Polygon* polygon );
+	void ReleasePolygon( Polygon* polygon );
+	void ReleasePieces( std::vector<Polygon*>& pieces );
+	void SetOutlines( Polygon* polygon, std::vector<std::vector<glm::vec2>>& outlines );
+	static void BuildBatchShapes( Polygon** polygons, const TransportVector2* vertices, const int* vertexOffsets, std::vector<std::vector<glm::vec2>>* outlines, std::exception_ptr* errors, int begin, int end );
+	void SolveSubstepped( float deltaTimeSeconds );
+	void CorrectPositions();
+	bool IsActive( Polygon* polygon );
+	Polygon* FindIsland( Polygon* polygon );
+	void MergeIslands( Polygon* aPolygon, Polygon* bPolygon );
+	void WakeIslands();
+	void UpdateSleep( float deltaTimeSeconds );
+	void ReserveContacts( int contactCount );
+	void RecordContactEvents();
+	void AddContactEvent( Collision collision, ContactEventState state );
+	void SweepBullet( Polygon* bullet );
+	void SweepBulletFixed( Polygon* bullet );
+	float ComputeSeparation( Polygon* facePolygon, Polygon* vertexPolygon );
+	float ComputeSweepSeparation( Polygon* bullet, Polygon* other );
+	Fixed ComputeSeparationFixed( Polygon* facePolygon, Polygon* vertexPolygon );
+	Fixed ComputeSweepSeparationFixed( Polygon* bullet, Polygon* other );
+	Polygon* RestorePolygon( Polygon* polygon, const char* record, const glm::vec2* vertices, const int* pieceRecords, const glm::vec2* pieceVertices );
+	void Integrate( Polygon* polygon, float deltaTimeSeconds );
+	void IntegrateFixed( Polygon* polygon, float deltaTimeSeconds );
+	unsigned long long ComputeStateHash();
+	void CountSnapshotRecords( int* vertexCount, int* pieceCount, int* pieceVertexCount );
 
+	void FindPieceCollisions( Polygon* aPolygon, Polygon* bPolygon );
+	bool TestPieceOverlap( Polygon* aPolygon, Polygon* bPolygon );
 	bool TestCollision( Polygon* aPolygon, Polygon* bPolygon, Collision* collisionParams );
 	bool TestSeparateAxisTheorem( Polygon* facePolygon, Polygon* vertexPolygon, Collision* collisionParams );
+	bool TestSeparateAxisTheoremFixed( Polygon* facePolygon, Polygon* vertexPolygon, Collision* collisionParams );
+	bool TestBoxAxes( Polygon* facePolygon, Polygon* vertexPolygon, Collision* collisionParams );
+	bool TestOverlap( Polygon* aPolygon, Polygon* bPolygon );
+	bool TestOverlapSeparatingAxes( Polygon* facePolygon, Polygon* vertexPolygon );
+	float CollideRound( Polygon* aPolygon, Polygon* bPolygon, Collision* collision );
+	float CollideRoundShapes( Polygon* aPolygon, Polygon* bPolygon, Collision* collision );
+	float CollideRoundAndPolygon( Polygon* round, Polygon* polygon, Collision* collision );
+	Fixed CollideRoundFixed( Polygon* aPolygon, Polygon* bPolygon, Collision* collision );
+	Fixed CollideRoundShapesFixed( Polygon* aPolygon, Polygon* bPolygon, Collision* collision );
+	Fixed CollideRoundAndPolygonFixed( Polygon* round, Polygon* polygon, Collision* collision );
+
+	float CollisionResponse(Polygon* aPolygon, Polygon* bPolygon, Collision collisionParams);
+	float CollisionResponseFixed( Polygon* aPolygon, Polygon* bPolygon, Collision collisionParams );
 
-	void CollisionResponse(Polygon* aPolygon, Polygon* bPolygon, Collision collisionParams);
+	void RaycastPackets( const RaycastInput* rays, RaycastHit* hits, int begin, int end );
+	int QueryOverlaps( glm::vec2 position, float rotation, unsigned int mask, POLYGON_HANDLE* handles, int capacity );
 
 	public:
 
@@ -34,12 +117,57 @@ class World
 
 	void Update( float deltaTimeSeconds );
 
-	POLYGON_HANDLE CreatePolygon( std::vector<glm::vec2>* vertices, glm::vec2 position, float rotation = 0.0f, float mass = 1.0f, bool useGravity = false , bool isStatic = false);
+	POLYGON_HANDLE CreatePolygon( const TransportVector2* vertices, int verticesLength, glm::vec2 position, float rotation = 0.0f, float mass = 1.0f, bool useGravity = false , bool isStatic = false);
+	POLYGON_HANDLE CreateCompound( const TransportVector2* vertices, const int* pieceVertexCounts, int pieceCount, glm::vec2 position, float rotation = 0.0f, float mass = 1.0f, bool useGravity = false, bool isStatic = false );
+	POLYGON_HANDLE CreateCircle( glm::vec2 position, float radius, float rotation = 0.0f, float mass = 1.0f, bool useGravity = false, bool isStatic = false );
+	POLYGON_HANDLE CreateCapsule( glm::vec2 a, glm::vec2 b, float radius, glm::vec2 position, float rotation = 0.0f, float mass = 1.0f, bool useGravity = false, bool isStatic = false );
+	void CreatePolygonBatch( const TransportVector2* vertices, const int* vertexOffsets, int count, const TransportVector2* positions, const float* rotations, const float* masses, const int* flags, POLYGON_HANDLE* handles, int threadCount );
 	void DestroyPolygon( POLYGON_HANDLE handle );
+	void Reserve( int capacity );
+	int GetPolygonCapacity();
 	Polygon* GetPolygon( POLYGON_HANDLE handle );
+	void SynchronizeProxy( Polygon* polygon );
+	void SetVertices( Polygon* polygon, const TransportVector2* vertices, int verticesLength );
+	void SetPieces( Polygon* polygon, const TransportVector2* vertices, const int* pieceVertexCounts, int pieceCount );
+	void SetCollisionFilter( Polygon* polygon, unsigned int category, unsigned int mask );
+	void WakePolygon( Polygon* polygon );
 
 	float GetCurrentTimeSeconds();
+	float GetFixedTimestepSeconds();
+	float GetInterpolationAlpha();
+
+	int GetMaxStepsPerUpdate();
+	void SetMaxStepsPerUpdate( int maxStepsPerUpdate );
+	float GetGravityAcceleration();
+
+	Recorder* GetRecorder();
+	void SetRecorder( Recorder* recorder );
+
+	int GetSnapshotSize();
+	int Snapshot( void* buffer, int bufferLength );
+	void Restore( const void* buffer, int bufferLength );
+
+	bool GetIsDeterministic();
+	void SetIsDeterministic( bool isDeterministic );
+	unsigned long long GetStateHash();
+
+	int GetSubstepCount();
+	void SetSubstepCount( int substepCount );
+
+	bool GetIsAllocationCheckEnabled();
+	void SetIsAllocationCheckEnabled( bool isAllocationCheckEnabled );
+
+	bool GetIsSleepEnabled();
+	void SetIsSleepEnabled( bool isSleepEnabled );
 
 	bool IsPolygonColliding( Polygon* polygon );
+	int GetCollidingBits( unsigned int* bits, int wordCount );
+	int GetContacts( ContactEvent* contacts, int capacity );
+
+	bool Raycast( glm::vec2 origin, glm::vec2 direction, float maxDistance, unsigned int mask, RaycastResult* result );
+	int RaycastBatch( const RaycastInput* rays, int count, RaycastHit* hits, int threadCount = 1 );
+
+	int QueryAABB( AABB aabb, unsigned int mask, POLYGON_HANDLE* handles, int capacity );
+	int QueryPolygon( const TransportVector2* vertices, int verticesLength, glm::vec2 position, float rotation, unsigned int mask, POLYGON_HANDLE* handles, int capacity );
 };
 
@@ -1,162 +1,696 @@
 #include <exception>
+#include <cstring>
 #include "main.h"
 #include "Polygon.h"
 #include "World.h"
+#include "Recorder.h"
+#include "RaycastResult.h"
 
 
-// When WorldStart() is called, we'll create a new World instance and store a pointer to it here
-// and when WorldDestroy() is called we'll delete this and reset it to NULL.
-World* __world = NULL;
+// RECORDING
+
+// If WorldStartRecording() has been called on world, log the call and its arguments so the session 
+// can be replayed later. Costs a single NULL check when nobody is recording.
+template<typename... Arguments>
+void Record( World* world, RecordedCall call, Arguments... arguments )
+{
+	Recorder* recorder = world->GetRecorder();
+	if( recorder == NULL )
+	{
+		return;
+	}
+	recorder->WriteCall( call );
+	int unpack[] = { 0, ( recorder->Write( arguments ), 0 )... };
+	(void)unpack;
+}
 
 
 // EXTERNAL API (Available in Unity)
 
 extern "C"
 {
-	// Create a new World and store it in __world.
-	void WorldStart( float fixedTimestepSeconds, float gravityAcceleration )
+	// Create a new World and hand its WORLD_HANDLE back to the caller. Worlds share no mutable state,
+	// so any number of them can live side by side and be stepped from different threads.
+	WORLD_HANDLE WorldCreate( float fixedTimestepSeconds, float gravityAcceleration )
 	{
-		__world = new World( fixedTimestepSeconds, gravityAcceleration );
+		return new World( fixedTimestepSeconds, gravityAcceleration );
 	}
 
 	// Tell the World to update, given the amount of time that has passed since last update.
-	void WorldUpdate( float deltaTimeSeconds )
+	void WorldUpdate( WORLD_HANDLE world, float deltaTimeSeconds )
 	{
-		__world->Update( deltaTimeSeconds );
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::WorldUpdate, deltaTimeSeconds );
+		nativeWorld->Update( deltaTimeSeconds );
 	}
 
-	// If there is a World, destroy it and reset the pointer to NULL.
-	void WorldDestroy()
+	// Destroy the World at the provided handle. The handle must not be used again afterwards.
+	void WorldDestroy( WORLD_HANDLE world )
 	{
-		if( __world != NULL )
+		delete WorldFromHandle( world );
+	}
+
+	// Start logging every call made on this World into a binary file at path, beginning with a 
+	// snapshot of the World as it is right now. Replace any recording already in progress. Returns
+	// false if the file can't be opened.
+	bool WorldStartRecording( WORLD_HANDLE world, const char* path )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		nativeWorld->SetRecorder( NULL );
+		Recorder* recorder = Recorder::Open( path );
+		if( recorder == NULL )
 		{
-			delete __world;
-			__world = NULL;
+			return false;
 		}
+
+		std::vector<char> snapshot( nativeWorld->GetSnapshotSize() );
+		nativeWorld->Snapshot( snapshot.data(), (int)snapshot.size() );
+
+		RecordingHeader header;
+		memcpy( header.magic, RECORDING_MAGIC, sizeof( RECORDING_MAGIC ) );
+		header.version = RECORDING_VERSION;
+		header.fixedTimestepSeconds = nativeWorld->GetFixedTimestepSeconds();
+		header.gravityAcceleration = nativeWorld->GetGravityAcceleration();
+		header.isDeterministic = nativeWorld->GetIsDeterministic() ? 1 : 0;
+		header.substepCount = nativeWorld->GetSubstepCount();
+		header.maxStepsPerUpdate = nativeWorld->GetMaxStepsPerUpdate();
+		header.isSleepEnabled = nativeWorld->GetIsSleepEnabled() ? 1 : 0;
+		header.snapshotLength = (int)snapshot.size();
+		recorder->Write( &header, sizeof( RecordingHeader ) );
+		recorder->Write( snapshot.data(), (int)snapshot.size() );
+
+		nativeWorld->SetRecorder( recorder );
+		return true;
+	}
+
+	// Stop recording (if a recording is in progress) and flush the log to disk.
+	void WorldStopRecording( WORLD_HANDLE world )
+	{
+		WorldFromHandle( world )->SetRecorder( NULL );
+	}
+
+	// Switch a World's fixed-point deterministic mode on or off.
+	void WorldSetDeterministic( WORLD_HANDLE world, bool isDeterministic )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::WorldSetDeterministic, isDeterministic );
+		nativeWorld->SetIsDeterministic( isDeterministic );
+	}
+
+	// Get the 64-bit state hash of the World's most recent deterministic step.
+	unsigned long long WorldGetStateHash( WORLD_HANDLE world )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::WorldGetStateHash );
+		return nativeWorld->GetStateHash();
+	}
+
+	// Get how many sub-steps the soft contact solver splits each step into (0 when it is off).
+	int WorldGetSubstepCount( WORLD_HANDLE world )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::WorldGetSubstepCount );
+		return nativeWorld->GetSubstepCount();
+	}
+
+	// Solve contacts with the sub-stepped soft contact solver, or pass 0 for the original solver.
+	void WorldSetSubstepCount( WORLD_HANDLE world, int substepCount )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::WorldSetSubstepCount, substepCount );
+		nativeWorld->SetSubstepCount( substepCount );
+	}
+
+	// How far (0 to 1) the World is into its next step. Hosts can draw each Polygon at its previous pose
+	// mixed with its current pose by this much for smooth motion between fixed steps.
+	float WorldGetInterpolationAlpha( WORLD_HANDLE world )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::WorldGetInterpolationAlpha );
+		return nativeWorld->GetInterpolationAlpha();
+	}
+
+	// Get the most steps one WorldUpdate() will take (0 for no limit).
+	int WorldGetMaxStepsPerUpdate( WORLD_HANDLE world )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::WorldGetMaxStepsPerUpdate );
+		return nativeWorld->GetMaxStepsPerUpdate();
+	}
+
+	// Cap the steps one WorldUpdate() may take, dropping whatever time is still owed past the cap, so a
+	// hitch can't set off a spiral of ever longer updates. 0 means no limit.
+	void WorldSetMaxStepsPerUpdate( WORLD_HANDLE world, int maxStepsPerUpdate )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::WorldSetMaxStepsPerUpdate, maxStepsPerUpdate );
+		nativeWorld->SetMaxStepsPerUpdate( maxStepsPerUpdate );
+	}
+
+	// Is every step checking that it makes no heap allocations?
+	bool WorldGetAllocationCheck( WORLD_HANDLE world )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::WorldGetAllocationCheck );
+		return nativeWorld->GetIsAllocationCheckEnabled();
+	}
+
+	// Make every step throw if it allocates on the heap. Meant for catching allocations creeping into
+	// steady-state stepping, so enable it after the scene has run for a few steps. Only available in builds
+	// with PHYSICS_ALLOCATION_CHECK defined (the Debug ones); enabling it elsewhere throws.
+	void WorldSetAllocationCheck( WORLD_HANDLE world, bool isEnabled )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::WorldSetAllocationCheck, isEnabled );
+		nativeWorld->SetIsAllocationCheckEnabled( isEnabled );
+	}
+
+	// Can Polygons that have come to rest fall asleep?
+	bool WorldGetSleepEnabled( WORLD_HANDLE world )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::WorldGetSleepEnabled );
+		return nativeWorld->GetIsSleepEnabled();
+	}
+
+	// Let piles of Polygons that have come to rest fall asleep, so a settled level costs next to 
+	// nothing to step. Anything touching them or any PolygonSet*() call wakes them up again. Off by 
+	// default.
+	void WorldSetSleepEnabled( WORLD_HANDLE world, bool isEnabled )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::WorldSetSleepEnabled, isEnabled );
+		nativeWorld->SetIsSleepEnabled( isEnabled );
+	}
+
+	// Pre-allocate room for capacity Polygons and their contacts. Creating and destroying Polygons after
+	// that (as long as no more than capacity are alive at once) reuses pooled memory instead of 
+	// allocating.
+	void WorldReserve( WORLD_HANDLE world, int capacity )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::WorldReserve, capacity );
+		nativeWorld->Reserve( capacity );
+	}
+
+	// Get the number of bytes needed to snapshot the World as it is right now.
+	int WorldGetSnapshotSize( WORLD_HANDLE world )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::WorldGetSnapshotSize );
+		return nativeWorld->GetSnapshotSize();
+	}
+
+	// Save the whole World into buffer. Returns the number of bytes written, or 0 if buffer is too small.
+	int WorldSnapshot( WORLD_HANDLE world, void* buffer, int bufferLength )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::WorldSnapshot, bufferLength );
+		return nativeWorld->Snapshot( buffer, bufferLength );
+	}
+
+	// Rewind the World to a snapshot previously written by WorldSnapshot().
+	void WorldRestore( WORLD_HANDLE world, const void* buffer, int bufferLength )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Recorder* recorder = nativeWorld->GetRecorder();
+		if( recorder != NULL )
+		{
+			recorder->WriteCall( RecordedCall::WorldRestore );
+			recorder->WriteArray( (const char*)buffer, bufferLength );
+		}
+		nativeWorld->Restore( buffer, bufferLength );
 	}
 
 	// Tell the World to create a new Polygon and return its HANDLE to the caller.
 	// Note: Check out the VerticesTransformToGLM() and Vector2TransformToGLM() functions below.
-	POLYGON_HANDLE PolygonCreate( TransportVector2 vertices[], int verticesLength, TransportVector2 position, float rotation, float mass, bool useGravity, bool isStatic )
+	POLYGON_HANDLE PolygonCreate( WORLD_HANDLE world, TransportVector2 vertices[], int verticesLength, TransportVector2 position, float rotation, float mass, bool useGravity, bool isStatic )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Recorder* recorder = nativeWorld->GetRecorder();
+		if( recorder != NULL )
+		{
+			recorder->WriteCall( RecordedCall::PolygonCreate );
+			recorder->WriteArray( vertices, verticesLength );
+			recorder->Write( position );
+			recorder->Write( rotation );
+			recorder->Write( mass );
+			recorder->Write( useGravity );
+			recorder->Write( isStatic );
+		}
+		return nativeWorld->CreatePolygon( vertices, verticesLength, Vector2TransportToGLM( position ), rotation, mass, useGravity, isStatic );
+	}
+
+	// Tell the World to create a Polygon made of several convex pieces (vertices holds every piece's 
+	// vertices back to back, pieceVertexCounts how many belong to each) and return its HANDLE.
+	POLYGON_HANDLE PolygonCreateCompound( WORLD_HANDLE world, TransportVector2 vertices[], int pieceVertexCounts[], int pieceCount, TransportVector2 position, float rotation, float mass, bool useGravity, bool isStatic )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Recorder* recorder = nativeWorld->GetRecorder();
+		if( recorder != NULL )
+		{
+			int verticesLength = 0;
+			for( int i = 0; i < pieceCount; i++ )
+			{
+				verticesLength += pieceVertexCounts[ i ];
+			}
+			recorder->WriteCall( RecordedCall::PolygonCreateCompound );
+			recorder->WriteArray( pieceVertexCounts, pieceCount );
+			recorder->WriteArray( vertices, verticesLength );
+			recorder->Write( position );
+			recorder->Write( rotation );
+			recorder->Write( mass );
+			recorder->Write( useGravity );
+			recorder->Write( isStatic );
+		}
+		return nativeWorld->CreateCompound( vertices, pieceVertexCounts, pieceCount, Vector2TransportToGLM( position ), rotation, mass, useGravity, isStatic );
+	}
+
+	// Tell the World to create a circle of the given radius (much cheaper to collide than a Polygon 
+	// with enough vertices to look round) and return its HANDLE.
+	POLYGON_HANDLE PolygonCreateCircle( WORLD_HANDLE world, TransportVector2 position, float radius, float rotation, float mass, bool useGravity, bool isStatic )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonCreateCircle, position, radius, rotation, mass, useGravity, isStatic );
+		return nativeWorld->CreateCircle( Vector2TransportToGLM( position ), radius, rotation, mass, useGravity, isStatic );
+	}
+
+	// Tell the World to create a capsule (every point within radius of the segment from a to b, in 
+	// local space) and return its HANDLE.
+	POLYGON_HANDLE PolygonCreateCapsule( WORLD_HANDLE world, TransportVector2 a, TransportVector2 b, float radius, TransportVector2 position, float rotation, float mass, bool useGravity, bool isStatic )
 	{
-		return __world->CreatePolygon( VerticesTransportToGLM( vertices, verticesLength ), Vector2TransportToGLM( position ), rotation, mass, useGravity, isStatic );
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonCreateCapsule, a, b, radius, position, rotation, mass, useGravity, isStatic );
+		return nativeWorld->CreateCapsule( Vector2TransportToGLM( a ), Vector2TransportToGLM( b ), radius, Vector2TransportToGLM( position ), rotation, mass, useGravity, isStatic );
+	}
+
+	// Tell the World to create count Polygons at once and write their HANDLEs to handles, for loading
+	// a level. Polygon i has the vertices from vertexOffsets[ i ] up to vertexOffsets[ i + 1 ] in 
+	// vertices, positions[ i ], rotations[ i ], masses[ i ] and the PolygonFlags in flags[ i ]. Their
+	// shapes are built on up to threadCount threads. If any of them has bad vertices, none are created.
+	void PolygonCreateBatch( WORLD_HANDLE world, const TransportVector2 vertices[], const int vertexOffsets[], int count, const TransportVector2 positions[], const float rotations[], const float masses[], const int flags[], POLYGON_HANDLE handles[], int threadCount )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Recorder* recorder = nativeWorld->GetRecorder();
+		if( recorder != NULL && count > 0 )
+		{
+			recorder->WriteCall( RecordedCall::PolygonCreateBatch );
+			recorder->WriteArray( vertexOffsets, count + 1 );
+			recorder->WriteArray( vertices, vertexOffsets[ count ] );
+			recorder->WriteArray( positions, count );
+			recorder->WriteArray( rotations, count );
+			recorder->WriteArray( masses, count );
+			recorder->WriteArray( flags, count );
+			recorder->Write( threadCount );
+		}
+		nativeWorld->CreatePolygonBatch( vertices, vertexOffsets, count, positions, rotations, masses, flags, handles, threadCount );
 	}
 
 	// Tell the World to destroy the Polygon at the provided handle.
-	void PolygonDestroy( POLYGON_HANDLE handle )
+	void PolygonDestroy( WORLD_HANDLE world, POLYGON_HANDLE handle )
 	{
-		__world->DestroyPolygon( handle );
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonDestroy, handle );
+		nativeWorld->DestroyPolygon( handle );
 	}
 
-	// Get the Polygon at the provided handle and set its vertices as glm::vec2s.
-	// Note: Check out the VerticesTransformToGLM() function below.
-	void PolygonSetVertices( POLYGON_HANDLE handle, TransportVector2 vertices[], int verticesLength )
+	// Get the Polygon at the provided handle and copy the vertices into it (splitting concave outlines
+	// into convex pieces, see World::SetVertices()).
+	void PolygonSetVertices( WORLD_HANDLE world, POLYGON_HANDLE handle, TransportVector2 vertices[], int verticesLength )
 	{
-		__world->GetPolygon( handle )->SetVertices( VerticesTransportToGLM( vertices, verticesLength ) );
+		World* nativeWorld = WorldFromHandle( world );
+		Recorder* recorder = nativeWorld->GetRecorder();
+		if( recorder != NULL )
+		{
+			recorder->WriteCall( RecordedCall::PolygonSetVertices );
+			recorder->Write( handle );
+			recorder->WriteArray( vertices, verticesLength );
+		}
+		Polygon* polygon = nativeWorld->GetPolygon( handle );
+		nativeWorld->SetVertices( polygon, vertices, verticesLength );
+		nativeWorld->SynchronizeProxy( polygon );
+		nativeWorld->WakePolygon( polygon );
 	}
 
 	// Get a Polygon's mass.
-	float PolygonGetMass( POLYGON_HANDLE handle )
+	float PolygonGetMass( WORLD_HANDLE world, POLYGON_HANDLE handle )
 	{
-		return __world->GetPolygon( handle )->GetMass();
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonGetMass, handle );
+		return nativeWorld->GetPolygon( handle )->GetMass();
 	}
 
 	// Set a Polygon's mass.
-	void PolygonSetMass( POLYGON_HANDLE handle, float mass )
+	void PolygonSetMass( WORLD_HANDLE world, POLYGON_HANDLE handle, float mass )
 	{
-		__world->GetPolygon( handle )->SetMass( mass );
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonSetMass, handle, mass );
+		Polygon* polygon = nativeWorld->GetPolygon( handle );
+		polygon->SetMass( mass );
+		nativeWorld->WakePolygon( polygon );
 	}
 
 	// Get the rotational inertia of a Polygon.
-	float PolygonGetRotationalInertia( POLYGON_HANDLE handle )
+	float PolygonGetRotationalInertia( WORLD_HANDLE world, POLYGON_HANDLE handle )
 	{
-		return __world->GetPolygon( handle )->GetRotationalInertia();
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonGetRotationalInertia, handle );
+		return nativeWorld->GetPolygon( handle )->GetRotationalInertia();
 	}
 
 	// Get the Polygon at the provided handle from the World and return its position as a TransportVector2.
 	// Note: Check out the Vector2GLMToTransform() function below.
-	TransportVector2 PolygonGetPosition( POLYGON_HANDLE handle )
+	TransportVector2 PolygonGetPosition( WORLD_HANDLE world, POLYGON_HANDLE handle )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonGetPosition, handle );
+		return Vector2GLMToTransport( nativeWorld->GetPolygon( handle )->GetPosition() );
+	}
+
+	// Get where the Polygon at the provided handle was at the start of the last step.
+	TransportVector2 PolygonGetPreviousPosition( WORLD_HANDLE world, POLYGON_HANDLE handle )
 	{
-		return Vector2GLMToTransport( __world->GetPolygon( handle )->GetPosition() );
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonGetPreviousPosition, handle );
+		return Vector2GLMToTransport( nativeWorld->GetPolygon( handle )->GetPreviousPosition() );
 	}
 
 	// Get the Polygon at the provided handle and set its position as a glm::vec2.
 	// Note: Check out the Vector2TransformToGLM() function below.
-	void PolygonSetPosition( POLYGON_HANDLE handle, TransportVector2 position )
+	void PolygonSetPosition( WORLD_HANDLE world, POLYGON_HANDLE handle, TransportVector2 position )
 	{
-		__world->GetPolygon( handle )->SetPosition( Vector2TransportToGLM( position ) );
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonSetPosition, handle, position );
+		Polygon* polygon = nativeWorld->GetPolygon( handle );
+		polygon->SetPosition( Vector2TransportToGLM( position ) );
+		nativeWorld->SynchronizeProxy( polygon );
+		nativeWorld->WakePolygon( polygon );
 	}
 
 	// Move a Polygon relative to its current position.
-	void PolygonTranslate( POLYGON_HANDLE handle, TransportVector2 dPosition )
+	void PolygonTranslate( WORLD_HANDLE world, POLYGON_HANDLE handle, TransportVector2 dPosition )
 	{
-		__world->GetPolygon( handle )->Translate( Vector2TransportToGLM( dPosition ) );
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonTranslate, handle, dPosition );
+		Polygon* polygon = nativeWorld->GetPolygon( handle );
+		polygon->Translate( Vector2TransportToGLM( dPosition ) );
+		nativeWorld->SynchronizeProxy( polygon );
+		nativeWorld->WakePolygon( polygon );
 	}
 
 	// Get the linear velocity of a Polygon.
-	TransportVector2 PolygonGetVelocity( POLYGON_HANDLE handle )
+	TransportVector2 PolygonGetVelocity( WORLD_HANDLE world, POLYGON_HANDLE handle )
 	{
-		return Vector2GLMToTransport( __world->GetPolygon( handle )->GetVelocity() );
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonGetVelocity, handle );
+		return Vector2GLMToTransport( nativeWorld->GetPolygon( handle )->GetVelocity() );
 	}
 
 	// Set the linear velocity of a Polygon.
-	void PolygonSetVelocity( POLYGON_HANDLE handle, TransportVector2 velocity )
+	void PolygonSetVelocity( WORLD_HANDLE world, POLYGON_HANDLE handle, TransportVector2 velocity )
 	{
-		__world->GetPolygon( handle )->SetVelocity( Vector2TransportToGLM( velocity ) );
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonSetVelocity, handle, velocity );
+		Polygon* polygon = nativeWorld->GetPolygon( handle );
+		polygon->SetVelocity( Vector2TransportToGLM( velocity ) );
+		nativeWorld->WakePolygon( polygon );
 	}
 
 	// Linearly accelerate a Polygon relative to its current velocity.
-	void PolygonAccelerate( POLYGON_HANDLE handle, TransportVector2 dVelocity )
+	void PolygonAccelerate( WORLD_HANDLE world, POLYGON_HANDLE handle, TransportVector2 dVelocity )
 	{
-		__world->GetPolygon( handle )->Accelerate( Vector2TransportToGLM( dVelocity ) );
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonAccelerate, handle, dVelocity );
+		Polygon* polygon = nativeWorld->GetPolygon( handle );
+		polygon->Accelerate( Vector2TransportToGLM( dVelocity ) );
+		nativeWorld->WakePolygon( polygon );
 	}
 
 	// Get the Polygon at the provided handle from the World and return its rotation.
-	float PolygonGetRotation( POLYGON_HANDLE handle )
+	float PolygonGetRotation( WORLD_HANDLE world, POLYGON_HANDLE handle )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonGetRotation, handle );
+		return nativeWorld->GetPolygon( handle )->GetRotation();
+	}
+
+	// Get the rotation of the Polygon at the provided handle at the start of the last step.
+	float PolygonGetPreviousRotation( WORLD_HANDLE world, POLYGON_HANDLE handle )
 	{
-		return __world->GetPolygon( handle )->GetRotation();
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonGetPreviousRotation, handle );
+		return nativeWorld->GetPolygon( handle )->GetPreviousRotation();
 	}
 
 	// Get the Polygon at the provided handle and set its rotation.
-	void PolygonSetRotation( POLYGON_HANDLE handle, float rotation )
+	void PolygonSetRotation( WORLD_HANDLE world, POLYGON_HANDLE handle, float rotation )
 	{
-		__world->GetPolygon( handle )->SetRotation( rotation );
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonSetRotation, handle, rotation );
+		Polygon* polygon = nativeWorld->GetPolygon( handle );
+		polygon->SetRotation( rotation );
+		nativeWorld->SynchronizeProxy( polygon );
+		nativeWorld->WakePolygon( polygon );
 	}
 
 	// Rotate a Polygon relative to its current rotation.
-	void PolygonRotate( POLYGON_HANDLE handle, float dRotation )
+	void PolygonRotate( WORLD_HANDLE world, POLYGON_HANDLE handle, float dRotation )
 	{
-		__world->GetPolygon( handle )->Rotate( dRotation );
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonRotate, handle, dRotation );
+		Polygon* polygon = nativeWorld->GetPolygon( handle );
+		polygon->Rotate( dRotation );
+		nativeWorld->SynchronizeProxy( polygon );
+		nativeWorld->WakePolygon( polygon );
 	}
 
 	// Get the rotational velocity of a Polygon.
-	float PolygonGetRotationalVelocity( POLYGON_HANDLE handle )
+	float PolygonGetRotationalVelocity( WORLD_HANDLE world, POLYGON_HANDLE handle )
 	{
-		return __world->GetPolygon( handle )->GetRotationalVelocity();
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonGetRotationalVelocity, handle );
+		return nativeWorld->GetPolygon( handle )->GetRotationalVelocity();
 	}
 
 	// Set the linear velocity of a Polygon.
-	void PolygonSetRotationalVelocity( POLYGON_HANDLE handle, float rotationalVelocity )
+	void PolygonSetRotationalVelocity( WORLD_HANDLE world, POLYGON_HANDLE handle, float rotationalVelocity )
 	{
-		__world->GetPolygon( handle )->SetRotationalVelocity( rotationalVelocity );
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonSetRotationalVelocity, handle, rotationalVelocity );
+		Polygon* polygon = nativeWorld->GetPolygon( handle );
+		polygon->SetRotationalVelocity( rotationalVelocity );
+		nativeWorld->WakePolygon( polygon );
 	}
 
 	// Rotationally accelerate a Polygon relative to its current rotational velocity.
-	void PolygonAccelerateRotation( POLYGON_HANDLE handle, float dRotationalVelocity )
+	void PolygonAccelerateRotation( WORLD_HANDLE world, POLYGON_HANDLE handle, float dRotationalVelocity )
 	{
-		__world->GetPolygon( handle )->AccelerateRotation( dRotationalVelocity );
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonAccelerateRotation, handle, dRotationalVelocity );
+		Polygon* polygon = nativeWorld->GetPolygon( handle );
+		polygon->AccelerateRotation( dRotationalVelocity );
+		nativeWorld->WakePolygon( polygon );
 	}
 
 	// Returns whether or not a Polygon is currently involved in a collision with one or more other Polygons.
-	bool IsPolygonColliding( POLYGON_HANDLE handle )
+	bool IsPolygonColliding( WORLD_HANDLE world, POLYGON_HANDLE handle )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::IsPolygonColliding, handle );
+		return nativeWorld->IsPolygonColliding( nativeWorld->GetPolygon( handle ) );
+	}
+
+	// Copy up to capacity contact events from the last WorldUpdate() into contacts, so a host can 
+	// handle every collision, sensor overlap and separation in one call instead of asking each Polygon
+	// whether it is colliding. Returns how many events there are in total, which can be more than 
+	// capacity.
+	int WorldGetContacts( WORLD_HANDLE world, ContactEvent contacts[], int capacity )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::WorldGetContacts, capacity );
+		return nativeWorld->GetContacts( contacts, capacity );
+	}
+
+	// IsPolygonColliding() for every Polygon in one call, as a bitset indexed by handle: bit 
+	// ( handle % 32 ) of bits[ handle / 32 ]. Writes at most wordCount words and returns how many it
+	// takes to cover every handle.
+	int WorldGetCollidingPolygons( WORLD_HANDLE world, unsigned int bits[], int wordCount )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::WorldGetCollidingPolygons, wordCount );
+		return nativeWorld->GetCollidingBits( bits, wordCount );
+	}
+
+	// Get the collision layers a Polygon belongs to (one bit per layer).
+	unsigned int PolygonGetCollisionCategory( WORLD_HANDLE world, POLYGON_HANDLE handle )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonGetCollisionCategory, handle );
+		return nativeWorld->GetPolygon( handle )->GetCollisionCategory();
+	}
+
+	// Get the collision layers a Polygon collides with (one bit per layer).
+	unsigned int PolygonGetCollisionMask( WORLD_HANDLE world, POLYGON_HANDLE handle )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonGetCollisionMask, handle );
+		return nativeWorld->GetPolygon( handle )->GetCollisionMask();
+	}
+
+	// Put a Polygon into the collision layers in category and let it collide only with Polygons in 
+	// the layers in mask. Pairs that don't pass each other's filter are dropped by the broadphase 
+	// before any collision test runs.
+	void PolygonSetCollisionFilter( WORLD_HANDLE world, POLYGON_HANDLE handle, unsigned int category, unsigned int mask )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonSetCollisionFilter, handle, category, mask );
+		Polygon* polygon = nativeWorld->GetPolygon( handle );
+		nativeWorld->SetCollisionFilter( polygon, category, mask );
+		nativeWorld->WakePolygon( polygon );
+	}
+
+	// Is a Polygon swept each step so it can't tunnel through others?
+	bool PolygonGetIsBullet( WORLD_HANDLE world, POLYGON_HANDLE handle )
 	{
-		return __world->IsPolygonColliding( __world->GetPolygon( handle ) );
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonGetIsBullet, handle );
+		return nativeWorld->GetPolygon( handle )->GetIsBullet();
+	}
+
+	// Mark a fast-moving Polygon as a bullet so it gets continuous collision detection against 
+	// everything that isn't a bullet, instead of running the whole World at a tiny timestep.
+	void PolygonSetIsBullet( WORLD_HANDLE world, POLYGON_HANDLE handle, bool isBullet )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonSetIsBullet, handle, isBullet );
+		Polygon* polygon = nativeWorld->GetPolygon( handle );
+		polygon->SetIsBullet( isBullet );
+		nativeWorld->WakePolygon( polygon );
+	}
+
+	// Is a Polygon kinematic (moved only by its velocity, never by collisions)?
+	bool PolygonGetIsKinematic( WORLD_HANDLE world, POLYGON_HANDLE handle )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonGetIsKinematic, handle );
+		return nativeWorld->GetPolygon( handle )->GetIsKinematic();
+	}
+
+	// Make a Polygon kinematic for moving platforms and doors: drive it with PolygonSetVelocity() 
+	// rather than teleporting it with PolygonSetPosition() each frame, and it will push dynamic 
+	// Polygons out of its way without ever being pushed back.
+	void PolygonSetIsKinematic( WORLD_HANDLE world, POLYGON_HANDLE handle, bool isKinematic )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonSetIsKinematic, handle, isKinematic );
+		Polygon* polygon = nativeWorld->GetPolygon( handle );
+		polygon->SetIsKinematic( isKinematic );
+		nativeWorld->WakePolygon( polygon );
+	}
+
+	// Is a Polygon a sensor (reports overlaps but never collides)?
+	bool PolygonGetIsSensor( WORLD_HANDLE world, POLYGON_HANDLE handle )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonGetIsSensor, handle );
+		return nativeWorld->GetPolygon( handle )->GetIsSensor();
+	}
+
+	// Turn a Polygon into a sensor for area triggers. IsPolygonColliding() still reports its overlaps 
+	// with non-static, non-sensor Polygons, but nothing pushes it or gets pushed by it.
+	void PolygonSetIsSensor( WORLD_HANDLE world, POLYGON_HANDLE handle, bool isSensor )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonSetIsSensor, handle, isSensor );
+		Polygon* polygon = nativeWorld->GetPolygon( handle );
+		polygon->SetIsSensor( isSensor );
+		nativeWorld->WakePolygon( polygon );
+	}
+
+	// Is a Polygon awake, rather than asleep in a pile that has come to rest?
+	bool PolygonGetIsAwake( WORLD_HANDLE world, POLYGON_HANDLE handle )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::PolygonGetIsAwake, handle );
+		return nativeWorld->GetPolygon( handle )->GetIsAwake();
+	}
+
+	// Cast a ray from origin along direction and fill in hit with the closest Polygon it hits within 
+	// maxDistance, only considering Polygons whose collision category is in mask. Returns false (with
+	// hit->handle set to 0) if the ray didn't hit anything.
+	bool WorldRaycast( WORLD_HANDLE world, TransportVector2 origin, TransportVector2 direction, float maxDistance, unsigned int mask, RaycastHit* hit )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::WorldRaycast, origin, direction, maxDistance, mask );
+
+		RaycastResult result;
+		bool isHit = nativeWorld->Raycast( Vector2TransportToGLM( origin ), Vector2TransportToGLM( direction ), maxDistance, mask, &result );
+		hit->handle = isHit ? result.polygon->GetHandle() : 0;
+		hit->point = Vector2GLMToTransport( result.point );
+		hit->normal = Vector2GLMToTransport( result.normal );
+		hit->fraction = result.fraction;
+		return isHit;
+	}
+
+	// WorldRaycast() for count rays in one call, writing the hit for rays[ i ] into hits[ i ] and 
+	// returning how many rays hit something. Put rays that start close together and head the same way
+	// next to each other, since they are traced through the World in packets. threadCount above 1 
+	// splits the batch across up to that many threads.
+	int WorldRaycastBatch( WORLD_HANDLE world, const RaycastInput rays[], int count, RaycastHit hits[], int threadCount )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Recorder* recorder = nativeWorld->GetRecorder();
+		if( recorder != NULL && count >= 0 )
+		{
+			recorder->WriteCall( RecordedCall::WorldRaycastBatch );
+			recorder->WriteArray( rays, count );
+			recorder->Write( threadCount );
+		}
+		return nativeWorld->RaycastBatch( rays, count, hits, threadCount );
+	}
+
+	// Write the handles of up to capacity Polygons in one of the collision layers in mask that overlap
+	// the box from lower to upper into handles, in handle order. Returns how many Polygons overlap in
+	// total, which can be more than capacity.
+	int WorldQueryAABB( WORLD_HANDLE world, TransportVector2 lower, TransportVector2 upper, unsigned int mask, POLYGON_HANDLE handles[], int capacity )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Record( nativeWorld, RecordedCall::WorldQueryAABB, lower, upper, mask, capacity );
+		return nativeWorld->QueryAABB( AABB( Vector2TransportToGLM( lower ), Vector2TransportToGLM( upper ) ), mask, handles, capacity );
+	}
+
+	// WorldQueryAABB() for a convex polygon with the given local vertices placed at position and 
+	// rotation, the same way a Polygon created from them would be.
+	int WorldQueryPolygon( WORLD_HANDLE world, const TransportVector2 vertices[], int verticesLength, TransportVector2 position, float rotation, unsigned int mask, POLYGON_HANDLE handles[], int capacity )
+	{
+		World* nativeWorld = WorldFromHandle( world );
+		Recorder* recorder = nativeWorld->GetRecorder();
+		if( recorder != NULL )
+		{
+			recorder->WriteCall( RecordedCall::WorldQueryPolygon );
+			recorder->WriteArray( vertices, verticesLength );
+			recorder->Write( position );
+			recorder->Write( rotation );
+			recorder->Write( mask );
+			recorder->Write( capacity );
+		}
+		return nativeWorld->QueryPolygon( vertices, verticesLength, Vector2TransportToGLM( position ), rotation, mask, handles, capacity );
 	}
 }
 
 
 // TYPE CONVERSIONS
 
+// Converts a WORLD_HANDLE received across the extern "C" interface back into the World it refers to.
+World* WorldFromHandle( WORLD_HANDLE world )
+{
+	if( world == NULL )
+	{
+		throw std::exception( "No world exists at this handle!" );
+	}
+	return static_cast<World*>( world );
+}
+
 // Converts a single glm::vec2 into a TransportVector2 to be sent across the extern "C" interface.
 TransportVector2 Vector2GLMToTransport( glm::vec2 glmVector )
 {
@@ -2,7 +2,14 @@
 #include <vector>
 #include <glm.hpp>
 #include "POLYGON_HANDLE.c"
+#include "WORLD_HANDLE.c"
 #include "TransportVector2.c"
+#include "RaycastHit.c"
+#include "RaycastInput.c"
+#include "ContactEvent.c"
+#include "PolygonFlags.c"
+
+class World;
 
 
 // EXTERNAL API (Available in Unity)
@@ -15,37 +22,91 @@
 
 extern "C"
 {
-	LAB3_API void WorldStart( float fixedTimestepSeconds, float gravityAcceleration = 0.0f );
-	LAB3_API void WorldUpdate( float deltaTimeSeconds );
-	LAB3_API void WorldDestroy();
+	LAB3_API WORLD_HANDLE WorldCreate( float fixedTimestepSeconds, float gravityAcceleration = 0.0f );
+	LAB3_API void WorldUpdate( WORLD_HANDLE world, float deltaTimeSeconds );
+	LAB3_API void WorldDestroy( WORLD_HANDLE world );
+
+	LAB3_API bool WorldStartRecording( WORLD_HANDLE world, const char* path );
+	LAB3_API void WorldStopRecording( WORLD_HANDLE world );
+
+	LAB3_API void WorldSetDeterministic( WORLD_HANDLE world, bool isDeterministic );
+	LAB3_API unsigned long long WorldGetStateHash( WORLD_HANDLE world );
+
+	LAB3_API int WorldGetSubstepCount( WORLD_HANDLE world );
+	LAB3_API void WorldSetSubstepCount( WORLD_HANDLE world, int substepCount );
+
+	LAB3_API float WorldGetInterpolationAlpha( WORLD_HANDLE world );
+	LAB3_API int WorldGetMaxStepsPerUpdate( WORLD_HANDLE world );
+	LAB3_API void WorldSetMaxStepsPerUpdate( WORLD_HANDLE world, int maxStepsPerUpdate );
+
+	LAB3_API bool WorldGetAllocationCheck( WORLD_HANDLE world );
+	LAB3_API void WorldSetAllocationCheck( WORLD_HANDLE world, bool isEnabled );
+
+	LAB3_API bool WorldGetSleepEnabled( WORLD_HANDLE world );
+	LAB3_API void WorldSetSleepEnabled( WORLD_HANDLE world, bool isEnabled );
+
+	LAB3_API void WorldReserve( WORLD_HANDLE world, int capacity );
+
+	LAB3_API int WorldGetSnapshotSize( WORLD_HANDLE world );
+	LAB3_API int WorldSnapshot( WORLD_HANDLE world, void* buffer, int bufferLength );
+	LAB3_API void WorldRestore( WORLD_HANDLE world, const void* buffer, int bufferLength );
 
-	LAB3_API int PolygonCreate( TransportVector2 vertices[], int verticesLength, TransportVector2 position, float rotation = 0.0f, float mass = 1.0f, bool useGravity = false, bool isStatic = false );
-	LAB3_API void PolygonDestroy( POLYGON_HANDLE handle );
+	LAB3_API int PolygonCreate( WORLD_HANDLE world, TransportVector2 vertices[], int verticesLength, TransportVector2 position, float rotation = 0.0f, float mass = 1.0f, bool useGravity = false, bool isStatic = false );
+	LAB3_API int PolygonCreateCompound( WORLD_HANDLE world, TransportVector2 vertices[], int pieceVertexCounts[], int pieceCount, TransportVector2 position, float rotation = 0.0f, float mass = 1.0f, bool useGravity = false, bool isStatic = false );
+	LAB3_API int PolygonCreateCircle( WORLD_HANDLE world, TransportVector2 position, float radius, float rotation = 0.0f, float mass = 1.0f, bool useGravity = false, bool isStatic = false );
+	LAB3_API int PolygonCreateCapsule( WORLD_HANDLE world, TransportVector2 a, TransportVector2 b, float radius, TransportVector2 position, float rotation = 0.0f, float mass = 1.0f, bool useGravity = false, bool isStatic = false );
+	LAB3_API void PolygonCreateBatch( WORLD_HANDLE world, const TransportVector2 vertices[], const int vertexOffsets[], int count, const TransportVector2 positions[], const float rotations[], const float masses[], const int flags[], POLYGON_HANDLE handles[], int threadCount = 1 );
+	LAB3_API void PolygonDestroy( WORLD_HANDLE world, POLYGON_HANDLE handle );
 
-	LAB3_API void PolygonSetVertices( POLYGON_HANDLE handle, TransportVector2 vertices[], int verticesLength );
+	LAB3_API void PolygonSetVertices( WORLD_HANDLE world, POLYGON_HANDLE handle, TransportVector2 vertices[], int verticesLength );
 
-	LAB3_API float PolygonGetMass( POLYGON_HANDLE handle );
-	LAB3_API void PolygonSetMass( POLYGON_HANDLE handle, float mass );
+	LAB3_API float PolygonGetMass( WORLD_HANDLE world, POLYGON_HANDLE handle );
+	LAB3_API void PolygonSetMass( WORLD_HANDLE world, POLYGON_HANDLE handle, float mass );
 
-	LAB3_API float PolygonGetRotationalInertia( POLYGON_HANDLE handle );
+	LAB3_API float PolygonGetRotationalInertia( WORLD_HANDLE world, POLYGON_HANDLE handle );
 
-	LAB3_API TransportVector2 PolygonGetPosition( POLYGON_HANDLE handle );
-	LAB3_API void PolygonSetPosition( POLYGON_HANDLE handle, TransportVector2 position );
-	LAB3_API void PolygonTranslate( POLYGON_HANDLE handle, TransportVector2 dPosition );
+	LAB3_API TransportVector2 PolygonGetPosition( WORLD_HANDLE world, POLYGON_HANDLE handle );
+	LAB3_API TransportVector2 PolygonGetPreviousPosition( WORLD_HANDLE world, POLYGON_HANDLE handle );
+	LAB3_API void PolygonSetPosition( WORLD_HANDLE world, POLYGON_HANDLE handle, TransportVector2 position );
+	LAB3_API void PolygonTranslate( WORLD_HANDLE world, POLYGON_HANDLE handle, TransportVector2 dPosition );
 
-	LAB3_API TransportVector2 PolygonGetVelocity( POLYGON_HANDLE handle );
-	LAB3_API void PolygonSetVelocity( POLYGON_HANDLE handle, TransportVector2 velocity );
-	LAB3_API void PolygonAccelerate( POLYGON_HANDLE handle, TransportVector2 dVelocity );
+	LAB3_API TransportVector2 PolygonGetVelocity( WORLD_HANDLE world, POLYGON_HANDLE handle );
+	LAB3_API void PolygonSetVelocity( WORLD_HANDLE world, POLYGON_HANDLE handle, TransportVector2 velocity );
+	LAB3_API void PolygonAccelerate( WORLD_HANDLE world, POLYGON_HANDLE handle, TransportVector2 dVelocity );
 
-	LAB3_API float PolygonGetRotation( POLYGON_HANDLE handle );
-	LAB3_API void PolygonSetRotation( POLYGON_HANDLE handle, float rotation );
-	LAB3_API void PolygonRotate( POLYGON_HANDLE handle, float dRotation );
+	LAB3_API float PolygonGetRotation( WORLD_HANDLE world, POLYGON_HANDLE handle );
+	LAB3_API float PolygonGetPreviousRotation( WORLD_HANDLE world, POLYGON_HANDLE handle );
+	LAB3_API void PolygonSetRotation( WORLD_HANDLE world, POLYGON_HANDLE handle, float rotation );
+	LAB3_API void PolygonRotate( WORLD_HANDLE world, POLYGON_HANDLE handle, float dRotation );
 
-	LAB3_API float PolygonGetRotationalVelocity( POLYGON_HANDLE handle );
-	LAB3_API void PolygonSetRotationalVelocity( POLYGON_HANDLE handle, float rotationalVelocity );
-	LAB3_API void PolygonAccelerateRotation( POLYGON_HANDLE handle, float dRotationalVelocity );
+	LAB3_API float PolygonGetRotationalVelocity( WORLD_HANDLE world, POLYGON_HANDLE handle );
+	LAB3_API void PolygonSetRotationalVelocity( WORLD_HANDLE world, POLYGON_HANDLE handle, float rotationalVelocity );
+	LAB3_API void PolygonAccelerateRotation( WORLD_HANDLE world, POLYGON_HANDLE handle, float dRotationalVelocity );
 
-	LAB3_API bool IsPolygonColliding( POLYGON_HANDLE handle );
+	LAB3_API bool IsPolygonColliding( WORLD_HANDLE world, POLYGON_HANDLE handle );
+	LAB3_API int WorldGetContacts( WORLD_HANDLE world, ContactEvent contacts[], int capacity );
+	LAB3_API int WorldGetCollidingPolygons( WORLD_HANDLE world, unsigned int bits[], int wordCount );
+
+	LAB3_API unsigned int PolygonGetCollisionCategory( WORLD_HANDLE world, POLYGON_HANDLE handle );
+	LAB3_API unsigned int PolygonGetCollisionMask( WORLD_HANDLE world, POLYGON_HANDLE handle );
+	LAB3_API void PolygonSetCollisionFilter( WORLD_HANDLE world, POLYGON_HANDLE handle, unsigned int category, unsigned int mask );
+
+	LAB3_API bool PolygonGetIsBullet( WORLD_HANDLE world, POLYGON_HANDLE handle );
+	LAB3_API void PolygonSetIsBullet( WORLD_HANDLE world, POLYGON_HANDLE handle, bool isBullet );
+
+	LAB3_API bool PolygonGetIsKinematic( WORLD_HANDLE world, POLYGON_HANDLE handle );
+	LAB3_API void PolygonSetIsKinematic( WORLD_HANDLE world, POLYGON_HANDLE handle, bool isKinematic );
+
+	LAB3_API bool PolygonGetIsSensor( WORLD_HANDLE world, POLYGON_HANDLE handle );
+	LAB3_API void PolygonSetIsSensor( WORLD_HANDLE world, POLYGON_HANDLE handle, bool isSensor );
+
+	LAB3_API bool PolygonGetIsAwake( WORLD_HANDLE world, POLYGON_HANDLE handle );
+
+	LAB3_API bool WorldRaycast( WORLD_HANDLE world, TransportVector2 origin, TransportVector2 direction, float maxDistance, unsigned int mask, RaycastHit* hit );
+	LAB3_API int WorldRaycastBatch( WORLD_HANDLE world, const RaycastInput rays[], int count, RaycastHit hits[], int threadCount = 1 );
+
+	LAB3_API int WorldQueryAABB( WORLD_HANDLE world, TransportVector2 lower, TransportVector2 upper, unsigned int mask, POLYGON_HANDLE handles[], int capacity );
+	LAB3_API int WorldQueryPolygon( WORLD_HANDLE world, const TransportVector2 vertices[], int verticesLength, TransportVector2 position, float rotation, unsigned int mask, POLYGON_HANDLE handles[], int capacity );
 }
 
 
@@ -55,6 +116,8 @@ extern "C"
 // will have encountered GLM. Just read this functions over in main.cpp so you can follow the 
 // (really simple!) things they're doing to transform between TransformVector2 and glm::vec2.
 
+World* WorldFromHandle( WORLD_HANDLE world );
+
 TransportVector2 Vector2GLMToTransport( glm::vec2 glmVector );
 glm::vec2 Vector2TransportToGLM( TransportVector2 transportVector );
 
@@ -2,13 +2,575 @@
 //
 
 #include "stdafx.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
 #include "main.h"
 #include "glm.hpp"
+#include "Recorder.h"
 
 
-int main()
+// Walks through a recording written by WorldStartRecording(), handing out one value at a time.
+struct ReplayReader
 {
-	WorldStart( 0.02f, -9.81f );
+	const char* cursor;
+	const char* end;
+
+	bool IsAtEnd()
+	{
+		return cursor >= end;
+	}
+
+	template<typename T>
+	T Read()
+	{
+		if( cursor + sizeof( T ) > end )
+		{
+			throw std::exception( "Recording is truncated!" );
+		}
+		T value;
+		memcpy( &value, cursor, sizeof( T ) );
+		cursor += sizeof( T );
+		return value;
+	}
+
+	// Returns a pointer to length values of type T inside the recording (no copy is made).
+	template<typename T>
+	const T* ReadArray( int length )
+	{
+		if( cursor + length * sizeof( T ) > end )
+		{
+			throw std::exception( "Recording is truncated!" );
+		}
+		const T* values = (const T*)cursor;
+		cursor += length * sizeof( T );
+		return values;
+	}
+};
+
+
+// Re-drives a fresh World with every call stored in the recording at path, as fast as possible, so 
+// the exact workload of a session can be profiled offline. Returns the process exit code.
+int Replay( const char* path )
+{
+	std::ifstream file( path, std::ios::binary );
+	if( !file.is_open() )
+	{
+		printf( "Could not open recording %s\n", path );
+		return 1;
+	}
+	std::vector<char> recording( ( std::istreambuf_iterator<char>( file ) ), std::istreambuf_iterator<char>() );
+
+	ReplayReader reader;
+	reader.cursor = recording.data();
+	reader.end = recording.data() + recording.size();
+
+	RecordingHeader header = reader.Read<RecordingHeader>();
+	if( memcmp( header.magic, RECORDING_MAGIC, sizeof( RECORDING_MAGIC ) ) != 0 || header.version != RECORDING_VERSION )
+	{
+		printf( "%s is not a recording this build can replay\n", path );
+		return 1;
+	}
+
+	WORLD_HANDLE world = WorldCreate( header.fixedTimestepSeconds, header.gravityAcceleration );
+	WorldSetDeterministic( world, header.isDeterministic != 0 );
+	WorldSetSubstepCount( world, header.substepCount );
+	WorldSetMaxStepsPerUpdate( world, header.maxStepsPerUpdate );
+	// Before the restore, which only brings back sleeping Polygons and contacts with sleeping on.
+	WorldSetSleepEnabled( world, header.isSleepEnabled != 0 );
+	WorldRestore( world, reader.ReadArray<char>( header.snapshotLength ), header.snapshotLength );
+
+	// Vertices are copied out of the recording because the API takes them as non-const arrays.
+	std::vector<TransportVector2> vertices;
+	std::vector<char> snapshot;
+	std::vector<RaycastHit> hits;
+	std::vector<POLYGON_HANDLE> handles;
+	std::vector<ContactEvent> contacts;
+	std::vector<unsigned int> bits;
+	long long callCount = 0;
+	int updateCount = 0;
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+	while( !reader.IsAtEnd() )
+	{
+		RecordedCall call = (RecordedCall)reader.Read<unsigned char>();
+		switch( call )
+		{
+			case RecordedCall::WorldUpdate:
+				WorldUpdate( world, reader.Read<float>() );
+				updateCount++;
+				break;
+			case RecordedCall::WorldSetDeterministic:
+				WorldSetDeterministic( world, reader.Read<bool>() );
+				break;
+			case RecordedCall::WorldGetStateHash:
+				WorldGetStateHash( world );
+				break;
+			case RecordedCall::WorldGetSnapshotSize:
+				WorldGetSnapshotSize( world );
+				break;
+			case RecordedCall::WorldSnapshot:
+			{
+				snapshot.resize( reader.Read<int>() );
+				WorldSnapshot( world, snapshot.data(), (int)snapshot.size() );
+				break;
+			}
+			case RecordedCall::WorldRestore:
+			{
+				int length = reader.Read<int>();
+				WorldRestore( world, reader.ReadArray<char>( length ), length );
+				break;
+			}
+			case RecordedCall::PolygonCreate:
+			{
+				int length = reader.Read<int>();
+				const TransportVector2* recordedVertices = reader.ReadArray<TransportVector2>( length );
+				vertices.assign( recordedVertices, recordedVertices + length );
+				TransportVector2 position = reader.Read<TransportVector2>();
+				float rotation = reader.Read<float>();
+				float mass = reader.Read<float>();
+				bool useGravity = reader.Read<bool>();
+				bool isStatic = reader.Read<bool>();
+				PolygonCreate( world, vertices.data(), length, position, rotation, mass, useGravity, isStatic );
+				break;
+			}
+			case RecordedCall::PolygonCreateCompound:
+			{
+				int pieceCount = reader.Read<int>();
+				const int* recordedCounts = reader.ReadArray<int>( pieceCount );
+				std::vector<int> pieceVertexCounts( recordedCounts, recordedCounts + pieceCount );
+				int length = reader.Read<int>();
+				const TransportVector2* recordedVertices = reader.ReadArray<TransportVector2>( length );
+				vertices.assign( recordedVertices, recordedVertices + length );
+				TransportVector2 position = reader.Read<TransportVector2>();
+				float rotation = reader.Read<float>();
+				float mass = reader.Read<float>();
+				bool useGravity = reader.Read<bool>();
+				bool isStatic = reader.Read<bool>();
+				PolygonCreateCompound( world, vertices.data(), pieceVertexCounts.data(), pieceCount, position, rotation, mass, useGravity, isStatic );
+				break;
+			}
+			case RecordedCall::PolygonCreateCircle:
+			{
+				TransportVector2 position = reader.Read<TransportVector2>();
+				float radius = reader.Read<float>();
+				float rotation = reader.Read<float>();
+				float mass = reader.Read<float>();
+				bool useGravity = reader.Read<bool>();
+				bool isStatic = reader.Read<bool>();
+				PolygonCreateCircle( world, position, radius, rotation, mass, useGravity, isStatic );
+				break;
+			}
+			case RecordedCall::PolygonCreateBatch:
+			{
+				int offsetCount = reader.Read<int>();
+				const int* vertexOffsets = reader.ReadArray<int>( offsetCount );
+				int length = reader.Read<int>();
+				const TransportVector2* batchVertices = reader.ReadArray<TransportVector2>( length );
+				int count = reader.Read<int>();
+				const TransportVector2* positions = reader.ReadArray<TransportVector2>( count );
+				reader.Read<int>();
+				const float* rotations = reader.ReadArray<float>( count );
+				reader.Read<int>();
+				const float* masses = reader.ReadArray<float>( count );
+				reader.Read<int>();
+				const int* flags = reader.ReadArray<int>( count );
+				handles.resize( count );
+				PolygonCreateBatch( world, batchVertices, vertexOffsets, count, positions, rotations, masses, flags, handles.data(), reader.Read<int>() );
+				break;
+			}
+			case RecordedCall::PolygonCreateCapsule:
+			{
+				TransportVector2 a = reader.Read<TransportVector2>();
+				TransportVector2 b = reader.Read<TransportVector2>();
+				float radius = reader.Read<float>();
+				TransportVector2 position = reader.Read<TransportVector2>();
+				float rotation = reader.Read<float>();
+				float mass = reader.Read<float>();
+				bool useGravity = reader.Read<bool>();
+				bool isStatic = reader.Read<bool>();
+				PolygonCreateCapsule( world, a, b, radius, position, rotation, mass, useGravity, isStatic );
+				break;
+			}
+			case RecordedCall::PolygonDestroy:
+				PolygonDestroy( world, reader.Read<POLYGON_HANDLE>() );
+				break;
+			case RecordedCall::PolygonSetVertices:
+			{
+				POLYGON_HANDLE handle = reader.Read<POLYGON_HANDLE>();
+				int length = reader.Read<int>();
+				const TransportVector2* recordedVertices = reader.ReadArray<TransportVector2>( length );
+				vertices.assign( recordedVertices, recordedVertices + length );
+				PolygonSetVertices( world, handle, vertices.data(), length );
+				break;
+			}
+			case RecordedCall::PolygonGetMass:
+				PolygonGetMass( world, reader.Read<POLYGON_HANDLE>() );
+				break;
+			case RecordedCall::PolygonSetMass:
+			{
+				POLYGON_HANDLE handle = reader.Read<POLYGON_HANDLE>();
+				PolygonSetMass( world, handle, reader.Read<float>() );
+				break;
+			}
+			case RecordedCall::PolygonGetRotationalInertia:
+				PolygonGetRotationalInertia( world, reader.Read<POLYGON_HANDLE>() );
+				break;
+			case RecordedCall::PolygonGetPosition:
+				PolygonGetPosition( world, reader.Read<POLYGON_HANDLE>() );
+				break;
+			case RecordedCall::PolygonSetPosition:
+			{
+				POLYGON_HANDLE handle = reader.Read<POLYGON_HANDLE>();
+				PolygonSetPosition( world, handle, reader.Read<TransportVector2>() );
+				break;
+			}
+			case RecordedCall::PolygonTranslate:
+			{
+				POLYGON_HANDLE handle = reader.Read<POLYGON_HANDLE>();
+				PolygonTranslate( world, handle, reader.Read<TransportVector2>() );
+				break;
+			}
+			case RecordedCall::PolygonGetVelocity:
+				PolygonGetVelocity( world, reader.Read<POLYGON_HANDLE>() );
+				break;
+			case RecordedCall::PolygonSetVelocity:
+			{
+				POLYGON_HANDLE handle = reader.Read<POLYGON_HANDLE>();
+				PolygonSetVelocity( world, handle, reader.Read<TransportVector2>() );
+				break;
+			}
+			case RecordedCall::PolygonAccelerate:
+			{
+				POLYGON_HANDLE handle = reader.Read<POLYGON_HANDLE>();
+				PolygonAccelerate( world, handle, reader.Read<TransportVector2>() );
+				break;
+			}
+			case RecordedCall::PolygonGetRotation:
+				PolygonGetRotation( world, reader.Read<POLYGON_HANDLE>() );
+				break;
+			case RecordedCall::PolygonSetRotation:
+			{
+				POLYGON_HANDLE handle = reader.Read<POLYGON_HANDLE>();
+				PolygonSetRotation( world, handle, reader.Read<float>() );
+				break;
+			}
+			case RecordedCall::PolygonRotate:
+			{
+				POLYGON_HANDLE handle = reader.Read<POLYGON_HANDLE>();
+				PolygonRotate( world, handle, reader.Read<float>() );
+				break;
+			}
+			case RecordedCall::PolygonGetRotationalVelocity:
+				PolygonGetRotationalVelocity( world, reader.Read<POLYGON_HANDLE>() );
+				break;
+			case RecordedCall::PolygonSetRotationalVelocity:
+			{
+				POLYGON_HANDLE handle = reader.Read<POLYGON_HANDLE>();
+				PolygonSetRotationalVelocity( world, handle, reader.Read<float>() );
+				break;
+			}
+			case RecordedCall::PolygonAccelerateRotation:
+			{
+				POLYGON_HANDLE handle = reader.Read<POLYGON_HANDLE>();
+				PolygonAccelerateRotation( world, handle, reader.Read<float>() );
+				break;
+			}
+			case RecordedCall::IsPolygonColliding:
+				IsPolygonColliding( world, reader.Read<POLYGON_HANDLE>() );
+				break;
+			case RecordedCall::WorldGetContacts:
+			{
+				int capacity = reader.Read<int>();
+				contacts.resize( std::max( capacity, 0 ) );
+				WorldGetContacts( world, contacts.data(), capacity );
+				break;
+			}
+			case RecordedCall::WorldGetCollidingPolygons:
+			{
+				int wordCount = reader.Read<int>();
+				bits.resize( std::max( wordCount, 0 ) );
+				WorldGetCollidingPolygons( world, bits.data(), wordCount );
+				break;
+			}
+			case RecordedCall::WorldGetInterpolationAlpha:
+				WorldGetInterpolationAlpha( world );
+				break;
+			case RecordedCall::WorldGetMaxStepsPerUpdate:
+				WorldGetMaxStepsPerUpdate( world );
+				break;
+			case RecordedCall::WorldSetMaxStepsPerUpdate:
+				WorldSetMaxStepsPerUpdate( world, reader.Read<int>() );
+				break;
+			case RecordedCall::PolygonGetPreviousPosition:
+				PolygonGetPreviousPosition( world, reader.Read<POLYGON_HANDLE>() );
+				break;
+			case RecordedCall::PolygonGetPreviousRotation:
+				PolygonGetPreviousRotation( world, reader.Read<POLYGON_HANDLE>() );
+				break;
+			case RecordedCall::WorldGetAllocationCheck:
+				WorldGetAllocationCheck( world );
+				break;
+			case RecordedCall::WorldSetAllocationCheck:
+				WorldSetAllocationCheck( world, reader.Read<bool>() );
+				break;
+			case RecordedCall::WorldReserve:
+				WorldReserve( world, reader.Read<int>() );
+				break;
+			case RecordedCall::WorldGetSleepEnabled:
+				WorldGetSleepEnabled( world );
+				break;
+			case RecordedCall::WorldSetSleepEnabled:
+				WorldSetSleepEnabled( world, reader.Read<bool>() );
+				break;
+			case RecordedCall::PolygonGetCollisionCategory:
+				PolygonGetCollisionCategory( world, reader.Read<POLYGON_HANDLE>() );
+				break;
+			case RecordedCall::PolygonGetCollisionMask:
+				PolygonGetCollisionMask( world, reader.Read<POLYGON_HANDLE>() );
+				break;
+			case RecordedCall::PolygonSetCollisionFilter:
+			{
+				POLYGON_HANDLE handle = reader.Read<POLYGON_HANDLE>();
+				unsigned int category = reader.Read<unsigned int>();
+				PolygonSetCollisionFilter( world, handle, category, reader.Read<unsigned int>() );
+				break;
+			}
+			case RecordedCall::WorldRaycast:
+			{
+				TransportVector2 origin = reader.Read<TransportVector2>();
+				TransportVector2 direction = reader.Read<TransportVector2>();
+				float maxDistance = reader.Read<float>();
+				RaycastHit hit;
+				WorldRaycast( world, origin, direction, maxDistance, reader.Read<unsigned int>(), &hit );
+				break;
+			}
+			case RecordedCall::WorldRaycastBatch:
+			{
+				int count = reader.Read<int>();
+				const RaycastInput* rays = reader.ReadArray<RaycastInput>( count );
+				hits.resize( count );
+				WorldRaycastBatch( world, rays, count, hits.data(), reader.Read<int>() );
+				break;
+			}
+			case RecordedCall::WorldQueryAABB:
+			{
+				TransportVector2 lower = reader.Read<TransportVector2>();
+				TransportVector2 upper = reader.Read<TransportVector2>();
+				unsigned int mask = reader.Read<unsigned int>();
+				int capacity = reader.Read<int>();
+				handles.resize( std::max( capacity, 0 ) );
+				WorldQueryAABB( world, lower, upper, mask, handles.data(), capacity );
+				break;
+			}
+			case RecordedCall::WorldQueryPolygon:
+			{
+				int length = reader.Read<int>();
+				const TransportVector2* queryVertices = reader.ReadArray<TransportVector2>( length );
+				TransportVector2 position = reader.Read<TransportVector2>();
+				float rotation = reader.Read<float>();
+				unsigned int mask = reader.Read<unsigned int>();
+				int capacity = reader.Read<int>();
+				handles.resize( std::max( capacity, 0 ) );
+				WorldQueryPolygon( world, queryVertices, length, position, rotation, mask, handles.data(), capacity );
+				break;
+			}
+			case RecordedCall::PolygonGetIsBullet:
+				PolygonGetIsBullet( world, reader.Read<POLYGON_HANDLE>() );
+				break;
+			case RecordedCall::PolygonSetIsBullet:
+			{
+				POLYGON_HANDLE handle = reader.Read<POLYGON_HANDLE>();
+				PolygonSetIsBullet( world, handle, reader.Read<bool>() );
+				break;
+			}
+			case RecordedCall::WorldGetSubstepCount:
+				WorldGetSubstepCount( world );
+				break;
+			case RecordedCall::WorldSetSubstepCount:
+				WorldSetSubstepCount( world, reader.Read<int>() );
+				break;
+			case RecordedCall::PolygonGetIsKinematic:
+				PolygonGetIsKinematic( world, reader.Read<POLYGON_HANDLE>() );
+				break;
+			case RecordedCall::PolygonSetIsKinematic:
+			{
+				POLYGON_HANDLE handle = reader.Read<POLYGON_HANDLE>();
+				PolygonSetIsKinematic( world, handle, reader.Read<bool>() );
+				break;
+			}
+			case RecordedCall::PolygonGetIsSensor:
+				PolygonGetIsSensor( world, reader.Read<POLYGON_HANDLE>() );
+				break;
+			case RecordedCall::PolygonSetIsSensor:
+			{
+				POLYGON_HANDLE handle = reader.Read<POLYGON_HANDLE>();
+				PolygonSetIsSensor( world, handle, reader.Read<bool>() );
+				break;
+			}
+			case RecordedCall::PolygonGetIsAwake:
+				PolygonGetIsAwake( world, reader.Read<POLYGON_HANDLE>() );
+				break;
+			default:
+				printf( "Unknown call %d in recording\n", (int)call );
+				WorldDestroy( world );
+				return 1;
+		}
+		callCount++;
+	}
+	auto endTime = std::chrono::high_resolution_clock::now();
+
+	double milliseconds = std::chrono::duration<double, std::milli>( endTime - startTime ).count();
+	printf( "Replayed %lld calls (%d updates) in %.3f ms\n", callCount, updateCount, milliseconds );
+	printf( "State hash: %llx\n", WorldGetStateHash( world ) );
+	WorldDestroy( world );
+	return 0;
+}
+
+
+// Sets a box of the given half size and mass down on static ground and lets it settle for ten 
+// seconds. A box that starts out resting flat should stay flat, not tip onto a corner or start to 
+// spin. Returns whether it did.
+bool CheckRestingBox( float halfSize, float mass )
+{
+	WORLD_HANDLE world = WorldCreate( 1.0f / 60.0f, -9.81f );
+
+	TransportVector2 ground[ 4 ] = { { -100.0f, 0.5f }, { 100.0f, 0.5f }, { 100.0f, -0.5f }, { -100.0f, -0.5f } };
+	TransportVector2 box[ 4 ] = { { -halfSize, halfSize }, { halfSize, halfSize }, { halfSize, -halfSize }, { -halfSize, -halfSize } };
+	TransportVector2 groundPosition = { 0.0f, -0.5f };
+	TransportVector2 boxPosition = { 0.0f, halfSize };
+	PolygonCreate( world, ground, 4, groundPosition, 0.0f, 1000.0f, false, true );
+	POLYGON_HANDLE handle = PolygonCreate( world, box, 4, boxPosition, 0.0f, mass, true );
+
+	float maxRotationalSpeed = 0.0f;
+	for( int i = 0; i < 600; i++ )
+	{
+		WorldUpdate( world, 1.0f / 60.0f );
+		maxRotationalSpeed = std::max( maxRotationalSpeed, glm::abs( PolygonGetRotationalVelocity( world, handle ) ) );
+	}
+	float height = PolygonGetPosition( world, handle ).y;
+	float rotation = PolygonGetRotation( world, handle );
+	WorldDestroy( world );
+
+	bool isResting = glm::abs( height - halfSize ) < 0.05f * halfSize && glm::abs( rotation ) < 0.05f && maxRotationalSpeed < 0.5f;
+	printf( "%s: box of half size %g and mass %g rests at y = %.3f, rotation %.4f, fastest spin %.3f rad/s\n", isResting ? "PASS" : "FAIL", halfSize, mass, height, rotation, maxRotationalSpeed );
+	return isResting;
+}
+
+
+// Drops a box into the world, destroys the given Polygon and steps stepCount times. Used to diverge
+// from a snapshot the same way twice. Returns the state hash at the end.
+unsigned long long StepAfterSnapshot( WORLD_HANDLE world, POLYGON_HANDLE destroyed, int stepCount )
+{
+	TransportVector2 box[ 4 ] = { { -0.5f, 0.5f }, { 0.5f, 0.5f }, { 0.5f, -0.5f }, { -0.5f, -0.5f } };
+	TransportVector2 position = { 3.0f, 6.0f };
+	PolygonCreate( world, box, 4, position, 0.3f, 1.0f, true );
+	PolygonDestroy( world, destroyed );
+	for( int i = 0; i < stepCount; i++ )
+	{
+		WorldUpdate( world, 1.0f / 60.0f );
+	}
+	return WorldGetStateHash( world );
+}
+
+
+// Lets a few boxes tumble onto the ground, takes a snapshot, then adds a box, removes one and steps
+// on. Restoring the snapshot and doing the same again has to land on exactly the same state.
+bool CheckSnapshotRestore()
+{
+	WORLD_HANDLE world = WorldCreate( 1.0f / 60.0f, -9.81f );
+	WorldSetDeterministic( world, true );
+
+	TransportVector2 ground[ 4 ] = { { -100.0f, 0.5f }, { 100.0f, 0.5f }, { 100.0f, -0.5f }, { -100.0f, -0.5f } };
+	TransportVector2 box[ 4 ] = { { -0.5f, 0.5f }, { 0.5f, 0.5f }, { 0.5f, -0.5f }, { -0.5f, -0.5f } };
+	TransportVector2 groundPosition = { 0.0f, -0.5f };
+	PolygonCreate( world, ground, 4, groundPosition, 0.0f, 1000.0f, false, true );
+	POLYGON_HANDLE handles[ 4 ];
+	for( int i = 0; i < 4; i++ )
+	{
+		TransportVector2 position = { 0.4f * i, 1.0f + 1.5f * i };
+		handles[ i ] = PolygonCreate( world, box, 4, position, 0.2f * i, 1.0f, true );
+	}
+	for( int i = 0; i < 60; i++ )
+	{
+		WorldUpdate( world, 1.0f / 60.0f );
+	}
+
+	std::vector<char> snapshot( WorldGetSnapshotSize( world ) );
+	WorldSnapshot( world, snapshot.data(), static_cast<int>( snapshot.size() ) );
+	unsigned long long expectedHash = StepAfterSnapshot( world, handles[ 2 ], 120 );
+	WorldRestore( world, snapshot.data(), static_cast<int>( snapshot.size() ) );
+	unsigned long long hash = StepAfterSnapshot( world, handles[ 2 ], 120 );
+	WorldDestroy( world );
+
+	bool isMatching = hash == expectedHash;
+	printf( "%s: state hash after restoring a snapshot is %llx, expected %llx\n", isMatching ? "PASS" : "FAIL", hash, expectedHash );
+	return isMatching;
+}
+
+
+// Fires a small box at 300 m/s at a thin static wall standing at x = 5 and steps for a second. At 30
+// steps a second it moves 10 m per step, far more than the wall is thick. Returns where it ended up.
+float FireAtWall( bool isBullet )
+{
+	WORLD_HANDLE world = WorldCreate( 1.0f / 30.0f );
+
+	TransportVector2 wall[ 4 ] = { { -0.05f, 2.0f }, { 0.05f, 2.0f }, { 0.05f, -2.0f }, { -0.05f, -2.0f } };
+	TransportVector2 box[ 4 ] = { { -0.1f, 0.1f }, { 0.1f, 0.1f }, { 0.1f, -0.1f }, { -0.1f, -0.1f } };
+	TransportVector2 wallPosition = { 5.0f, 0.0f };
+	TransportVector2 boxPosition = { 0.0f, 0.3f };
+	TransportVector2 boxVelocity = { 300.0f, 0.0f };
+	PolygonCreate( world, wall, 4, wallPosition, 0.0f, 1000.0f, false, true );
+	POLYGON_HANDLE handle = PolygonCreate( world, box, 4, boxPosition );
+	PolygonSetVelocity( world, handle, boxVelocity );
+	PolygonSetIsBullet( world, handle, isBullet );
+
+	for( int i = 0; i < 30; i++ )
+	{
+		WorldUpdate( world, 1.0f / 30.0f );
+	}
+	float x = PolygonGetPosition( world, handle ).x;
+	WorldDestroy( world );
+	return x;
+}
+
+
+// A fast box that passes straight through a thin wall in one step has to stay on the near side of
+// it once it's a bullet. Without bullet mode it has to tunnel, or the check proves nothing.
+bool CheckBullet()
+{
+	float tunnelingX = FireAtWall( false );
+	float bulletX = FireAtWall( true );
+
+	bool isStopped = tunnelingX > 5.0f && bulletX < 5.0f;
+	printf( "%s: fast box ends at x = %.3f as a bullet and x = %.3f without, wall at x = 5\n", isStopped ? "PASS" : "FAIL", bulletX, tunnelingX );
+	return isStopped;
+}
+
+
+// Run "ConsoleTester --replay <recording>" to replay a recording headlessly, "ConsoleTester --check"
+// to run the resting box, snapshot and bullet checks, or with no arguments to watch two rotating
+// rectangles collide.
+int main( int argc, char* argv[] )
+{
+	if( argc == 3 && strcmp( argv[ 1 ], "--replay" ) == 0 )
+	{
+		return Replay( argv[ 2 ] );
+	}
+	if( argc == 2 && strcmp( argv[ 1 ], "--check" ) == 0 )
+	{
+		bool isPassing = CheckRestingBox( 0.5f, 1.0f );
+		isPassing = CheckRestingBox( 1.0f, 1.0f ) && isPassing;
+		isPassing = CheckRestingBox( 10.0f, 1000.0f ) && isPassing;
+		isPassing = CheckSnapshotRestore() && isPassing;
+		isPassing = CheckBullet() && isPassing;
+		return isPassing ? 0 : 1;
+	}
+
+	WORLD_HANDLE world = WorldCreate( 0.02f, -9.81f );
 
 	TransportVector2 position1;
 	position1.x = 0.0f;
@@ -38,20 +600,20 @@ int main()
 	rect2[ 3 ].x = -5.0f;
 	rect2[ 3 ].y = 1.0f;
 
-	POLYGON_HANDLE polygon1 = PolygonCreate( rect1, 4, position1, glm::radians<float>( 30.0f ) );
-	POLYGON_HANDLE polygon2 = PolygonCreate( rect2, 4, position2, 0.0f );
+	POLYGON_HANDLE polygon1 = PolygonCreate( world, rect1, 4, position1, glm::radians<float>( 30.0f ) );
+	POLYGON_HANDLE polygon2 = PolygonCreate( world, rect2, 4, position2, 0.0f );
 
 	long step = 20L;
 	float deltaTime = step / 1000.0f;
 	while( true )
 	{
-		printf( "Colliding: %d\n", IsPolygonColliding( polygon1 ) );
-		PolygonRotate( polygon1, glm::radians<float>( 90.0f ) * deltaTime );
-		PolygonRotate( polygon2, glm::radians<float>( 90.0f ) * deltaTime );
+		printf( "Colliding: %d\n", IsPolygonColliding( world, polygon1 ) );
+		PolygonRotate( world, polygon1, glm::radians<float>( 90.0f ) * deltaTime );
+		PolygonRotate( world, polygon2, glm::radians<float>( 90.0f ) * deltaTime );
 		_sleep( step );
-		WorldUpdate( deltaTime );
+		WorldUpdate( world, deltaTime );
 	}
 
-	WorldDestroy();
+	WorldDestroy( world );
 }
 
@@ -0,0 +1,26 @@
+﻿using System.Runtime.InteropServices;
+
+namespace Humber.GAME205.NativePhysics
+{
+    // Mirrors the native ContactEventState enum.
+    public enum ContactEventState
+    {
+        Begin = 0,
+        Persist = 1,
+        End = 2
+    }
+
+    // Mirrors the native ContactEvent struct. normal points from aHandle toward bHandle. Sensor overlaps
+    // and End events only fill in the handles and state.
+    [StructLayout( LayoutKind.Sequential )]
+    public struct ContactEvent
+    {
+        public int aHandle;
+        public int bHandle;
+        public TransportVector2 normal;
+        public TransportVector2 point;
+        public float depth;
+        public float impulse;
+        public ContactEventState state;
+    }
+}
@@ -21,30 +21,47 @@ public sealed class NativePhysicsWorld : MonoBehaviour
         public float FixedTimestepSeconds = 0.02f;
         [Tooltip( "Acceleration due to the force of gravity in m/s^2?" )]
         public float GravityAcceleration = -9.81f;
+        [Tooltip( "Should the native world run its steps in fixed-point math so every client produces bit-identical results?" )]
+        public bool Deterministic = false;
+        [Tooltip( "How many sub-steps should the soft contact solver split each timestep into? 0 keeps the original one-impulse solver. Ignored in deterministic mode." )]
+        public int SubstepCount = 0;
+        [Tooltip( "Most native physics steps a single update may take (0 means no limit). Time still owed past the cap is dropped so one hitch can't snowball." )]
+        public int MaxStepsPerUpdate = 0;
+        [Tooltip( "How many polygons to pre-allocate room for, so spawning and destroying up to that many at once never allocates." )]
+        public int ReservedPolygonCount = 0;
+
+        // Handle to the native World owned by this component (set on Awake() by NativePhysics.WorldCreate()).
+        IntPtr world = IntPtr.Zero;
 
         // Properties
-        public bool DoesNativeWorldExist { get; private set; }
+        public bool DoesNativeWorldExist
+        {
+            get { return world != IntPtr.Zero; }
+        }
 
         #region Unity Message Handlers
 
         void Awake()
         {
-            NativePhysics.WorldStart( FixedTimestepSeconds, GravityAcceleration );
-            DoesNativeWorldExist = true;
+            world = NativePhysics.WorldCreate( FixedTimestepSeconds, GravityAcceleration );
+            NativePhysics.WorldSetDeterministic( world, Deterministic );
+            NativePhysics.WorldSetSubstepCount( world, SubstepCount );
+            NativePhysics.WorldSetMaxStepsPerUpdate( world, MaxStepsPerUpdate );
+            NativePhysics.WorldReserve( world, ReservedPolygonCount );
         }
 
         void Update()
         {
             if ( SyncWithUnityUpdate )
             {
-                NativePhysics.WorldUpdate( UseUnscaledTime ? Time.unscaledDeltaTime : Time.deltaTime );
+                NativePhysics.WorldUpdate( world, UseUnscaledTime ? Time.unscaledDeltaTime : Time.deltaTime );
             }
         }
 
         void OnDestroy()
         {
-            NativePhysics.WorldDestroy();
-            DoesNativeWorldExist = false;
+            NativePhysics.WorldDestroy( world );
+            world = IntPtr.Zero;
         }
 
         #endregion
@@ -59,6 +76,107 @@ void ThrowExceptionIfNativeWorldDoesNotExist()
             }
         }
 
+        public bool WorldStartRecording( string path )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            return NativePhysics.WorldStartRecording( world, path );
+        }
+
+        public void WorldStopRecording()
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            NativePhysics.WorldStopRecording( world );
+        }
+
+        public ulong WorldGetStateHash()
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            return NativePhysics.WorldGetStateHash( world );
+        }
+
+        public int WorldGetSubstepCount()
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            return NativePhysics.WorldGetSubstepCount( world );
+        }
+
+        // More sub-steps keep stacks and big mass ratios stable at the cost of solver time.
+        public void WorldSetSubstepCount( int substepCount )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            NativePhysics.WorldSetSubstepCount( world, substepCount );
+        }
+
+        // How far (0 to 1) the World is into its next step, for interpolating between previous and current poses.
+        public float WorldGetInterpolationAlpha()
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            return NativePhysics.WorldGetInterpolationAlpha( world );
+        }
+
+        public int WorldGetMaxStepsPerUpdate()
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            return NativePhysics.WorldGetMaxStepsPerUpdate( world );
+        }
+
+        public void WorldSetMaxStepsPerUpdate( int maxStepsPerUpdate )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            NativePhysics.WorldSetMaxStepsPerUpdate( world, maxStepsPerUpdate );
+        }
+
+        public void WorldReserve( int capacity )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            NativePhysics.WorldReserve( world, capacity );
+        }
+
+        public bool WorldGetAllocationCheck()
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            return NativePhysics.WorldGetAllocationCheck( world );
+        }
+
+        // Debugging aid: every native step throws if it allocates. Enable it once the scene has settled.
+        // Needs a Debug build of the DLL (PHYSICS_ALLOCATION_CHECK); enabling it on a Release build throws.
+        public void WorldSetAllocationCheck( bool isEnabled )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            NativePhysics.WorldSetAllocationCheck( world, isEnabled );
+        }
+
+        public bool WorldGetSleepEnabled()
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            return NativePhysics.WorldGetSleepEnabled( world );
+        }
+
+        // Piles that have come to rest fall asleep and cost next to nothing until something touches them or a PolygonSet* call wakes them. Off by default.
+        public void WorldSetSleepEnabled( bool isEnabled )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            NativePhysics.WorldSetSleepEnabled( world, isEnabled );
+        }
+
+        public int WorldGetSnapshotSize()
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            return NativePhysics.WorldGetSnapshotSize( world );
+        }
+
+        public int WorldSnapshot( byte[] buffer )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            return NativePhysics.WorldSnapshot( world, buffer, buffer.Length );
+        }
+
+        public void WorldRestore( byte[] buffer )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            NativePhysics.WorldRestore( world, buffer, buffer.Length );
+        }
+
         public int PolygonCreate( IEnumerable<Vector2> vertices, Vector2 position, float rotation = 0f, float mass = 1f, bool useGravity = false, bool isStatic = false)
         {
             ThrowExceptionIfNativeWorldDoesNotExist();
@@ -68,12 +186,74 @@ public int PolygonCreate( IEnumerable<Vector2> vertices, Vector2 position, float
             .Select( vertex => new TransportVector2( vertex ) )
             .ToArray();
 
-            return NativePhysics.PolygonCreate( transportVertices, transportVertices.Length, new TransportVector2( position ), rotation, mass, useGravity, isStatic );
+            return NativePhysics.PolygonCreate( world, transportVertices, transportVertices.Length, new TransportVector2( position ), rotation, mass, useGravity, isStatic );
+        }
+
+        // Creates one body out of several convex pieces (each given by its own local vertices) that 
+        // share a single transform, mass and inertia, like a ship built from parts.
+        public int PolygonCreateCompound( IEnumerable<IEnumerable<Vector2>> pieces, Vector2 position, float rotation = 0f, float mass = 1f, bool useGravity = false, bool isStatic = false )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+
+            // Every piece's vertices back to back, plus how many belong to each piece.
+            var transportPieces = pieces
+                .Select( piece => piece.Select( vertex => new TransportVector2( vertex ) ).ToArray() )
+                .ToArray();
+            var transportVertices = transportPieces.SelectMany( piece => piece ).ToArray();
+            var pieceVertexCounts = transportPieces.Select( piece => piece.Length ).ToArray();
+
+            return NativePhysics.PolygonCreateCompound( world, transportVertices, pieceVertexCounts, pieceVertexCounts.Length, new TransportVector2( position ), rotation, mass, useGravity, isStatic );
+        }
+
+
+        // Creates a circle, which collides far more cheaply than a Polygon with enough vertices to 
+        // look round.
+        public int PolygonCreateCircle( Vector2 position, float radius, float rotation = 0f, float mass = 1f, bool useGravity = false, bool isStatic = false )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            return NativePhysics.PolygonCreateCircle( world, new TransportVector2( position ), radius, rotation, mass, useGravity, isStatic );
+        }
+
+        // Creates a capsule: every point within radius of the segment from a to b (in local space).
+        public int PolygonCreateCapsule( Vector2 a, Vector2 b, float radius, Vector2 position, float rotation = 0f, float mass = 1f, bool useGravity = false, bool isStatic = false )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            return NativePhysics.PolygonCreateCapsule( world, new TransportVector2( a ), new TransportVector2( b ), radius, new TransportVector2( position ), rotation, mass, useGravity, isStatic );
         }
         
+        // Creates every polygon in one native call, for loading a level. Polygon i has the local
+        // vertices in vertices[ i ], positions[ i ], rotations[ i ], masses[ i ] and flags[ i ], and its
+        // handle ends up at the same index of the returned array. Up to threadCount native threads
+        // build the shapes. If any polygon has bad vertices, none of them are created.
+        public int[] PolygonCreateBatch( IList<IEnumerable<Vector2>> vertices, Vector2[] positions, float[] rotations, float[] masses, PolygonFlags[] flags, int threadCount = 1 )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            int count = vertices.Count;
+            if( positions.Length != count || rotations.Length != count || masses.Length != count || flags.Length != count )
+            {
+                throw new ArgumentException( "Every array must have one entry per polygon!" );
+            }
+
+            // Every polygon's vertices back to back, plus where each one starts (and where the last ends).
+            var transportPolygons = vertices
+                .Select( polygon => polygon.Select( vertex => new TransportVector2( vertex ) ).ToArray() )
+                .ToArray();
+            var transportVertices = transportPolygons.SelectMany( polygon => polygon ).ToArray();
+            var vertexOffsets = new int[ count + 1 ];
+            for( int i = 0; i < count; i++ )
+            {
+                vertexOffsets[ i + 1 ] = vertexOffsets[ i ] + transportPolygons[ i ].Length;
+            }
+            var transportPositions = positions.Select( position => new TransportVector2( position ) ).ToArray();
+
+            var handles = new int[ count ];
+            NativePhysics.PolygonCreateBatch( world, transportVertices, vertexOffsets, count, transportPositions, rotations, masses, flags, handles, threadCount );
+            return handles;
+        }
+
         public void PolygonDestroy( int handle )
         {
-            NativePhysics.PolygonDestroy( handle );
+            NativePhysics.PolygonDestroy( world, handle );
         }
 
         public void PolygonSetVertices( int handle, IEnumerable<Vector2> vertices )
@@ -85,103 +265,233 @@ public void PolygonSetVertices( int handle, IEnumerable<Vector2> vertices )
                 .Select( vertex => new TransportVector2( vertex ) )
                 .ToArray();
 
-            NativePhysics.PolygonSetVertices( handle, transportVertices, transportVertices.Length );
+            NativePhysics.PolygonSetVertices( world, handle, transportVertices, transportVertices.Length );
         }
 
         public float PolygonGetMass( int handle )
         {
             ThrowExceptionIfNativeWorldDoesNotExist();
-            return NativePhysics.PolygonGetMass( handle );
+            return NativePhysics.PolygonGetMass( world, handle );
         }
 
         public void PolygonSetMass( int handle, float mass )
         {
             ThrowExceptionIfNativeWorldDoesNotExist();
-            NativePhysics.PolygonSetMass( handle, mass );
+            NativePhysics.PolygonSetMass( world, handle, mass );
         }
 
         public Vector2 PolygonGetPosition( int handle )
         {
             ThrowExceptionIfNativeWorldDoesNotExist();
-            return NativePhysics.PolygonGetPosition( handle ).ToVector2();
+            return NativePhysics.PolygonGetPosition( world, handle ).ToVector2();
+        }
+
+        public Vector2 PolygonGetPreviousPosition( int handle )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            return NativePhysics.PolygonGetPreviousPosition( world, handle ).ToVector2();
         }
         
         public void PolygonSetPosition( int handle, Vector2 position )
         {
             ThrowExceptionIfNativeWorldDoesNotExist();
-            NativePhysics.PolygonSetPosition( handle, new TransportVector2( position ) );
+            NativePhysics.PolygonSetPosition( world, handle, new TransportVector2( position ) );
         }
         
         public void PolygonTranslate( int handle, Vector2 dPosition )
         {
             ThrowExceptionIfNativeWorldDoesNotExist();
-            NativePhysics.PolygonTranslate( handle, new TransportVector2( dPosition ) );
+            NativePhysics.PolygonTranslate( world, handle, new TransportVector2( dPosition ) );
         }
 
         public Vector2 PolygonGetVelocity( int handle )
         {
             ThrowExceptionIfNativeWorldDoesNotExist();
-            return NativePhysics.PolygonGetVelocity( handle ).ToVector2();
+            return NativePhysics.PolygonGetVelocity( world, handle ).ToVector2();
         }
 
         public void PolygonSetVelocity( int handle, Vector2 velocity )
         {
             ThrowExceptionIfNativeWorldDoesNotExist();
-            NativePhysics.PolygonSetVelocity( handle, new TransportVector2( velocity ) );
+            NativePhysics.PolygonSetVelocity( world, handle, new TransportVector2( velocity ) );
         }
 
         public void PolygonAccelerate( int handle, Vector2 dVelocity )
         {
             ThrowExceptionIfNativeWorldDoesNotExist();
-            NativePhysics.PolygonAccelerate( handle, new TransportVector2( dVelocity ) );
+            NativePhysics.PolygonAccelerate( world, handle, new TransportVector2( dVelocity ) );
         }
 
         public float PolygonGetRotationalInertia( int handle )
         {
             ThrowExceptionIfNativeWorldDoesNotExist();
-            return NativePhysics.PolygonGetRotationalInertia( handle );
+            return NativePhysics.PolygonGetRotationalInertia( world, handle );
         }
 
         public float PolygonGetRotation( int handle )
         {
             ThrowExceptionIfNativeWorldDoesNotExist();
-            return NativePhysics.PolygonGetRotation( handle );
+            return NativePhysics.PolygonGetRotation( world, handle );
+        }
+
+        public float PolygonGetPreviousRotation( int handle )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            return NativePhysics.PolygonGetPreviousRotation( world, handle );
         }
         
         public void PolygonSetRotation( int handle, float rotation )
         {
             ThrowExceptionIfNativeWorldDoesNotExist();
-            NativePhysics.PolygonSetRotation( handle, rotation );
+            NativePhysics.PolygonSetRotation( world, handle, rotation );
         }
         
         public void PolygonRotate( int handle, float dRotation )
         {
             ThrowExceptionIfNativeWorldDoesNotExist();
-            NativePhysics.PolygonRotate( handle, dRotation );
+            NativePhysics.PolygonRotate( world, handle, dRotation );
         }
 
         public float PolygonGetRotationalVelocity( int handle )
         {
             ThrowExceptionIfNativeWorldDoesNotExist();
-            return NativePhysics.PolygonGetRotationalVelocity( handle );
+            return NativePhysics.PolygonGetRotationalVelocity( world, handle );
         }
 
         public void PolygonSetRotationalVelocity( int handle, float rotationalVelocity )
         {
             ThrowExceptionIfNativeWorldDoesNotExist();
-            NativePhysics.PolygonSetRotationalVelocity( handle, rotationalVelocity );
+            NativePhysics.PolygonSetRotationalVelocity( world, handle, rotationalVelocity );
         }
 
         public void PolygonAccelerateRotation( int handle, float dRotationalVelocity )
         {
             ThrowExceptionIfNativeWorldDoesNotExist();
-            NativePhysics.PolygonAccelerateRotation( handle, dRotationalVelocity );
+            NativePhysics.PolygonAccelerateRotation( world, handle, dRotationalVelocity );
         }
 
         public bool IsPolygonColliding( int handle )
         {
             ThrowExceptionIfNativeWorldDoesNotExist();
-            return NativePhysics.IsPolygonColliding( handle );
+            return NativePhysics.IsPolygonColliding( world, handle );
+        }
+
+        // Fills contacts with the contact events from the last update (begin, persist and end for every
+        // touching pair) in one call. Returns how many there are in total, which can be more than
+        // contacts.Length.
+        public int WorldGetContacts( ContactEvent[] contacts )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            return NativePhysics.WorldGetContacts( world, contacts, contacts.Length );
+        }
+
+        // IsPolygonColliding() for every polygon at once: bit ( handle % 32 ) of bits[ handle / 32 ] is set
+        // if that polygon is colliding. Returns how many words it takes to cover every handle.
+        public int WorldGetCollidingPolygons( uint[] bits )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            return NativePhysics.WorldGetCollidingPolygons( world, bits, bits.Length );
+        }
+
+        public uint PolygonGetCollisionCategory( int handle )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            return NativePhysics.PolygonGetCollisionCategory( world, handle );
+        }
+
+        public uint PolygonGetCollisionMask( int handle )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            return NativePhysics.PolygonGetCollisionMask( world, handle );
+        }
+
+        // Two polygons only collide if each one's category is in the other's mask.
+        public void PolygonSetCollisionFilter( int handle, uint category, uint mask )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            NativePhysics.PolygonSetCollisionFilter( world, handle, category, mask );
+        }
+
+        public bool PolygonGetIsBullet( int handle )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            return NativePhysics.PolygonGetIsBullet( world, handle );
+        }
+
+        // Bullets get continuous collision detection so they can't tunnel through thin polygons.
+        public void PolygonSetIsBullet( int handle, bool isBullet )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            NativePhysics.PolygonSetIsBullet( world, handle, isBullet );
+        }
+
+        public bool PolygonGetIsKinematic( int handle )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            return NativePhysics.PolygonGetIsKinematic( world, handle );
+        }
+
+        // Kinematic polygons move by their velocity and push dynamic polygons without being pushed back (platforms, doors).
+        public void PolygonSetIsKinematic( int handle, bool isKinematic )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            NativePhysics.PolygonSetIsKinematic( world, handle, isKinematic );
+        }
+
+        public bool PolygonGetIsSensor( int handle )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            return NativePhysics.PolygonGetIsSensor( world, handle );
+        }
+
+        // Sensors report overlaps through IsPolygonColliding() without ever pushing or being pushed (area triggers).
+        public void PolygonSetIsSensor( int handle, bool isSensor )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            NativePhysics.PolygonSetIsSensor( world, handle, isSensor );
+        }
+
+        public bool PolygonGetIsAwake( int handle )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            return NativePhysics.PolygonGetIsAwake( world, handle );
+        }
+
+        // Returns false if nothing in the layers in mask is within maxDistance of origin along direction.
+        public bool WorldRaycast( Vector2 origin, Vector2 direction, float maxDistance, uint mask, out RaycastHit hit )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            return NativePhysics.WorldRaycast( world, new TransportVector2( origin ), new TransportVector2( direction ), maxDistance, mask, out hit );
+        }
+
+        // Casts every ray in one native call, writing the hit for rays[ i ] into hits[ i ]. Keep rays
+        // that start together and head the same way next to each other. Returns the number of hits.
+        public int WorldRaycastBatch( RaycastInput[] rays, RaycastHit[] hits, int threadCount = 1 )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            if( hits.Length < rays.Length )
+            {
+                throw new ArgumentException( "hits must be at least as long as rays!" );
+            }
+            return NativePhysics.WorldRaycastBatch( world, rays, rays.Length, hits, threadCount );
+        }
+
+        // Fills handles with the polygons overlapping the box, in handle order. Returns how many overlap
+        // in total, which can be more than handles.Length.
+        public int WorldQueryAABB( Vector2 lower, Vector2 upper, int[] handles, uint mask = 0xFFFFFFFF )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            return NativePhysics.WorldQueryAABB( world, new TransportVector2( lower ), new TransportVector2( upper ), mask, handles, handles.Length );
+        }
+
+        // Same as WorldQueryAABB() for a convex polygon placed the way PolygonCreate() would place it.
+        public int WorldQueryPolygon( IEnumerable<Vector2> vertices, Vector2 position, float rotation, int[] handles, uint mask = 0xFFFFFFFF )
+        {
+            ThrowExceptionIfNativeWorldDoesNotExist();
+            var transportVertices = vertices
+                .Select( vertex => new TransportVector2( vertex ) )
+                .ToArray();
+            return NativePhysics.WorldQueryPolygon( world, transportVertices, transportVertices.Length, new TransportVector2( position ), rotation, mask, handles, handles.Length );
         }
 
         #endregion
@@ -193,70 +503,195 @@ static class NativePhysics
             const string DLL_NAME = "NativePhysics";
 
             [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
-            public extern static void WorldStart( float fixedTimestepSeconds, float gravityAcceleration = 0f );
+            public extern static IntPtr WorldCreate( float fixedTimestepSeconds, float gravityAcceleration = 0f );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static void WorldUpdate( IntPtr world, float deltaTimeSeconds );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static void WorldDestroy( IntPtr world );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            [return: MarshalAs( UnmanagedType.I1 )]
+            public extern static bool WorldStartRecording( IntPtr world, string path );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static void WorldStopRecording( IntPtr world );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static void WorldSetDeterministic( IntPtr world, bool isDeterministic );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static ulong WorldGetStateHash( IntPtr world );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static int WorldGetSubstepCount( IntPtr world );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static void WorldSetSubstepCount( IntPtr world, int substepCount );
 
             [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
-            public extern static void WorldUpdate( float deltaTimeSeconds );
+            public extern static float WorldGetInterpolationAlpha( IntPtr world );
 
             [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
-            public extern static void WorldDestroy();
+            public extern static int WorldGetMaxStepsPerUpdate( IntPtr world );
 
             [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
-            public static extern int PolygonCreate( TransportVector2[] vertices, int verticesLength, TransportVector2 position, float rotation = 0f, float mass = 1f, bool useGravity = false, bool isStatic = false );
+            public extern static void WorldSetMaxStepsPerUpdate( IntPtr world, int maxStepsPerUpdate );
 
             [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
-            public extern static void PolygonDestroy( int handle );
+            public extern static void WorldReserve( IntPtr world, int capacity );
 
             [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
-            public extern static void PolygonSetVertices( int handle, TransportVector2[] vertices, int length );
+            [return: MarshalAs( UnmanagedType.I1 )]
+            public extern static bool WorldGetAllocationCheck( IntPtr world );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static void WorldSetAllocationCheck( IntPtr world, bool isEnabled );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            [return: MarshalAs( UnmanagedType.I1 )]
+            public extern static bool WorldGetSleepEnabled( IntPtr world );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static void WorldSetSleepEnabled( IntPtr world, bool isEnabled );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static int WorldGetSnapshotSize( IntPtr world );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static int WorldSnapshot( IntPtr world, byte[] buffer, int bufferLength );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static void WorldRestore( IntPtr world, byte[] buffer, int bufferLength );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public static extern int PolygonCreate( IntPtr world, TransportVector2[] vertices, int verticesLength, TransportVector2 position, float rotation = 0f, float mass = 1f, bool useGravity = false, bool isStatic = false );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public static extern int PolygonCreateCompound( IntPtr world, TransportVector2[] vertices, int[] pieceVertexCounts, int pieceCount, TransportVector2 position, float rotation = 0f, float mass = 1f, bool useGravity = false, bool isStatic = false );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public static extern int PolygonCreateCircle( IntPtr world, TransportVector2 position, float radius, float rotation = 0f, float mass = 1f, bool useGravity = false, bool isStatic = false );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public static extern int PolygonCreateCapsule( IntPtr world, TransportVector2 a, TransportVector2 b, float radius, TransportVector2 position, float rotation = 0f, float mass = 1f, bool useGravity = false, bool isStatic = false );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static void PolygonCreateBatch( IntPtr world, TransportVector2[] vertices, int[] vertexOffsets, int count, TransportVector2[] positions, float[] rotations, float[] masses, PolygonFlags[] flags, [Out] int[] handles, int threadCount );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static void PolygonDestroy( IntPtr world, int handle );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static void PolygonSetVertices( IntPtr world, int handle, TransportVector2[] vertices, int length );
             
             [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
-            public extern static float PolygonGetMass( int handle );
+            public extern static float PolygonGetMass( IntPtr world, int handle );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static void PolygonSetMass( IntPtr world, int handle, float mass );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static TransportVector2 PolygonGetPosition( IntPtr world, int handle );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static TransportVector2 PolygonGetPreviousPosition( IntPtr world, int handle );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static void PolygonSetPosition( IntPtr world, int handle, TransportVector2 position );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static void PolygonTranslate( IntPtr world, int handle, TransportVector2 dPosition );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static TransportVector2 PolygonGetVelocity( IntPtr world, int handle );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static void PolygonSetVelocity( IntPtr world, int handle, TransportVector2 velocity );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static void PolygonAccelerate( IntPtr world, int handle, TransportVector2 dVelocity );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static float PolygonGetRotationalInertia( IntPtr world, int handle );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static float PolygonGetRotation( IntPtr world, int handle );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static float PolygonGetPreviousRotation( IntPtr world, int handle );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static void PolygonSetRotation( IntPtr world, int handle, float rotation );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static void PolygonRotate( IntPtr world, int handle, float dRotation );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static float PolygonGetRotationalVelocity( IntPtr world, int handle );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static void PolygonSetRotationalVelocity( IntPtr world, int handle, float rotationalVelocity );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static void PolygonAccelerateRotation( IntPtr world, int handle, float dRotationalVelocity );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static bool IsPolygonColliding( IntPtr world, int handle );
+
+            [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
+            public extern static int WorldGetContacts( IntPtr world, [Out] ContactEvent[] contacts, int capacity );
 
             [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
-            public extern static void PolygonSetMass( int handle, float mass );
+            public extern static int WorldGetCollidingPolygons( IntPtr world, [Out] uint[] bits, int wordCount );
 
             [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
-            public extern static TransportVector2 PolygonGetPosition( int handle );
+            public extern static uint PolygonGetCollisionCategory( IntPtr world, int handle );
 
             [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
-            public extern static void PolygonSetPosition( int handle, TransportVector2 position );
+            public extern static uint PolygonGetCollisionMask( IntPtr world, int handle );
 
             [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
-            public extern static void PolygonTranslate( int handle, TransportVector2 dPosition );
+            public extern static void PolygonSetCollisionFilter( IntPtr world, int handle, uint category, uint mask );
 
             [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
-            public extern static TransportVector2 PolygonGetVelocity( int handle );
+            [return: MarshalAs( UnmanagedType.I1 )]
+            public extern static bool PolygonGetIsBullet( IntPtr world, int handle );
 
             [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
-            public extern static void PolygonSetVelocity( int handle, TransportVector2 velocity );
+            public extern static void PolygonSetIsBullet( IntPtr world, int handle, bool isBullet );
 
             [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
-            public extern static void PolygonAccelerate( int handle, TransportVector2 dVelocity );
+            [return: MarshalAs( UnmanagedType.I1 )]
+            public extern static bool PolygonGetIsKinematic( IntPtr world, int handle );
 
             [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
-            public extern static float PolygonGetRotationalInertia( int handle );
+            public extern static void PolygonSetIsKinematic( IntPtr world, int handle, bool isKinematic );
 
             [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
-            public extern static float PolygonGetRotation( int handle );
+            [return: MarshalAs( UnmanagedType.I1 )]
+            public extern static bool PolygonGetIsSensor( IntPtr world, int handle );
 
             [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
-            public extern static void PolygonSetRotation( int handle, float rotation );
+            public extern static void PolygonSetIsSensor( IntPtr world, int handle, bool isSensor );
 
             [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
-            public extern static void PolygonRotate( int handle, float dRotation );
+            [return: MarshalAs( UnmanagedType.I1 )]
+            public extern static bool PolygonGetIsAwake( IntPtr world, int handle );
 
             [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
-            public extern static float PolygonGetRotationalVelocity( int handle );
+            [return: MarshalAs( UnmanagedType.I1 )]
+            public extern static bool WorldRaycast( IntPtr world, TransportVector2 origin, TransportVector2 direction, float maxDistance, uint mask, out RaycastHit hit );
 
             [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
-            public extern static void PolygonSetRotationalVelocity( int handle, float rotationalVelocity );
+            public extern static int WorldRaycastBatch( IntPtr world, RaycastInput[] rays, int count, [Out] RaycastHit[] hits, int threadCount );
 
             [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
-            public extern static void PolygonAccelerateRotation( int handle, float dRotationalVelocity );
+            public extern static int WorldQueryAABB( IntPtr world, TransportVector2 lower, TransportVector2 upper, uint mask, [Out] int[] handles, int capacity );
 
             [DllImport( DLL_NAME, CallingConvention = CallingConvention.Cdecl )]
-            public extern static bool IsPolygonColliding( int handle );
+            public extern static int WorldQueryPolygon( IntPtr world, TransportVector2[] vertices, int verticesLength, TransportVector2 position, float rotation, uint mask, [Out] int[] handles, int capacity );
         }
 
         #endregion
@@ -0,0 +1,16 @@
+﻿using System;
+
+namespace Humber.GAME205.NativePhysics
+{
+    // Mirrors the native PolygonFlags enum, one set per polygon passed to PolygonCreateBatch().
+    [Flags]
+    public enum PolygonFlags
+    {
+        None = 0,
+        UseGravity = 1,
+        IsStatic = 2,
+        IsKinematic = 4,
+        IsSensor = 8,
+        IsBullet = 16
+    }
+}
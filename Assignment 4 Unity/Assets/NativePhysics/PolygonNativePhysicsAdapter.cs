@@ -18,6 +18,9 @@ public class PolygonNativePhysicsAdapter : MonoBehaviour
         public float initialRotationalVelocity;
         public Vector2 initialVelocity;
 
+        [Tooltip( "Draw between the last two physics steps instead of snapping to the latest one." )]
+        public bool interpolate = false;
+
         #region Computed Properties
         public int Handle
         {
@@ -149,8 +152,16 @@ void Update()
         {
             // Update our position and rotation based on any changes that the native physics engine 
             // has made during its physics steps.
-            Polygon.transform.localPosition = World.PolygonGetPosition( handle );
-            Polygon.transform.localRotation = Quaternion.Euler( 0f, 0f, Mathf.Rad2Deg * World.PolygonGetRotation( handle ) );
+            Vector2 position = World.PolygonGetPosition( handle );
+            float rotation = World.PolygonGetRotation( handle );
+            if ( interpolate )
+            {
+                float alpha = World.WorldGetInterpolationAlpha();
+                position = Vector2.Lerp( World.PolygonGetPreviousPosition( handle ), position, alpha );
+                rotation = Mathf.Lerp( World.PolygonGetPreviousRotation( handle ), rotation, alpha );
+            }
+            Polygon.transform.localPosition = position;
+            Polygon.transform.localRotation = Quaternion.Euler( 0f, 0f, Mathf.Rad2Deg * rotation );
             if (World.IsPolygonColliding(handle))
             {
                 Debug.Log(name + " is colliding");
@@ -0,0 +1,14 @@
+﻿using System.Runtime.InteropServices;
+
+namespace Humber.GAME205.NativePhysics
+{
+    // Mirrors the native RaycastHit struct. handle is 0 when the ray didn't hit anything.
+    [StructLayout( LayoutKind.Sequential )]
+    public struct RaycastHit
+    {
+        public int handle;
+        public TransportVector2 point;
+        public TransportVector2 normal;
+        public float fraction;
+    }
+}
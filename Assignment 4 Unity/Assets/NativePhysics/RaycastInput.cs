@@ -0,0 +1,23 @@
+﻿using UnityEngine;
+using System.Runtime.InteropServices;
+
+namespace Humber.GAME205.NativePhysics
+{
+    // Mirrors the native RaycastInput struct: one ray for NativePhysicsWorld.WorldRaycastBatch().
+    [StructLayout( LayoutKind.Sequential )]
+    public struct RaycastInput
+    {
+        public TransportVector2 origin;
+        public TransportVector2 direction;
+        public float maxDistance;
+        public uint mask;
+
+        public RaycastInput( Vector2 origin, Vector2 direction, float maxDistance, uint mask = 0xFFFFFFFF )
+        {
+            this.origin = new TransportVector2( origin );
+            this.direction = new TransportVector2( direction );
+            this.maxDistance = maxDistance;
+            this.mask = mask;
+        }
+    }
+}